@@ -0,0 +1,1057 @@
+// Email: origoldbsc@gmail.com
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include "tree.hpp"
+#include "node.hpp"
+#include "tree_index.hpp"
+#include "lca.hpp"
+#include "heavy_light.hpp"
+#include "diff.hpp"
+#include "compact_tree.hpp"
+#include "serialization.hpp"
+#include "frozen_tree.hpp"
+#include "persistent_tree.hpp"
+#include "paged_tree.hpp"
+#include "lazy_tree.hpp"
+#include "text_parser.hpp"
+#include "succinct_tree.hpp"
+#include "tree_journal.hpp"
+
+using namespace ori;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+/**
+ * @brief Measures the wall-clock time of a callable in milliseconds.
+ * @param work The work to measure.
+ * @return Elapsed time in milliseconds.
+ */
+template <typename Work>
+double measure_ms(Work work)
+{
+    auto start = std::chrono::steady_clock::now();
+    work();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+/**
+ * @brief Prints one result row of a benchmark table.
+ */
+void report(const string& name, double ms, size_t operations)
+{
+    cout << "  " << std::left << std::setw(36) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1) << ms << " ms";
+    if (operations > 0)
+    {
+        cout << std::setw(12) << std::setprecision(1) << (ms * 1e6 / static_cast<double>(operations)) << " ns/op";
+    }
+    cout << endl;
+}
+
+/**
+ * @brief Builds a random tree: every new node is attached to a randomly chosen earlier node that still has room.
+ * @param tree The tree to fill.
+ * @param count Number of nodes to create.
+ * @param rng Random generator.
+ * @param window When non-zero, parents are chosen among the last `window` nodes only, which produces deep trees.
+ * @return The nodes in insertion order.
+ */
+template <int k>
+vector<Node<int>*> build_random_tree(Tree<int, k>& tree, size_t count, std::mt19937_64& rng, size_t window = 0)
+{
+    vector<Node<int>*> nodes;
+    nodes.reserve(count);
+    nodes.push_back(new Node<int>(0));
+    tree.add_root(nodes[0]);
+    for (size_t i = 1; i < count; ++i)
+    {
+        Node<int>* child = new Node<int>(static_cast<int>(rng() % 1000000));
+        while (true)
+        {
+            size_t span = (window == 0 || window > nodes.size()) ? nodes.size() : window;
+            Node<int>* parent = nodes[nodes.size() - 1 - rng() % span];
+            if (parent->get_children().size() < k)
+            {
+                tree.add_sub_node(parent, child);
+                break;
+            }
+        }
+        nodes.push_back(child);
+    }
+    return nodes;
+}
+
+/**
+ * @brief Compares the three lowest-common-ancestor engines on a random 1M-node tree.
+ */
+void bench_lca()
+{
+    const size_t nodeCount = 1000000;
+    const size_t queryCount = 1000000;
+    std::mt19937_64 rng(26);
+
+    cout << "LCA on a random 4-ary tree with " << nodeCount << " nodes, " << queryCount << " queries" << endl;
+
+    Tree<int, 4> tree;
+    vector<Node<int>*> nodes = build_random_tree(tree, nodeCount, rng);
+
+    vector<std::pair<const Node<int>*, const Node<int>*>> queries(queryCount);
+    for (auto& query : queries)
+    {
+        query = {nodes[rng() % nodeCount], nodes[rng() % nodeCount]};
+    }
+
+    TreeIndex<int>* index = nullptr;
+    report("TreeIndex build", measure_ms([&] { index = new TreeIndex<int>(tree); }), 0);
+
+    // Positions are resolved once, so the query loops measure the engines and not the node lookup
+    vector<std::pair<size_t, size_t>> positions(queryCount);
+    for (size_t q = 0; q < queryCount; ++q)
+    {
+        positions[q] = {index->entry(queries[q].first), index->entry(queries[q].second)};
+    }
+
+    size_t checksum = 0;
+    BinaryLiftingLCA<int>* lifting = nullptr;
+    report("binary lifting build", measure_ms([&] { lifting = new BinaryLiftingLCA<int>(*index); }), 0);
+    report("binary lifting queries", measure_ms([&] {
+        for (const auto& p : positions) checksum += lifting->query_at(p.first, p.second);
+    }), queryCount);
+
+    SparseTableLCA<int>* sparse = nullptr;
+    report("euler + sparse table build", measure_ms([&] { sparse = new SparseTableLCA<int>(*index); }), 0);
+    report("euler + sparse table queries", measure_ms([&] {
+        for (const auto& p : positions) checksum -= sparse->query_at(p.first, p.second);
+    }), queryCount);
+
+    vector<Node<int>*> answers;
+    report("tarjan offline batch", measure_ms([&] { answers = tarjan_lca(*index, queries); }), queryCount);
+
+    // The first two engines cancel each other out in the checksum when they agree
+    cout << "  engines agree: " << (checksum == 0 && answers[0] == lifting->query(queries[0].first, queries[0].second) ? "yes" : "no") << endl;
+
+    delete sparse;
+    delete lifting;
+    delete index;
+}
+
+/**
+ * @brief Measures heavy-light path queries and point updates against walking the path node by node.
+ * @param title Description of the tree shape.
+ * @param window Parent window passed to build_random_tree (0 for uniform, small for deep trees).
+ */
+void bench_hld_on(const string& title, size_t window)
+{
+    const size_t nodeCount = 1000000;
+    const size_t queryCount = 200000;
+    std::mt19937_64 rng(29);
+
+    Tree<int, 3> tree;
+    vector<Node<int>*> nodes = build_random_tree(tree, nodeCount, rng, window);
+    TreeIndex<int> index(tree);
+
+    size_t maxDepth = 0;
+    for (size_t v = 0; v < index.size(); ++v) maxDepth = std::max(maxDepth, index.depth_at(v));
+    cout << "HLD on a " << title << " 3-ary tree with " << nodeCount << " nodes (depth " << maxDepth << "), " << queryCount << " queries" << endl;
+
+    vector<std::pair<size_t, size_t>> paths(queryCount);
+    for (auto& path : paths)
+    {
+        path = {rng() % nodeCount, rng() % nodeCount};
+    }
+
+    HeavyLightDecomposition<int>* sums = nullptr;
+    HeavyLightDecomposition<int, MaxCombine<int>>* maxima = nullptr;
+    report("decomposition build (sum)", measure_ms([&] { sums = new HeavyLightDecomposition<int>(index); }), 0);
+    report("decomposition build (max)", measure_ms([&] { maxima = new HeavyLightDecomposition<int, MaxCombine<int>>(index, MaxCombine<int>()); }), 0);
+
+    long long checksum = 0;
+    report("path sum queries", measure_ms([&] {
+        for (const auto& p : paths) checksum += sums->query_at(p.first, p.second);
+    }), queryCount);
+    report("path max queries", measure_ms([&] {
+        for (const auto& p : paths) checksum += maxima->query_at(p.first, p.second);
+    }), queryCount);
+    report("point updates", measure_ms([&] {
+        for (const auto& p : paths) sums->add(index.at(p.first), 1);
+    }), queryCount);
+
+    // Baseline: climb both endpoints to their common ancestor one parent at a time
+    SparseTableLCA<int> lca(index);
+    size_t naiveCount = queryCount / 100;
+    report("naive path walk (1% of queries)", measure_ms([&] {
+        for (size_t q = 0; q < naiveCount; ++q)
+        {
+            size_t meet = lca.query_at(paths[q].first, paths[q].second);
+            for (size_t v = paths[q].first; v != meet; v = index.parent_at(v)) checksum += index.at(v)->get_value();
+            for (size_t v = paths[q].second; v != meet; v = index.parent_at(v)) checksum += index.at(v)->get_value();
+        }
+    }), naiveCount);
+    cout << "  checksum: " << checksum << endl;
+
+    delete maxima;
+    delete sums;
+}
+
+/**
+ * @brief Heavy-light decomposition benchmark harness, on a shallow and on a deep tree.
+ */
+void bench_hld()
+{
+    bench_hld_on("random", 0);
+    bench_hld_on("deep", 8);
+}
+
+/**
+ * @brief Builds a complete k-ary tree whose values are the pre-order numbers, so each subtree covers a contiguous value range.
+ * @param tree The tree owning the nodes.
+ * @param parent The node to attach to (nullptr for the root).
+ * @param levels Number of levels still to create below (and including) the new node.
+ * @param next The next value to assign.
+ */
+template <int k>
+void build_clustered_tree(Tree<double, k>& tree, Node<double>* parent, int levels, double& next)
+{
+    Node<double>* node = new Node<double>(next);
+    next += 1.0;
+    if (parent) tree.add_sub_node(parent, node);
+    else tree.add_root(node);
+    for (int c = 0; levels > 1 && c < k; ++c)
+    {
+        build_clustered_tree(tree, node, levels - 1, next);
+    }
+}
+
+/**
+ * @brief Compares predicate searches with and without zone maps on a numeric 5-ary tree.
+ */
+void bench_zone_maps()
+{
+    Tree<double, 5> tree;
+    double count = 0.0;
+    build_clustered_tree(tree, nullptr, 9, count);
+    cout << "Zone maps on a 5-ary tree with " << static_cast<size_t>(count) << " nodes, value-clustered subtrees" << endl;
+
+    const int repeats = 20;
+    size_t found = 0;
+    report("find_greater, full scan", measure_ms([&] {
+        for (int r = 0; r < repeats; ++r) found += tree.find_greater(count - 100.0 - r).size();
+    }), repeats);
+    report("find_range, full scan", measure_ms([&] {
+        for (int r = 0; r < repeats; ++r) found += tree.find_range(count / 2 + r, count / 2 + r + 50.0).size();
+    }), repeats);
+
+    report("enable_zone_maps", measure_ms([&] { tree.enable_zone_maps(); }), 0);
+    report("find_greater, pruned", measure_ms([&] {
+        for (int r = 0; r < repeats; ++r) found -= tree.find_greater(count - 100.0 - r).size();
+    }), repeats);
+    report("find_range, pruned", measure_ms([&] {
+        for (int r = 0; r < repeats; ++r) found -= tree.find_range(count / 2 + r, count / 2 + r + 50.0).size();
+    }), repeats);
+    cout << "  results agree: " << (found == 0 ? "yes" : "no") << endl;
+}
+
+/**
+ * @brief Compares subtree containment queries with and without Bloom filters on a string tree.
+ */
+void bench_bloom_filters()
+{
+    const size_t nodeCount = 200000;
+    const size_t queryCount = 2000;
+    std::mt19937_64 rng(33);
+
+    Tree<string, 4> tree;
+    vector<Node<string>*> nodes;
+    nodes.push_back(new Node<string>("key-0"));
+    tree.add_root(nodes[0]);
+    for (size_t i = 1; i < nodeCount; ++i)
+    {
+        nodes.push_back(new Node<string>("key-" + std::to_string(i)));
+        tree.add_sub_node(nodes[(i - 1) / 4], nodes.back());
+    }
+    cout << "Bloom filters on a 4-ary string tree with " << nodeCount << " nodes, " << queryCount << " subtree queries" << endl;
+
+    // Half of the queries look for values that are present elsewhere in the tree, half for absent values
+    vector<std::pair<Node<string>*, string>> queries(queryCount);
+    for (size_t q = 0; q < queryCount; ++q)
+    {
+        queries[q] = {nodes[rng() % 1000], q % 2 ? "key-" + std::to_string(rng() % nodeCount) : "missing-" + std::to_string(q)};
+    }
+
+    size_t hits = 0;
+    report("subtree_contains, full walk", measure_ms([&] {
+        for (auto& q : queries) hits += tree.subtree_contains(q.first, q.second);
+    }), queryCount);
+    report("enable_bloom_filters(1024, 4)", measure_ms([&] { tree.enable_bloom_filters(1024, 4); }), 0);
+    report("subtree_contains, pruned", measure_ms([&] {
+        for (auto& q : queries) hits -= tree.subtree_contains(q.first, q.second);
+    }), queryCount);
+    cout << "  results agree: " << (hits == 0 ? "yes" : "no") << endl;
+}
+
+/**
+ * @brief Diffs two random trees that differ in 0.1% of their nodes, with and without Merkle pruning, and patches one into the other.
+ */
+void bench_diff()
+{
+    const size_t nodeCount = 500000;
+    const size_t editCount = nodeCount / 1000;
+    std::mt19937_64 rngFrom(44);
+    std::mt19937_64 rngTo(44);
+
+    Tree<int, 3> from;
+    Tree<int, 3> to;
+    build_random_tree(from, nodeCount, rngFrom);
+    vector<Node<int>*> nodes = build_random_tree(to, nodeCount, rngTo);
+    cout << "Tree diff on random 3-ary trees with " << nodeCount << " nodes, " << editCount << " of them differing" << endl;
+
+    // Mostly value changes, plus a few new leaves and removed leaves
+    std::mt19937_64 rng(45);
+    for (size_t e = 0; e < editCount; ++e)
+    {
+        Node<int>* node = nodes[rng() % nodeCount];
+        if (e % 10 == 0 && node->get_children().size() < 3)
+        {
+            to.add_sub_node(node, new Node<int>(-1));
+        }
+        else if (e % 10 == 1 && !node->get_children().empty() && node->get_children().back()->get_children().empty())
+        {
+            to.remove_sub_node(node, node->get_children().size() - 1);
+        }
+        else
+        {
+            to.set_value(node, -2);
+        }
+    }
+
+    EditScript<int> script;
+    report("diff_trees, full walk", measure_ms([&] { script = diff_trees(from, to); }), nodeCount);
+    size_t fullEdits = script.size();
+    report("enable_merkle_hashing (both trees)", measure_ms([&] { from.enable_merkle_hashing(); to.enable_merkle_hashing(); }), 0);
+    report("diff_trees, Merkle-pruned", measure_ms([&] { script = diff_trees(from, to); }), editCount);
+    report("apply_patch", measure_ms([&] { apply_patch(from, script); }), script.size());
+    cout << "  edits: " << script.size() << ", scripts agree: " << (script.size() == fullEdits ? "yes" : "no")
+         << ", patched tree equal: " << (from.root_hash() == to.root_hash() ? "yes" : "no") << endl;
+}
+
+/**
+ * @brief Compacts a complete binary tree with values from a small alphabet, where most low subtrees repeat, and compares traversals.
+ */
+void bench_compact()
+{
+    const int depth = 20;
+    std::mt19937_64 rng(55);
+
+    Tree<int, 2> tree;
+    vector<Node<int>*> level{new Node<int>(0)};
+    tree.add_root(level[0]);
+    for (int d = 1; d < depth; ++d)
+    {
+        vector<Node<int>*> next;
+        for (Node<int>* parent : level)
+        {
+            for (int c = 0; c < 2; ++c)
+            {
+                next.push_back(new Node<int>(static_cast<int>(rng() % 3)));
+                tree.add_sub_node(parent, next.back());
+            }
+        }
+        level.swap(next);
+    }
+    size_t nodeCount = (size_t(1) << depth) - 1;
+    cout << "Hash-consing a complete binary tree with " << nodeCount << " nodes and values in {0, 1, 2}" << endl;
+
+    std::unique_ptr<CompactTree<int, 2>> compact;
+    report("build CompactTree", measure_ms([&] { compact = std::make_unique<CompactTree<int, 2>>(tree); }), nodeCount);
+
+    long long sum = 0;
+    report("pre-order walk, tree", measure_ms([&] {
+        for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it) sum += it->get_value();
+    }), nodeCount);
+    report("pre-order walk, compact", measure_ms([&] {
+        for (auto it = compact->begin_pre_order(); it != compact->end_pre_order(); ++it) sum -= it->get_value();
+    }), nodeCount);
+    cout << "  stored nodes: " << compact->unique_size() << " of " << compact->size()
+         << " (" << std::setprecision(1) << static_cast<double>(compact->size()) / static_cast<double>(compact->unique_size()) << "x fewer)"
+         << ", walks agree: " << (sum == 0 ? "yes" : "no") << endl;
+}
+
+/**
+ * @brief Compares node-by-node construction with the bulk builders on the same 1M-node trees.
+ */
+void bench_bulk_build()
+{
+    const size_t nodeCount = 1000000;
+    std::mt19937_64 rng(66);
+
+    // A random parent array where every node's parent comes earlier and has room
+    vector<int> values(nodeCount);
+    vector<size_t> parents(nodeCount, Tree<int, 3>::NO_PARENT);
+    vector<size_t> childCount(nodeCount, 0);
+    for (size_t i = 0; i < nodeCount; ++i)
+    {
+        values[i] = static_cast<int>(rng() % 1000000);
+        while (i > 0)
+        {
+            size_t p = rng() % i;
+            if (childCount[p] < 3)
+            {
+                parents[i] = p;
+                ++childCount[p];
+                break;
+            }
+        }
+    }
+    cout << "Building 3-ary trees with " << nodeCount << " nodes" << endl;
+
+    // Bulk builds run first: freeing a million small nodes leaves the allocator in a state that slows the next large allocation
+    std::unique_ptr<Tree<int, 3>> tree;
+    report("build_from_parents", measure_ms([&] { tree = std::make_unique<Tree<int, 3>>(values, parents); }), nodeCount);
+    report("  destroy", measure_ms([&] { tree.reset(); }), nodeCount);
+    report("build_from_level_order", measure_ms([&] { tree = std::make_unique<Tree<int, 3>>(values); }), nodeCount);
+    report("  destroy", measure_ms([&] { tree.reset(); }), nodeCount);
+
+    report("parent array, node by node", measure_ms([&] {
+        tree = std::make_unique<Tree<int, 3>>();
+        vector<Node<int>*> nodes(nodeCount);
+        for (size_t i = 0; i < nodeCount; ++i) nodes[i] = new Node<int>(values[i]);
+        tree->add_root(nodes[0]);
+        for (size_t i = 1; i < nodeCount; ++i) tree->add_sub_node(nodes[parents[i]], nodes[i]);
+    }), nodeCount);
+    report("  destroy", measure_ms([&] { tree.reset(); }), nodeCount);
+    report("level order, node by node", measure_ms([&] {
+        tree = std::make_unique<Tree<int, 3>>();
+        vector<Node<int>*> nodes(nodeCount);
+        for (size_t i = 0; i < nodeCount; ++i) nodes[i] = new Node<int>(values[i]);
+        tree->add_root(nodes[0]);
+        for (size_t i = 1; i < nodeCount; ++i) tree->add_sub_node(nodes[(i - 1) / 3], nodes[i]);
+    }), nodeCount);
+    report("  destroy", measure_ms([&] { tree.reset(); }), nodeCount);
+}
+
+/**
+ * @brief Builds balanced binary trees from a sorted array on one thread and on all hardware threads.
+ */
+void bench_build_balanced()
+{
+    const size_t count = 20000000;
+    vector<int> sorted(count);
+    for (size_t i = 0; i < count; ++i) sorted[i] = static_cast<int>(i);
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    cout << "build_balanced on a sorted array of " << count << " ints" << endl;
+
+    std::unique_ptr<Tree<int, 2>> tree = std::make_unique<Tree<int, 2>>();
+    report("1 thread", measure_ms([&] { tree->build_balanced(sorted, 1); }), count);
+    tree = std::make_unique<Tree<int, 2>>();
+    report(std::to_string(threads) + " threads", measure_ms([&] { tree->build_balanced(sorted, threads); }), count);
+}
+
+/**
+ * @brief Writes and reads back random int and string trees in the binary format through a temporary file.
+ */
+void bench_serialization()
+{
+    const size_t nodeCount = 1000000;
+    std::mt19937_64 rng(77);
+    Tree<int, 3> ints;
+    build_random_tree(ints, nodeCount, rng);
+    vector<string> words(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) words[i] = "value-" + std::to_string(rng() % 100000);
+    Tree<string, 3> strings(words);
+    cout << "Binary serialization of trees with " << nodeCount << " nodes through a temporary file" << endl;
+
+    auto roundTrip = [&](const string& name, auto& tree, auto& copy) {
+        std::FILE* file = std::tmpfile();
+        uint64_t bytes = 0;
+        report(name + " write", measure_ms([&] {
+            BinaryWriter out(file);
+            write_tree(tree, out);
+            bytes = out.bytes_written();
+        }), nodeCount);
+        std::rewind(file);
+        report(name + " read", measure_ms([&] { read_tree(copy, file); }), nodeCount);
+        std::fclose(file);
+        cout << "  " << name << ": " << bytes / 1024 << " KiB, "
+             << std::setprecision(2) << static_cast<double>(bytes) / static_cast<double>(nodeCount) << " bytes per node" << endl;
+    };
+    Tree<int, 3> intCopy;
+    Tree<string, 3> stringCopy;
+    roundTrip("int tree", ints, intCopy);
+    roundTrip("string tree", strings, stringCopy);
+}
+
+/**
+ * @brief Compares loading a tree with read_tree against mapping the same frozen file with FrozenTree.
+ */
+void bench_frozen()
+{
+    const size_t nodeCount = 5000000;
+    std::mt19937_64 rng(88);
+    vector<int> values(nodeCount);
+    for (int& value : values) value = static_cast<int>(rng() % 1000000);
+    string path = "/tmp/bench_frozen_tree.bin";
+    {
+        Tree<int, 4> tree(values);
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        write_frozen_tree(tree, file);
+        std::fclose(file);
+    }
+    cout << "Loading a frozen 4-ary tree with " << nodeCount << " nodes" << endl;
+
+    long long sum = 0;
+    Tree<int, 4> loaded;
+    report("read_tree (parse and allocate)", measure_ms([&] {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        read_tree(loaded, file);
+        std::fclose(file);
+    }), nodeCount);
+    report("BFS over the loaded tree", measure_ms([&] {
+        for (auto it = loaded.begin_bfs_scan(); it != loaded.end_bfs_scan(); ++it) sum += it->get_value();
+    }), nodeCount);
+
+    std::unique_ptr<FrozenTree<int>> frozen;
+    report("FrozenTree open (mmap)", measure_ms([&] { frozen = std::make_unique<FrozenTree<int>>(path); }), 0);
+    report("BFS over the mapped file", measure_ms([&] {
+        for (auto it = frozen->begin_bfs_scan(); it != frozen->end_bfs_scan(); ++it) sum -= it->get_value();
+    }), nodeCount);
+    report("DFS over the mapped file", measure_ms([&] {
+        for (auto it = frozen->begin_dfs_scan(); it != frozen->end_dfs_scan(); ++it) sum += it->get_value();
+    }), nodeCount);
+    report("DFS over the loaded tree", measure_ms([&] {
+        for (auto it = loaded.begin_dfs_scan(); it != loaded.end_dfs_scan(); ++it) sum -= it->get_value();
+    }), nodeCount);
+    cout << "  walks agree: " << (sum == 0 ? "yes" : "no") << endl;
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Measures building a tree straight into a memory-mapped file against building a heap Tree,
+ * then the cost of a checkpoint and of reopening the file.
+ */
+void bench_persistent()
+{
+    const size_t nodeCount = 2000000;
+    string path = "/tmp/bench_persistent_tree.bin";
+    std::remove(path.c_str());
+    cout << "Building a 4-ary tree with " << nodeCount << " nodes level by level" << endl;
+
+    report("Tree add_sub_node (heap nodes)", measure_ms([&] {
+        Tree<int, 4> tree;
+        Node<int>* root = new Node<int>(0);
+        tree.add_root(root);
+        vector<Node<int>*> level{root};
+        size_t count = 1;
+        for (size_t head = 0; count < nodeCount; ++head)
+        {
+            for (int i = 0; i < 4 && count < nodeCount; ++i, ++count)
+            {
+                Node<int>* child = new Node<int>(static_cast<int>(count));
+                tree.add_sub_node(level[head], child);
+                level.push_back(child);
+            }
+        }
+    }), nodeCount);
+
+    long long sum = 0;
+    {
+        std::unique_ptr<PersistentTree<int, 4>> tree;
+        report("PersistentTree add_sub_node (mapped file)", measure_ms([&] {
+            tree = std::make_unique<PersistentTree<int, 4>>(path);
+            vector<PersistentNode<int, 4>> level{tree->add_root(0)};
+            size_t count = 1;
+            for (size_t head = 0; count < nodeCount; ++head)
+            {
+                for (int i = 0; i < 4 && count < nodeCount; ++i, ++count)
+                {
+                    level.push_back(tree->add_sub_node(level[head], static_cast<int>(count)));
+                }
+            }
+        }), nodeCount);
+        report("checkpoint (msync + fsync)", measure_ms([&] { tree->checkpoint(); }), 0);
+        report("BFS over the mapped file", measure_ms([&] {
+            for (auto it = tree->begin_bfs_scan(); it != tree->end_bfs_scan(); ++it) sum += it->get_value();
+        }), nodeCount);
+    }
+
+    std::unique_ptr<PersistentTree<int, 4>> reopened;
+    report("reopen (mmap, no parsing)", measure_ms([&] { reopened = std::make_unique<PersistentTree<int, 4>>(path); }), 0);
+    report("BFS after reopening", measure_ms([&] {
+        for (auto it = reopened->begin_bfs_scan(); it != reopened->end_bfs_scan(); ++it) sum -= it->get_value();
+    }), nodeCount);
+    cout << "  walks agree: " << (sum == 0 ? "yes" : "no") << endl;
+    reopened.reset();
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Walks a paged tree with a memory budget of an eighth of the file, for several page sizes,
+ * and reports the page misses of each walk.
+ */
+void bench_paged()
+{
+    const size_t nodeCount = 1000000;
+    std::mt19937_64 rng(44);
+    vector<int> values(nodeCount);
+    for (int& value : values) value = static_cast<int>(rng() % 1000000);
+    Tree<int> tree(values);
+    string path = "/tmp/bench_paged_tree.bin";
+    cout << "Walking a paged binary tree with " << nodeCount << " nodes, budget 1/8 of the file" << endl;
+
+    for (size_t pageSize : {size_t(1024), size_t(4096), size_t(16384), size_t(65536)})
+    {
+        write_paged_tree(tree, path, pageSize);
+        PagedTree<int> paged(path, nodeCount * 32 / 8);
+        cout << " page size " << pageSize << " (" << paged.nodes_per_page() << " nodes per page)" << endl;
+        long long sum = 0;
+        auto walk = [&](const string& name, PagedIterator<int> first, PagedIterator<int> last) {
+            paged.buffer_pool().reset_stats();
+            double ms = measure_ms([&] {
+                for (; first != last; ++first) sum += first->get_value();
+            });
+            report(name, ms, nodeCount);
+            cout << "    page misses: " << paged.stats().misses << ", hits: " << paged.stats().hits << endl;
+        };
+        walk("  DFS", paged.begin_dfs_scan(), paged.end_dfs_scan());
+        walk("  post-order", paged.begin_post_order(), paged.end_post_order());
+        walk("  BFS", paged.begin_bfs_scan(), paged.end_bfs_scan());
+
+        paged.buffer_pool().reset_stats();
+        const size_t lookups = 10000;
+        report("  random root-to-leaf paths", measure_ms([&] {
+            for (size_t i = 0; i < lookups; ++i)
+            {
+                PagedNode<int> node = paged.get_root();
+                while (node.child_count() > 0) node = node.child(rng() % node.child_count());
+                sum += node.get_value();
+            }
+        }), lookups);
+        cout << "    page misses: " << paged.stats().misses << ", hits: " << paged.stats().hits << endl;
+    }
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Compares loading a whole tree with read_tree against opening it lazily and following random paths.
+ */
+void bench_lazy()
+{
+    const size_t nodeCount = 5000000;
+    std::mt19937_64 rng(45);
+    vector<int> values(nodeCount);
+    for (int& value : values) value = static_cast<int>(rng() % 1000000);
+    string path = "/tmp/bench_lazy_tree.bin";
+    {
+        Tree<int, 4> tree(values);
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        write_frozen_tree(tree, file);
+        std::fclose(file);
+    }
+    cout << "Navigating a 4-ary tree with " << nodeCount << " nodes" << endl;
+
+    const size_t paths = 1000;
+    long long sum = 0;
+    auto navigate = [&](auto* root) {
+        for (size_t i = 0; i < paths; ++i)
+        {
+            auto* node = root;
+            while (!node->get_children().empty()) node = node->get_children()[rng() % node->get_children().size()];
+            sum += node->get_value();
+        }
+    };
+
+    {
+        Tree<int, 4> loaded;
+        report("read_tree (everything)", measure_ms([&] {
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            read_tree(loaded, file);
+            std::fclose(file);
+        }), nodeCount);
+        report("random root-to-leaf paths", measure_ms([&] { navigate(loaded.root); }), paths);
+    }
+
+    std::unique_ptr<LazyTree<int, 4>> lazy;
+    report("LazyTree open (header and root)", measure_ms([&] { lazy = std::make_unique<LazyTree<int, 4>>(path); }), 0);
+    report("random root-to-leaf paths", measure_ms([&] { navigate(lazy->get_root()); }), paths);
+    cout << "  nodes materialised: " << lazy->loaded_size() << " of " << lazy->size() << " (checksum " << sum << ")" << endl;
+    report("more random paths (partly loaded)", measure_ms([&] { navigate(lazy->get_root()); }), paths);
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief SAX handler that only counts nodes, to measure the parser apart from node allocation.
+ */
+struct CountingHandler
+{
+    size_t nodes = 0;
+    long long sum = 0;
+
+    bool begin_node(int value)
+    {
+        ++this->nodes;
+        this->sum += value;
+        return true;
+    }
+
+    void end_node() {}
+};
+
+/**
+ * @brief Writes a tree as nested JSON or indented text, walking it with an explicit stack.
+ */
+void write_text_tree(Tree<int, 4>& tree, const string& path, bool json)
+{
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    vector<std::pair<Node<int>*, size_t>> stack{{tree.root, 0}};
+    if (json) std::fprintf(file, "{\"value\": %d", tree.root->get_value());
+    else std::fprintf(file, "%d\n", tree.root->get_value());
+    while (!stack.empty())
+    {
+        auto& [node, next] = stack.back();
+        const vector<Node<int>*>& children = node->get_children();
+        if (next < children.size())
+        {
+            Node<int>* child = children[next++];
+            if (json) std::fprintf(file, "%s{\"value\": %d", next == 1 ? ", \"children\": [" : ", ", child->get_value());
+            else std::fprintf(file, "%*s%d\n", static_cast<int>(stack.size()), "", child->get_value());
+            stack.push_back({child, 0});
+            continue;
+        }
+        if (json) std::fputs(children.empty() ? "}" : "]}", file);
+        stack.pop_back();
+    }
+    std::fclose(file);
+}
+
+/**
+ * @brief Measures the streaming JSON and indented-text parsers: raw SAX throughput and building a Tree.
+ * The input size is set by nodeCount (about 25 bytes of JSON per node), given on the command line as
+ * `./bench text <nodes>`, so multi-GB inputs need no code change; memory stays at the tree plus one buffer.
+ * @param nodeCount The number of nodes in the generated input.
+ */
+void bench_text_parser(size_t nodeCount)
+{
+    std::mt19937_64 rng(46);
+    vector<int> values(nodeCount);
+    for (int& value : values) value = static_cast<int>(rng() % 2000000) - 1000000;
+    string jsonPath = "/tmp/bench_tree.json";
+    string textPath = "/tmp/bench_tree.txt";
+    {
+        Tree<int, 4> tree(values);
+        write_text_tree(tree, jsonPath, true);
+        write_text_tree(tree, textPath, false);
+    }
+
+    for (bool json : {true, false})
+    {
+        const string& path = json ? jsonPath : textPath;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        std::fseek(file, 0, SEEK_END);
+        double megabytes = static_cast<double>(std::ftell(file)) / (1 << 20);
+        std::fclose(file);
+        cout << "Parsing " << (json ? "JSON" : "indented text") << ": " << nodeCount << " nodes, " << megabytes << " MB" << endl;
+
+        CountingHandler counter;
+        double ms = measure_ms([&] {
+            std::FILE* input = std::fopen(path.c_str(), "rb");
+            TextInput in(input);
+            if (json) parse_json<int>(in, counter);
+            else parse_indented<int>(in, counter);
+            std::fclose(input);
+        });
+        report("  SAX events only", ms, nodeCount);
+        cout << "    " << megabytes / ms * 1000 << " MB/s" << endl;
+
+        Tree<int, 4> tree;
+        ms = measure_ms([&] {
+            std::FILE* input = std::fopen(path.c_str(), "rb");
+            if (json) parse_json_tree(tree, input);
+            else parse_indented_tree(tree, input);
+            std::fclose(input);
+        });
+        report("  building a Tree<int, 4>", ms, nodeCount);
+        cout << "    " << megabytes / ms * 1000 << " MB/s, " << (counter.nodes == nodeCount ? "all nodes seen" : "node count mismatch") << endl;
+    }
+    std::remove(jsonPath.c_str());
+    std::remove(textPath.c_str());
+}
+
+/**
+ * @brief Compares the plain and compressed binary formats: size, write and read time, and raw
+ * decode throughput of the compressed value column.
+ */
+void bench_compression()
+{
+    const size_t nodeCount = 2000000;
+    std::mt19937_64 rng(47);
+    vector<int> walk(nodeCount);
+    vector<double> readings(nodeCount);
+    vector<string> words(nodeCount);
+    int level = 0;
+    for (size_t i = 0; i < nodeCount; ++i)
+    {
+        level += static_cast<int>(rng() % 21) - 10;
+        walk[i] = level;
+        readings[i] = 20.0 + 0.25 * static_cast<double>(rng() % 16);
+        words[i] = "category-" + std::to_string(rng() % 64);
+    }
+    Tree<int, 3> ints(walk);
+    Tree<double, 3> doubles(readings);
+    Tree<string, 3> strings(words);
+    cout << "Plain against compressed binary format, trees with " << nodeCount << " nodes" << endl;
+
+    auto compare = [&](const string& name, auto& tree, auto& copy, auto compressor) {
+        for (bool compressed : {false, true})
+        {
+            std::FILE* file = std::tmpfile();
+            string label = "  " + name + (compressed ? " compressed" : " plain");
+            report(label + " write", measure_ms([&] {
+                if (compressed) write_compressed_tree(tree, file);
+                else write_tree(tree, file);
+            }), nodeCount);
+            long bytes = std::ftell(file);
+            std::rewind(file);
+            report(label + " read", measure_ms([&] { read_tree(copy, file); }), nodeCount);
+            cout << "    " << static_cast<double>(bytes) / static_cast<double>(nodeCount) << " bytes per node" << endl;
+            std::fclose(file);
+        }
+
+        // Decode the value column alone, block by block as read_tree does
+        using Value = typename decltype(compressor)::value_type;
+        vector<Value> values;
+        for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it) values.push_back(it->get_value());
+        vector<vector<unsigned char>> blocks;
+        for (size_t first = 0; first < nodeCount; first += 4096)
+        {
+            vector<Value> block(values.begin() + static_cast<std::ptrdiff_t>(first), values.begin() + static_cast<std::ptrdiff_t>(std::min(nodeCount, first + 4096)));
+            blocks.emplace_back();
+            ValueCompressor<Value>::encode(block, blocks.back());
+        }
+        vector<Value> decoded;
+        decoded.reserve(nodeCount);
+        double ms = measure_ms([&] {
+            for (size_t b = 0; b < blocks.size(); ++b)
+            {
+                ValueCompressor<Value>::decode(blocks[b].data(), blocks[b].data() + blocks[b].size(), std::min<size_t>(4096, nodeCount - b * 4096), decoded);
+            }
+        });
+        report("  " + name + " value decode only", ms, nodeCount);
+        cout << "    " << static_cast<double>(nodeCount) / ms / 1000 << " M values/s, " << (decoded == values ? "exact" : "MISMATCH") << endl;
+    };
+
+    Tree<int, 3> intCopy;
+    Tree<double, 3> doubleCopy;
+    Tree<string, 3> stringCopy;
+    compare("int random walk", ints, intCopy, vector<int>());
+    compare("double readings", doubles, doubleCopy, vector<double>());
+    compare("string categories", strings, stringCopy, vector<string>());
+}
+
+/**
+ * @brief Compares navigation over SuccinctTree handles with Node pointers, on a random and on a deep 3-ary tree.
+ */
+void bench_succinct()
+{
+    const size_t nodeCount = 2000000;
+    const size_t queries = 1000000;
+    for (size_t window : {size_t(0), size_t(16)})
+    {
+        std::mt19937_64 rng(48);
+        Tree<int, 3> tree;
+        vector<Node<int>*> nodes = build_random_tree(tree, nodeCount, rng, window);
+        cout << "Succinct against pointer navigation, " << (window == 0 ? "random" : "deep") << " 3-ary tree with " << nodeCount << " nodes" << endl;
+
+        std::unique_ptr<SuccinctTree<int, 3>> succinct;
+        report("SuccinctTree build", measure_ms([&] { succinct = std::make_unique<SuccinctTree<int, 3>>(tree); }), nodeCount);
+        cout << "    " << static_cast<double>(succinct->topology_bytes() * 8) / static_cast<double>(nodeCount) << " topology bits per node, against "
+             << sizeof(Node<int>) + 3 * sizeof(Node<int>*) << " bytes per Node" << endl;
+
+        long long sum = 0;
+        report("Node DFS (pre-order) scan", measure_ms([&] {
+            for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it) sum += it->get_value();
+        }), nodeCount);
+        report("SuccinctTree pre-order scan", measure_ms([&] {
+            for (auto it = succinct->begin_pre_order(); it != succinct->end_pre_order(); ++it) sum += it->get_value();
+        }), nodeCount);
+
+        // The same random nodes on both sides: insertion order for the pointers, pre-order positions for the handles
+        vector<size_t> picks(queries);
+        for (size_t& pick : picks) pick = rng() % nodeCount;
+        vector<SuccinctNode<int, 3>> handles;
+        handles.reserve(queries);
+        report("SuccinctTree node_at (select)", measure_ms([&] {
+            for (size_t pick : picks) handles.push_back(succinct->node_at(pick));
+        }), queries);
+        tree.enable_parent_links();
+        report("Tree get_parent (parent links)", measure_ms([&] {
+            for (size_t pick : picks) sum += tree.get_parent(nodes[pick]) ? 1 : 0;
+        }), queries);
+        report("SuccinctTree get_parent", measure_ms([&] {
+            for (const SuccinctNode<int, 3>& handle : handles) sum += handle.get_parent() ? 1 : 0;
+        }), queries);
+        report("SuccinctTree subtree_size", measure_ms([&] {
+            for (const SuccinctNode<int, 3>& handle : handles) sum += static_cast<long long>(handle.subtree_size());
+        }), queries);
+
+        const size_t paths = 10000;
+        size_t steps = 0;
+        report("Node random root-to-leaf paths", measure_ms([&] {
+            for (size_t i = 0; i < paths; ++i)
+            {
+                Node<int>* node = tree.root;
+                while (!node->get_children().empty()) node = node->get_children()[rng() % node->get_children().size()];
+                sum += node->get_value();
+            }
+        }), paths);
+        report("SuccinctTree random root-to-leaf paths", measure_ms([&] {
+            for (size_t i = 0; i < paths; ++i)
+            {
+                SuccinctNode<int, 3> node = succinct->get_root();
+                for (size_t count = node.child_count(); count > 0; count = node.child_count(), ++steps) node = node.child(rng() % count);
+                sum += node.get_value();
+            }
+        }), paths);
+        cout << "    " << steps << " child steps (checksum " << sum << ")" << endl;
+    }
+}
+
+/**
+ * @brief Compares persisting bursts of insertions by rewriting a snapshot with logging them to a TreeJournal.
+ */
+void bench_journal()
+{
+    const size_t mutations = 20000;
+    const size_t burst = 100;
+    string path = "/tmp/bench_journal";
+    cout << "Persisting " << mutations << " insertions into a 3-ary tree, in bursts of " << burst << endl;
+
+    // Parents are picked as in build_random_tree, the same sequence for every run
+    auto insertAll = [&](Tree<int, 3>& tree, auto insert, auto endBurst) {
+        std::mt19937_64 rng(49);
+        vector<Node<int>*> nodes{tree.root};
+        for (size_t i = 1; i <= mutations; ++i)
+        {
+            Node<int>* parent = nodes[rng() % nodes.size()];
+            while (parent->get_children().size() == 3) parent = nodes[rng() % nodes.size()];
+            Node<int>* child = new Node<int>(static_cast<int>(i));
+            insert(parent, child);
+            nodes.push_back(child);
+            if (i % burst == 0) endBurst();
+        }
+    };
+
+    {
+        Tree<int, 3> tree;
+        tree.add_root(new Node<int>(0));
+        uint64_t bytes = 0;
+        report("rewrite snapshot after every burst", measure_ms([&] {
+            insertAll(tree, [&](Node<int>* parent, Node<int>* child) { tree.add_sub_node(parent, child); }, [&] {
+                int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                BinaryWriter out(fd);
+                write_tree(tree, out);
+                bytes += out.bytes_written();
+                ::fsync(fd);
+                ::close(fd);
+            });
+        }), mutations);
+        cout << "    " << bytes / 1024 << " KiB written" << endl;
+        std::remove(path.c_str());
+    }
+
+    for (size_t group : {size_t(1), size_t(10), burst})
+    {
+        std::remove((path + ".snapshot").c_str());
+        std::remove((path + ".journal").c_str());
+        Tree<int, 3> tree;
+        TreeJournal<int, 3> journal(tree, path, group);
+        journal.add_root(new Node<int>(0));
+        journal.commit();
+        report("journal, group of " + std::to_string(group), measure_ms([&] {
+            insertAll(tree, [&](Node<int>* parent, Node<int>* child) { journal.add_sub_node(parent, child); }, [&] { journal.commit(); });
+        }), mutations);
+        cout << "    " << journal.stats().recordBytes / 1024 << " KiB written, " << journal.stats().commits << " syncs" << endl;
+    }
+
+    {
+        Tree<int, 3> tree;
+        std::unique_ptr<TreeJournal<int, 3>> journal;
+        report("reopen: replay the journal", measure_ms([&] { journal = std::make_unique<TreeJournal<int, 3>>(tree, path); }), mutations);
+        report("compact into a snapshot", measure_ms([&] { journal->compact(); }), 0);
+    }
+    Tree<int, 3> tree;
+    report("reopen: load the snapshot", measure_ms([&] { TreeJournal<int, 3> journal(tree, path); }), 0);
+    std::remove((path + ".snapshot").c_str());
+    std::remove((path + ".journal").c_str());
+}
+
+/**
+ * @brief Compares loading a large tree with read_tree against read_sharded_tree on 1 to 8 threads.
+ */
+void bench_sharded()
+{
+    const size_t nodeCount = 2000000;
+    std::mt19937_64 rng(50);
+    vector<string> words(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) words[i] = "value-" + std::to_string(rng() % 100000);
+    Tree<string, 3> tree(words);
+    string plainPath = "/tmp/bench_plain_tree.bin";
+    string shardedPath = "/tmp/bench_sharded_tree.bin";
+    cout << "Loading a string tree with " << nodeCount << " nodes (" << std::thread::hardware_concurrency() << " hardware threads)" << endl;
+
+    std::FILE* file = std::fopen(plainPath.c_str(), "wb");
+    write_tree(tree, file);
+    std::fclose(file);
+    file = std::fopen(shardedPath.c_str(), "wb");
+    report("write_sharded_tree (64K-node shards)", measure_ms([&] { write_sharded_tree(tree, file); }), nodeCount);
+    std::fclose(file);
+
+    Tree<string, 3> loaded;
+    report("read_tree (plain file)", measure_ms([&] {
+        std::FILE* in = std::fopen(plainPath.c_str(), "rb");
+        read_tree(loaded, in);
+        std::fclose(in);
+    }), nodeCount);
+    for (size_t threads : {size_t(1), size_t(2), size_t(4), size_t(8)})
+    {
+        report("read_sharded_tree, " + std::to_string(threads) + " threads", measure_ms([&] { read_sharded_tree(loaded, shardedPath, threads); }), nodeCount);
+    }
+    std::remove(plainPath.c_str());
+    std::remove(shardedPath.c_str());
+}
+
+/**
+ * @brief Runs the benchmark named on the command line, or all of them.
+ * Usage: ./bench [lca|hld|zone|bloom|diff|compact|build|balanced|serialize|frozen|persistent|paged|lazy|text [nodes]|compress|succinct|journal|sharded]
+ */
+int main(int argc, char* argv[])
+{
+    string only = argc > 1 ? argv[1] : "";
+    if (only.empty() || only == "lca") bench_lca();
+    if (only.empty() || only == "hld") bench_hld();
+    if (only.empty() || only == "zone") bench_zone_maps();
+    if (only.empty() || only == "bloom") bench_bloom_filters();
+    if (only.empty() || only == "diff") bench_diff();
+    if (only.empty() || only == "compact") bench_compact();
+    if (only.empty() || only == "build") bench_bulk_build();
+    if (only.empty() || only == "balanced") bench_build_balanced();
+    if (only.empty() || only == "serialize") bench_serialization();
+    if (only.empty() || only == "frozen") bench_frozen();
+    if (only.empty() || only == "persistent") bench_persistent();
+    if (only.empty() || only == "paged") bench_paged();
+    if (only.empty() || only == "lazy") bench_lazy();
+    if (only.empty() || only == "text") bench_text_parser(only == "text" && argc > 2 ? static_cast<size_t>(std::stoull(argv[2])) : 8000000);
+    if (only.empty() || only == "compress") bench_compression();
+    if (only.empty() || only == "succinct") bench_succinct();
+    if (only.empty() || only == "journal") bench_journal();
+    if (only.empty() || only == "sharded") bench_sharded();
+    return 0;
+}
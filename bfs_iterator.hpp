@@ -14,28 +14,34 @@ namespace ori {
  * @brief Iterator for Breadth-First Search (BFS) traversing on a tree.
  *
  * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam N The node type: Node<T>, or another type with get_value() and get_children() such as LazyNode<T>.
  */
-template <typename T>
+template <typename T, typename N = Node<T>>
 class BFSIterator {
     
     private:
 
-        queue<Node<T>*> bfsQueue;        // Queue used to hold nodes during the BFS traversal
-        Node<T>* current;                // Pointer to the currect node during the process
+        queue<N*> bfsQueue;              // Queue used to hold nodes during the BFS traversal
+        queue<size_t> depths;            // Depth of each node in the queue, relative to the starting node
+        N* current;                      // Pointer to the currect node during the process
+        size_t maxDepth;                 // Nodes deeper than this are not visited
+        bool skipNext = false;           // Whether the children of the current node must be skipped
     
     public:
 
         /**
          * @brief Constructs a BFSIterator starting at the a root node of a tree.
          * @param root Pointer to the root node of the tree.
+         * @param depthLimit Maximum depth to visit, relative to the starting node (unlimited by default).
          *
          * @details If the root is not null, it is added to the queue to initiate BFS traversal.
          */
-        BFSIterator(Node<T>* root) 
+        BFSIterator(N* root, size_t depthLimit = UNLIMITED_DEPTH) : maxDepth(depthLimit) 
         {
             if (root) 
             {
                 this->bfsQueue.push(root);
+                this->depths.push(0);
                 this->current = bfsQueue.front();
             } 
             else 
@@ -50,14 +56,15 @@ class BFSIterator {
          * Creates a new iterator that is a copy of an existing one.
          * @param other The iterator to copy from.
          */
-        BFSIterator(const BFSIterator& other) : bfsQueue(other.bfsQueue), current(other.current) {}
+        BFSIterator(const BFSIterator& other) 
+            : bfsQueue(other.bfsQueue), depths(other.depths), current(other.current), maxDepth(other.maxDepth), skipNext(other.skipNext) {}
 
 
         /**
          * @brief Dereference operator to access the current node's content.
          * @return Reference to the data stored in the current node.
          */
-        Node<T>& operator*() 
+        N& operator*() 
         {
             return *this->current;
         }
@@ -67,7 +74,7 @@ class BFSIterator {
          * @brief Arrow operator to able access to the current node's members.
          * @return Pointer to the current node.
          */
-        Node<T>* operator->() 
+        N* operator->() 
         {
             return this->current;
         }
@@ -93,9 +100,14 @@ class BFSIterator {
 
             // Remove the current node from the queue
             this->bfsQueue.pop();
-
-            // If the current node is valid (not nullptr), enqueue all children of the current node
-            if (this->current) 
+            size_t depth = this->depths.front();
+            this->depths.pop();
+
+            // If the current node is valid (not nullptr), enqueue all children of the current node,
+            // unless they were skipped or lie beyond the depth limit
+            bool expand = !this->skipNext && depth < this->maxDepth;
+            this->skipNext = false;
+            if (this->current && expand) 
             {
                 // Iterate over each child of the current node
                 for (auto child : current->get_children()) 
@@ -104,6 +116,7 @@ class BFSIterator {
                     if (child) 
                     {  
                         this->bfsQueue.push(child);      // Add the child to the queue for processing
+                        this->depths.push(depth + 1);
                     }
                 }
             }
@@ -115,6 +128,26 @@ class BFSIterator {
         }
 
 
+        /**
+         * @brief Marks the subtree below the current node as not to be visited.
+         * The next increment moves past the current node without enqueuing its children.
+         */
+        void skip_children() 
+        {
+            this->skipNext = true;
+        }
+
+
+        /**
+         * @brief Retrieves the depth of the current node, relative to the starting node.
+         * @return The depth of the current node (0 for the starting node).
+         */
+        size_t depth() const 
+        {
+            return this->depths.front();
+        }
+
+
         /**
          * @brief Equality operator checks if two iterators are equal.
          * @param other Another BFSIterator to compare with this iterator.
@@ -147,9 +180,12 @@ class BFSIterator {
             // Check for "self-assignment"
             if (this != &other) 
             {
-                BFSIterator temp(other);                 // Create a temporary iterator using the copy constructor
-                std::swap(this.queue, temp.bfsQueue);       // Swap the queue member of "this" object with the temporary iterator 
-                std::swap(this.current, temp.current);   // Swap the current node pointer with that of the temporary iterator
+                BFSIterator temp(other);                        // Create a temporary iterator using the copy constructor
+                std::swap(this->bfsQueue, temp.bfsQueue);       // Swap the queue member of "this" object with the temporary iterator 
+                std::swap(this->depths, temp.depths);           // Swap the depths of the queued nodes
+                std::swap(this->current, temp.current);         // Swap the current node pointer with that of the temporary iterator
+                this->maxDepth = temp.maxDepth;
+                this->skipNext = temp.skipNext;
             }
             
             // Return a reference to this object
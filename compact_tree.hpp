@@ -0,0 +1,170 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef COMPACTTREE_HPP
+#define COMPACTTREE_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include "hashing.hpp"
+#include <vector>
+#include <memory>
+#include <utility>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+
+namespace ori {
+
+/**
+ * @class CompactTree
+ * @brief Read-only, hash-consed form of a Tree: structurally identical subtrees are stored once and shared.
+ *
+ * The compact form is a DAG. It is built bottom-up: every node is looked up by its value and the
+ * addresses of its (already shared) children, so two subtrees map to the same stored node exactly
+ * when they hold the same values in the same shape. Memory shrinks by the duplication factor of
+ * the source tree, and all traversal iterators work unchanged, visiting a shared subtree once per
+ * occurrence so that the sequences match those of the source tree.
+ *
+ * A shared node has several parents, so the nodes must not be modified through the iterators.
+ * The per-subtree summaries of the source tree (zone maps, Bloom filters, Merkle hashes) are not copied.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes (must be hashable with std::hash).
+ * @tparam k Maximum number of children each node can have.
+ */
+template <typename T, int k = 2>
+class CompactTree {
+
+    private:
+
+        Node<T>* root = nullptr;                        // The root of the DAG
+        std::vector<std::unique_ptr<Node<T>>> nodes;    // The distinct stored nodes, children before parents
+        size_t logicalSize = 0;                         // Number of nodes of the expanded tree
+
+
+        /**
+         * @brief Hashes a node by its value and the addresses of its shared children.
+         */
+        static uint64_t keyOf(const T& value, const std::vector<Node<T>*>& children)
+        {
+            uint64_t h = hash_combine(mix_hash(static_cast<uint64_t>(std::hash<T>()(value))), children.size());
+            for (const Node<T>* child : children)
+            {
+                h = hash_combine(h, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(child)));
+            }
+            return h;
+        }
+
+    public:
+
+        /**
+         * @brief Builds the compact form of a tree in expected O(n).
+         * The source tree is walked once in post-order; it is not modified and may be destroyed afterwards.
+         * @param tree The tree to compact.
+         */
+        explicit CompactTree(const Tree<T, k>& tree)
+        {
+            if (!tree.root) return;
+
+            // Stored nodes grouped by key; colliding keys are told apart by comparing values and children
+            std::unordered_map<uint64_t, std::vector<Node<T>*>> table;
+
+            // Post-order walk: each frame is a source node and the position of its next child to visit.
+            // When a node is finished, the shared forms of its children are the last entries of `done`.
+            std::vector<std::pair<const Node<T>*, size_t>> frames{{tree.root, 0}};
+            std::vector<Node<T>*> done;
+            while (!frames.empty())
+            {
+                auto& [source, next] = frames.back();
+                if (next < source->get_children().size())
+                {
+                    const Node<T>* child = source->get_children()[next++];
+                    frames.push_back({child, 0});
+                    continue;
+                }
+
+                size_t count = source->get_children().size();
+                std::vector<Node<T>*> children(done.end() - static_cast<std::ptrdiff_t>(count), done.end());
+                done.resize(done.size() - count);
+
+                std::vector<Node<T>*>& bucket = table[keyOf(source->get_value(), children)];
+                Node<T>* shared = nullptr;
+                for (Node<T>* candidate : bucket)
+                {
+                    if (candidate->get_children() == children && candidate->get_value() == source->get_value())
+                    {
+                        shared = candidate;
+                        break;
+                    }
+                }
+                if (!shared)
+                {
+                    this->nodes.push_back(std::make_unique<Node<T>>(source->get_value()));
+                    shared = this->nodes.back().get();
+                    shared->get_children() = std::move(children);
+                    bucket.push_back(shared);
+                }
+
+                done.push_back(shared);
+                ++this->logicalSize;
+                frames.pop_back();
+            }
+            this->root = done.back();
+        }
+
+
+        /**
+         * @brief Retrieves the root of the DAG, or nullptr for an empty tree.
+         */
+        const Node<T>* get_root() const
+        {
+            return this->root;
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes of the tree the DAG represents.
+         */
+        size_t size() const
+        {
+            return this->logicalSize;
+        }
+
+
+        /**
+         * @brief Retrieves the number of distinct nodes actually stored.
+         * size() / unique_size() is the duplication factor the compaction removed.
+         */
+        size_t unique_size() const
+        {
+            return this->nodes.size();
+        }
+
+
+        // Iterator access functions, with the same traversal orders as Tree
+        PreOrderIterator<T> begin_pre_order() const { return PreOrderIterator<T>(root); }
+        PreOrderIterator<T> begin_pre_order(size_t maxDepth) const { return PreOrderIterator<T>(root, maxDepth); }
+        PreOrderIterator<T> end_pre_order() const { return PreOrderIterator<T>(nullptr); }
+
+        PostOrderIterator<T> begin_post_order() const { return PostOrderIterator<T>(root); }
+        PostOrderIterator<T> end_post_order() const { return PostOrderIterator<T>(nullptr); }
+
+        InOrderIterator<T> begin_in_order() const { return InOrderIterator<T>(root); }
+        InOrderIterator<T> end_in_order() const { return InOrderIterator<T>(nullptr); }
+
+        BFSIterator<T> begin_bfs_scan() const { return BFSIterator<T>(root); }
+        BFSIterator<T> begin_bfs_scan(size_t maxDepth) const { return BFSIterator<T>(root, maxDepth); }
+        BFSIterator<T> end_bfs_scan() const { return BFSIterator<T>(nullptr); }
+
+        BFSIterator<T> begin() const { return begin_bfs_scan(); }
+        BFSIterator<T> end() const { return end_bfs_scan(); }
+
+        DFSIterator<T> begin_dfs_scan() const { return DFSIterator<T>(root); }
+        DFSIterator<T> begin_dfs_scan(size_t maxDepth) const { return DFSIterator<T>(root, maxDepth); }
+        DFSIterator<T> end_dfs_scan() const { return DFSIterator<T>(nullptr); }
+
+        HeapIterator<T> myHeap() const { return HeapIterator<T>(root); }
+        HeapIterator<T> end_heap() const { return HeapIterator<T>(nullptr); }
+    };
+}
+
+#endif
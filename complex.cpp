@@ -26,6 +26,26 @@ namespace ori {
      */
     Complex::~Complex() {}
 
+    /**
+     * @brief Retrieves the real part of the complex number.
+     * @return The real part.
+     */
+    double Complex::getReal() const 
+    {
+        return real;
+    }
+
+
+    /**
+     * @brief Retrieves the imaginary part of the complex number.
+     * @return The imaginary part.
+     */
+    double Complex::getImage() const 
+    {
+        return image;
+    }
+
+
     /**
      * @brief Overload the == operator for comparison.
      * @param other The other complex number to compare with.
@@ -65,6 +85,17 @@ namespace ori {
     }
 
 
+    /**
+     * @brief Overload the + operator for addition.
+     * @param other The complex number to add.
+     * @return The sum of the two complex numbers.
+     */
+    Complex Complex::operator+(const Complex& other) const 
+    {
+        return Complex(real + other.real, image + other.image);
+    }
+
+
     /**
      * @brief Converts the complex number to a string representation.
      * @return A string in the form "real+imagi" or "real-imagi".
@@ -3,6 +3,7 @@
 
 #include <iostream>
 #include <string>
+#include <functional>
 
 using std::string;
 using std::ostream;
@@ -33,6 +34,11 @@ class Complex {
         bool operator!=(const Complex& other) const;
         bool operator>(const Complex& other) const;
         bool operator<(const Complex& other) const;
+        Complex operator+(const Complex& other) const;
+
+        // Getters
+        double getReal() const;
+        double getImage() const;
 
         // toString function
         string toString() const;
@@ -42,4 +48,21 @@ class Complex {
     };
 } 
 
+/**
+ * @brief std::hash support for Complex, so it can be used as a key of hash-based indexes.
+ * Values that compare equal hash equally (-0.0 and 0.0 are folded together).
+ */
+namespace std {
+
+    template <>
+    struct hash<ori::Complex>
+    {
+        size_t operator()(const ori::Complex& c) const noexcept
+        {
+            size_t h = hash<double>()(c.getReal() + 0.0);
+            return h ^ (hash<double>()(c.getImage() + 0.0) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+        }
+    };
+}
+
 #endif 
@@ -15,13 +15,17 @@ namespace ori {
  * @brief Iterator for performing Depth-First Search (DFS) on a tree.
  *
  * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam N The node type: Node<T>, or another type with get_value() and get_children() such as LazyNode<T>.
  */
-template <typename T>
+template <typename T, typename N = Node<T>>
 class DFSIterator {
 
     private:
     
-        stack<Node<T>*> dfsStack;      // Stack used to hold nodes during the DFS traversal
+        stack<N*> dfsStack;            // Stack used to hold nodes during the DFS traversal
+        stack<size_t> depths;          // Depth of each node in the stack, relative to the starting node
+        size_t maxDepth;               // Nodes deeper than this are not visited
+        bool skipNext = false;         // Whether the children of the current node must be skipped
     
     public:
         
@@ -29,12 +33,14 @@ class DFSIterator {
          * @brief Constructs a DFSIterator starting at the specified node of a tree (which is the "currect" node).
          * The constructor initializes the traversal by pushing the starting node onto the stack, if it is not null.
          * @param node Pointer to the initial node from where DFS traversal begins.
+         * @param depthLimit Maximum depth to visit, relative to the starting node (unlimited by default).
          */
-        DFSIterator(Node<T>* node) : dfsStack() 
+        DFSIterator(N* node, size_t depthLimit = UNLIMITED_DEPTH) : dfsStack(), maxDepth(depthLimit) 
         {
             if (node) 
             {
                 this->dfsStack.push(node);
+                this->depths.push(0);
             }
         }
 
@@ -42,14 +48,15 @@ class DFSIterator {
          * @brief Copy constructor.
          * @param other The DFSIterator to copy.
          */
-        DFSIterator(const DFSIterator& other) : dfsStack(other.dfsStack) {}
+        DFSIterator(const DFSIterator& other) 
+            : dfsStack(other.dfsStack), depths(other.depths), maxDepth(other.maxDepth), skipNext(other.skipNext) {}
 
 
         /**
          * @brief Dereference operator to access the current node's *content*.
          * @return Reference to the data stored in the current node.
          */
-        Node<T>& operator*() 
+        N& operator*() 
         {
             return *this->dfsStack.top();
         }
@@ -59,7 +66,7 @@ class DFSIterator {
          * @brief Arrow operator to able access to the current node's members (the top element in the stack).
          * @return Pointer to the current node.
          */
-        Node<T>* operator->() 
+        N* operator->() 
         {
             return this->dfsStack.top();
         }
@@ -75,19 +82,47 @@ class DFSIterator {
          */
         DFSIterator& operator++() 
         {
-            Node<T>* current = this->dfsStack.top();
+            N* current = this->dfsStack.top();
             this->dfsStack.pop();
+            size_t depth = this->depths.top();
+            this->depths.pop();
 
-            // Push all children of the current node onto the stack, in reverse order to visit the leftmost child first.
-            const auto& children = current->get_children(); 
-            for (auto it = children.rbegin(); it != children.rend(); ++it) 
+            // Push all children of the current node onto the stack, in reverse order to visit the leftmost child first,
+            // unless they were skipped or lie beyond the depth limit.
+            if (!this->skipNext && depth < this->maxDepth) 
             {
-                this->dfsStack.push(*it);
+                const auto& children = current->get_children(); 
+                for (auto it = children.rbegin(); it != children.rend(); ++it) 
+                {
+                    this->dfsStack.push(*it);
+                    this->depths.push(depth + 1);
+                }
             }
+            this->skipNext = false;
             return *this;
         }
 
 
+        /**
+         * @brief Marks the subtree below the current node as not to be visited.
+         * The next increment moves past the current node without expanding its children.
+         */
+        void skip_children() 
+        {
+            this->skipNext = true;
+        }
+
+
+        /**
+         * @brief Retrieves the depth of the current node, relative to the starting node.
+         * @return The depth of the current node (0 for the starting node).
+         */
+        size_t depth() const 
+        {
+            return this->depths.top();
+        }
+
+
         /**
          * @brief Equality operator.
          * Compares this iterator with another for equivalence.
@@ -135,6 +170,9 @@ class DFSIterator {
             if (this != &other) 
             {
                 this->dfsStack = other.dfsStack;    // Copy the stack
+                this->depths = other.depths;
+                this->maxDepth = other.maxDepth;
+                this->skipNext = other.skipNext;
             }
             return *this;
         }
@@ -0,0 +1,273 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef DIFF_HPP
+#define DIFF_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+namespace ori {
+
+    /**
+     * @struct TreeEdit
+     * @brief One step of an edit script: change a value, insert a subtree or remove a subtree.
+     *
+     * A node is addressed by its path, the child positions taken from the root to reach it (the
+     * root itself has an empty path). The path of an insertion is the slot the new subtree takes,
+     * which is always one past the last existing child of its parent.
+     *
+     * @tparam T The data type of the elements stored in the tree nodes.
+     */
+    template <typename T>
+    struct TreeEdit
+    {
+        enum class Kind { Change, Insert, Remove };
+
+        Kind kind;
+        std::vector<size_t> path;           // Child positions from the root to the edited node
+        std::vector<T> values;              // Change: the new value; Insert: the subtree values in pre-order
+        std::vector<size_t> childCounts;    // Insert: the number of children of each inserted node, in pre-order
+    };
+
+
+    /**
+     * @brief An edit script, applied in order by apply_patch.
+     */
+    template <typename T>
+    using EditScript = std::vector<TreeEdit<T>>;
+
+
+    /**
+     * @brief Creates the edit that inserts a copy of a whole subtree.
+     * @param path The slot the subtree takes: the path of its parent plus the parent's child count.
+     * @param subtree The root of the subtree, whose values and shape are recorded in pre-order.
+     * @return An Insert edit, ready for an edit script or a journal.
+     */
+    template <typename T>
+    TreeEdit<T> insert_edit(const std::vector<size_t>& path, const Node<T>* subtree)
+    {
+        TreeEdit<T> edit{TreeEdit<T>::Kind::Insert, path, {}, {}};
+        std::vector<const Node<T>*> pending{subtree};
+        while (!pending.empty())
+        {
+            const Node<T>* node = pending.back();
+            pending.pop_back();
+            edit.values.push_back(node->get_value());
+            edit.childCounts.push_back(node->get_children().size());
+            for (auto it = node->get_children().rbegin(); it != node->get_children().rend(); ++it)
+            {
+                pending.push_back(*it);
+            }
+        }
+        return edit;
+    }
+
+
+    /**
+     * @brief Computes an edit script turning one tree into another.
+     *
+     * The trees are walked together and children are matched by position. For every matched pair
+     * a differing value becomes a Change, extra children of the target become Inserts carrying the
+     * whole subtree, and extra children of the source become Removes (last child first, so the
+     * positions of the edits stay valid while the script is applied in order).
+     *
+     * When both trees maintain Merkle hashes, matched subtrees with equal hashes are skipped without
+     * being visited, so the cost is proportional to the changed nodes and their ancestors instead of
+     * the tree size. Otherwise every matched pair is compared.
+     *
+     * @param from The source tree.
+     * @param to The target tree.
+     * @return The edit script; empty when the trees are equal.
+     */
+    template <typename T, int k>
+    EditScript<T> diff_trees(const Tree<T, k>& from, const Tree<T, k>& to)
+    {
+        EditScript<T> script;
+        if (!from.root && !to.root) return script;
+        if (!to.root)
+        {
+            script.push_back({TreeEdit<T>::Kind::Remove, {}, {}, {}});
+            return script;
+        }
+        if (!from.root)
+        {
+            script.push_back(insert_edit<T>({}, to.root));
+            return script;
+        }
+
+        bool hashed = from.has_merkle_hashing() && to.has_merkle_hashing();
+
+        // Each entry is a matched pair, its depth and its position under its parent. The stack is
+        // walked in pre-order, so path[0, depth - 1) still describes the ancestors of a popped pair.
+        struct Pending
+        {
+            const Node<T>* a;
+            const Node<T>* b;
+            size_t depth;
+            size_t position;
+        };
+        std::vector<Pending> pending{{from.root, to.root, 0, 0}};
+        std::vector<size_t> path;
+
+        while (!pending.empty())
+        {
+            Pending current = pending.back();
+            pending.pop_back();
+            if (hashed && from.subtree_hash(current.a) == to.subtree_hash(current.b)) continue;
+
+            path.resize(current.depth);
+            if (current.depth > 0) path[current.depth - 1] = current.position;
+
+            if (!(current.a->get_value() == current.b->get_value()))
+            {
+                script.push_back({TreeEdit<T>::Kind::Change, path, {current.b->get_value()}, {}});
+            }
+
+            const std::vector<Node<T>*>& left = current.a->get_children();
+            const std::vector<Node<T>*>& right = current.b->get_children();
+            size_t common = std::min(left.size(), right.size());
+
+            path.push_back(0);
+            for (size_t i = left.size(); i > common; --i)
+            {
+                path.back() = i - 1;
+                script.push_back({TreeEdit<T>::Kind::Remove, path, {}, {}});
+            }
+            for (size_t i = common; i < right.size(); ++i)
+            {
+                path.back() = i;
+                script.push_back(insert_edit<T>(path, right[i]));
+            }
+            path.pop_back();
+
+            for (size_t i = common; i > 0; --i)
+            {
+                pending.push_back({left[i - 1], right[i - 1], current.depth + 1, i - 1});
+            }
+        }
+        return script;
+    }
+
+
+    namespace detail {
+
+    /**
+     * @brief Builds a detached subtree from the pre-order values and child counts of an Insert edit.
+     * @throws std::invalid_argument if the counts do not describe a single tree with at most k children per node.
+     */
+    template <typename T, int k>
+    Node<T>* buildInserted(const TreeEdit<T>& edit)
+    {
+        if (edit.values.empty() || edit.values.size() != edit.childCounts.size())
+        {
+            throw std::invalid_argument("apply_patch: malformed insertion.");
+        }
+
+        std::vector<Node<T>*> created;
+        std::vector<std::pair<Node<T>*, size_t>> open;      // Nodes still waiting for children, with how many are missing
+        bool valid = true;
+        for (size_t i = 0; i < edit.values.size(); ++i)
+        {
+            if (edit.childCounts[i] > static_cast<size_t>(k) || (i > 0 && open.empty()))
+            {
+                valid = false;
+                break;
+            }
+
+            Node<T>* node = new Node<T>(edit.values[i]);
+            created.push_back(node);
+            if (!open.empty())
+            {
+                open.back().first->add_child(node);
+                if (--open.back().second == 0) open.pop_back();
+            }
+            if (edit.childCounts[i] > 0) open.push_back({node, edit.childCounts[i]});
+        }
+
+        if (!valid || !open.empty())
+        {
+            for (Node<T>* node : created) delete node;
+            throw std::invalid_argument("apply_patch: malformed insertion.");
+        }
+        return created.front();
+    }
+
+    }
+
+
+    /**
+     * @brief Applies an edit script to a tree in place, through the tree's own mutators so that its
+     * indexes, zone maps, Bloom filters and Merkle hashes stay in sync.
+     *
+     * Applying diff_trees(a, b) to a tree equal to a makes it equal to b.
+     *
+     * @param tree The tree to patch.
+     * @param script The edits, applied in order.
+     * @throws std::invalid_argument if an edit does not fit the tree. Edits before it remain applied.
+     */
+    template <typename T, int k>
+    void apply_patch(Tree<T, k>& tree, const EditScript<T>& script)
+    {
+        for (const TreeEdit<T>& edit : script)
+        {
+            // Walk to the edited node, or to the parent of the slot for insertions and removals
+            bool toParent = edit.kind != TreeEdit<T>::Kind::Change && !edit.path.empty();
+            size_t steps = edit.path.size() - (toParent ? 1 : 0);
+            Node<T>* node = tree.root;
+            for (size_t i = 0; i < steps && node; ++i)
+            {
+                node = edit.path[i] < node->get_children().size() ? node->get_children()[edit.path[i]] : nullptr;
+            }
+
+            if (edit.kind == TreeEdit<T>::Kind::Change)
+            {
+                if (!node || edit.values.size() != 1)
+                {
+                    throw std::invalid_argument("apply_patch: change of a missing node.");
+                }
+                tree.set_value(node, edit.values.front());
+            }
+            else if (edit.kind == TreeEdit<T>::Kind::Remove)
+            {
+                if (edit.path.empty())
+                {
+                    tree.clear();
+                }
+                else if (!node || edit.path.back() >= node->get_children().size())
+                {
+                    throw std::invalid_argument("apply_patch: removal of a missing node.");
+                }
+                else
+                {
+                    tree.remove_sub_node(node, edit.path.back());
+                }
+            }
+            else
+            {
+                bool fits = edit.path.empty()
+                    ? tree.root == nullptr
+                    : node && edit.path.back() == node->get_children().size() && node->get_children().size() < static_cast<size_t>(k);
+                if (!fits)
+                {
+                    throw std::invalid_argument("apply_patch: insertion into an occupied or missing slot.");
+                }
+
+                Node<T>* subtree = detail::buildInserted<T, k>(edit);
+                if (edit.path.empty())
+                {
+                    tree.add_root(subtree);
+                }
+                else
+                {
+                    tree.add_sub_node(node, subtree);
+                }
+            }
+        }
+    }
+}
+
+#endif
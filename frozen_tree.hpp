@@ -0,0 +1,337 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef FROZENTREE_HPP
+#define FROZENTREE_HPP
+
+#include "serialization.hpp"
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ori {
+
+    template <typename T>
+    class FrozenTree;
+
+
+/**
+ * @class FrozenNode
+ * @brief Lightweight handle to one node of a FrozenTree: the tree and the node's BFS position.
+ *
+ * Values are decoded from the mapped bytes on every get_value() call, so handles are cheap to copy
+ * and hold no data of their own.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ */
+template <typename T>
+class FrozenNode {
+
+    private:
+
+        const FrozenTree<T>* tree = nullptr;    // The tree the node belongs to
+        size_t position = 0;                    // BFS position of the node
+
+    public:
+
+        FrozenNode() {}
+        FrozenNode(const FrozenTree<T>* owner, size_t bfsPosition) : tree(owner), position(bfsPosition) {}
+
+
+        /**
+         * @brief Retrieves the value of the node.
+         */
+        T get_value() const
+        {
+            return this->tree->value_at(this->position);
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of the node.
+         */
+        size_t child_count() const
+        {
+            return this->tree->child_count_at(this->position);
+        }
+
+
+        /**
+         * @brief Retrieves a child of the node.
+         * @param index The position of the child among its siblings.
+         */
+        FrozenNode child(size_t index) const
+        {
+            return FrozenNode(this->tree, this->tree->child_at(this->position, index));
+        }
+
+
+        /**
+         * @brief Retrieves the BFS position of the node in the file.
+         */
+        size_t index() const
+        {
+            return this->position;
+        }
+
+
+        bool operator==(const FrozenNode& other) const
+        {
+            return this->tree == other.tree && this->position == other.position;
+        }
+
+        bool operator!=(const FrozenNode& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+/**
+ * @class FrozenIterator
+ * @brief Iterator over a FrozenTree, either breadth-first or depth-first (pre-order).
+ *
+ * The file is stored in BFS order, so the breadth-first walk is a sequential scan of the columns
+ * with no queue at all; the depth-first walk keeps a stack of BFS positions.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ */
+template <typename T>
+class FrozenIterator {
+
+    private:
+
+        const FrozenTree<T>* tree;      // The walked tree, or nullptr for an end iterator
+        bool breadthFirst;              // Traversal order
+        FrozenNode<T> current;          // The current node
+        size_t next = 0;                // BFS: position of the next node
+        std::vector<size_t> stack;      // DFS: positions still to visit, the next one on top
+
+        /**
+         * @brief Moves to the next position, or becomes an end iterator.
+         */
+        void advance()
+        {
+            if (this->breadthFirst && this->next < this->tree->size())
+            {
+                this->current = FrozenNode<T>(this->tree, this->next++);
+                return;
+            }
+            if (!this->breadthFirst && !this->stack.empty())
+            {
+                size_t position = this->stack.back();
+                this->stack.pop_back();
+                this->current = FrozenNode<T>(this->tree, position);
+
+                // Push the children in reverse order so that the first child is visited first
+                size_t count = this->tree->child_count_at(position);
+                for (size_t i = count; i > 0; --i)
+                {
+                    this->stack.push_back(this->tree->child_at(position, i - 1));
+                }
+                return;
+            }
+            this->tree = nullptr;
+            this->current = FrozenNode<T>();
+        }
+
+    public:
+
+        /**
+         * @brief Constructs an iterator at the root of a tree, or an end iterator when `owner` is nullptr or empty.
+         * @param owner The tree to walk.
+         * @param bfs True for breadth-first order, false for depth-first pre-order.
+         */
+        FrozenIterator(const FrozenTree<T>* owner, bool bfs) : tree(owner), breadthFirst(bfs)
+        {
+            if (this->tree && this->tree->size() > 0 && !this->breadthFirst) this->stack.push_back(0);
+            if (this->tree) this->advance();
+        }
+
+
+        const FrozenNode<T>& operator*() const
+        {
+            return this->current;
+        }
+
+
+        const FrozenNode<T>* operator->() const
+        {
+            return &this->current;
+        }
+
+
+        FrozenIterator& operator++()
+        {
+            this->advance();
+            return *this;
+        }
+
+
+        bool operator==(const FrozenIterator& other) const
+        {
+            return this->tree == other.tree && this->current == other.current;
+        }
+
+
+        bool operator!=(const FrozenIterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+/**
+ * @class FrozenTree
+ * @brief Read-only tree view over a memory-mapped file in the frozen binary format (see write_frozen_tree).
+ *
+ * Opening a file maps it and checks its header and size, nothing more: no node is parsed or
+ * allocated, so the cost does not depend on the tree size and pages are read by the operating
+ * system only when a traversal touches them. Links are BFS positions stored in the file, and
+ * values are decoded from their fixed-width encoding on access.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes (int, double or Complex).
+ */
+template <typename T>
+class FrozenTree {
+
+    private:
+
+        const unsigned char* data = nullptr;    // The mapped file
+        size_t length = 0;                      // Size of the mapping in bytes
+        size_t count = 0;                       // Number of nodes
+        const unsigned char* links = nullptr;   // Link column: first child of every node, then the node count
+        const unsigned char* values = nullptr;  // Value column
+
+    public:
+
+        /**
+         * @brief Maps a frozen tree file.
+         * @param path The file to open.
+         * @throws std::runtime_error if the file cannot be mapped, is not a frozen tree of T, or is too short.
+         */
+        explicit FrozenTree(const std::string& path)
+        {
+            static_assert(ValueCodec<T>::width != 0, "Only fixed-width values can be frozen.");
+
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) throw std::runtime_error("FrozenTree: cannot open " + path + ".");
+            struct stat info;
+            if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(TreeFileHeader::SIZE))
+            {
+                ::close(fd);
+                throw std::runtime_error("FrozenTree: " + path + " is too short.");
+            }
+            this->length = static_cast<size_t>(info.st_size);
+            void* mapping = ::mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (mapping == MAP_FAILED) throw std::runtime_error("FrozenTree: cannot map " + path + ".");
+            this->data = static_cast<const unsigned char*>(mapping);
+
+            // The header fields sit at fixed offsets (see TreeFileHeader)
+            const unsigned char* h = this->data;
+            uint64_t nodeCount = load_uint(h + 16, 8);
+            bool valid = std::string(reinterpret_cast<const char*>(h), 4) == std::string(TreeFileHeader::MAGIC, 4)
+                && load_uint(h + 4, 2) == TreeFileHeader::VERSION
+                && h[6] == ValueCodec<T>::tag
+                && (load_uint(h + 12, 4) & TreeFileHeader::FROZEN)
+                && (h[7] == 1 || h[7] == 4)
+                && nodeCount < this->length;
+            TreeFileHeader header;
+            header.countWidth = h[7];
+            header.nodeCount = nodeCount;
+            if (!valid || header.values_offset() + nodeCount * ValueCodec<T>::width > this->length)
+            {
+                ::munmap(mapping, this->length);
+                throw std::runtime_error("FrozenTree: " + path + " is not a frozen tree of this value type.");
+            }
+
+            this->count = static_cast<size_t>(nodeCount);
+            this->links = this->data + header.links_offset();
+            this->values = this->data + header.values_offset();
+        }
+
+
+        FrozenTree(const FrozenTree&) = delete;
+        FrozenTree& operator=(const FrozenTree&) = delete;
+
+
+        /**
+         * @brief Destructor that unmaps the file.
+         */
+        ~FrozenTree()
+        {
+            ::munmap(const_cast<unsigned char*>(this->data), this->length);
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes.
+         */
+        size_t size() const
+        {
+            return this->count;
+        }
+
+
+        /**
+         * @brief Retrieves the root.
+         * @throws std::logic_error if the tree is empty.
+         */
+        FrozenNode<T> get_root() const
+        {
+            if (this->count == 0) throw std::logic_error("FrozenTree: the tree is empty.");
+            return FrozenNode<T>(this, 0);
+        }
+
+
+        /**
+         * @brief Decodes the value of the node at a BFS position.
+         */
+        T value_at(size_t position) const
+        {
+            return ValueCodec<T>::decode(this->values + position * ValueCodec<T>::width);
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of the node at a BFS position.
+         */
+        size_t child_count_at(size_t position) const
+        {
+            return static_cast<size_t>(load_uint(this->links + 8 * (position + 1), 8) - load_uint(this->links + 8 * position, 8));
+        }
+
+
+        /**
+         * @brief Retrieves the BFS position of a child of the node at a BFS position.
+         * @throws std::out_of_range if the link points outside the file (a corrupt file).
+         */
+        size_t child_at(size_t position, size_t index) const
+        {
+            uint64_t child = load_uint(this->links + 8 * position, 8) + index;
+            if (child >= this->count) throw std::out_of_range("FrozenTree: child link outside the tree.");
+            return static_cast<size_t>(child);
+        }
+
+
+        // Iterator access functions, with the same names as in Tree
+        FrozenIterator<T> begin_bfs_scan() const { return FrozenIterator<T>(this, true); }
+        FrozenIterator<T> end_bfs_scan() const { return FrozenIterator<T>(nullptr, true); }
+
+        FrozenIterator<T> begin() const { return begin_bfs_scan(); }
+        FrozenIterator<T> end() const { return end_bfs_scan(); }
+
+        FrozenIterator<T> begin_dfs_scan() const { return FrozenIterator<T>(this, false); }
+        FrozenIterator<T> end_dfs_scan() const { return FrozenIterator<T>(nullptr, false); }
+
+        FrozenIterator<T> begin_pre_order() const { return FrozenIterator<T>(this, false); }
+        FrozenIterator<T> end_pre_order() const { return FrozenIterator<T>(nullptr, false); }
+    };
+}
+
+#endif
@@ -0,0 +1,59 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef HASHING_HPP
+#define HASHING_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace ori {
+
+    /**
+     * @brief Scrambles the bits of a hash value (the murmur3 64-bit finalizer).
+     * std::hash is the identity for integers, so hashes are mixed before being used as table
+     * positions, filter bits or building blocks of other hashes.
+     * @param h The hash to mix.
+     * @return The mixed hash.
+     */
+    inline uint64_t mix_hash(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+
+    /**
+     * @brief Combines a hash into a running seed, order-sensitively.
+     * @param seed The running hash.
+     * @param h The hash to add.
+     * @return The combined hash.
+     */
+    inline uint64_t hash_combine(uint64_t seed, uint64_t h)
+    {
+        return mix_hash(seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+    }
+
+
+    /**
+     * @brief Detects whether std::hash is enabled for a type.
+     * The optional Tree features that hash node values are compiled only for such types, so a
+     * Tree of any other type keeps working without them.
+     */
+    template <typename T, typename = void>
+    struct is_hashable : std::false_type {};
+
+    template <typename T>
+    struct is_hashable<T, std::void_t<decltype(std::hash<T>()(std::declval<const T&>()))>> : std::true_type {};
+
+    template <typename T>
+    inline constexpr bool is_hashable_v = is_hashable<T>::value;
+}
+
+#endif
@@ -15,13 +15,14 @@ namespace ori {
  * @brief Iterator for traversing a tree structure as if it were a min heap.
  *
  * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam N The node type: Node<T>, or another type with get_value() and get_children() such as LazyNode<T>.
  */
-template <typename T>
+template <typename T, typename N = Node<T>>
 class HeapIterator {
     
     private:
 
-        vector<Node<T>*> heap;      // Vector to store the nodes in heap order
+        vector<N*> heap;            // Vector to store the nodes in heap order
 
         /**
          * @struct CompareNodes
@@ -37,7 +38,7 @@ class HeapIterator {
          */
         struct CompareNodes 
         {
-            bool operator()(Node<T>* a, Node<T>* b) 
+            bool operator()(N* a, N* b) 
             {
                 return a->get_value() > b->get_value(); 
             }
@@ -50,7 +51,7 @@ class HeapIterator {
          * 
          * @param node The current node to collect.
          */
-        void collectNodes(Node<T>* node) 
+        void collectNodes(N* node) 
         {
             if (node) 
             {
@@ -74,7 +75,7 @@ class HeapIterator {
          * 
          * @param node The root node of the tree from which to create the heap.
          */
-        HeapIterator(Node<T>* node) 
+        HeapIterator(N* node) 
         {
             if (node) 
             {
@@ -98,7 +99,7 @@ class HeapIterator {
          * @brief Dereference operator to access the value of the node at the top of the heap.
          * @return Reference to the value of the node currently at the front of the heap.
          */
-        Node<T>& operator*() 
+        N& operator*() 
         {
             return *this->heap.front();
         }
@@ -108,7 +109,7 @@ class HeapIterator {
          * @brief Arrow operator to facilitate access to the current top node's members.
          * @return Pointer to the node currently at the front of the heap.
          */
-        Node<T>* operator->() 
+        N* operator->() 
         {
             return this->heap.front();
         }
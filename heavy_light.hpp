@@ -0,0 +1,210 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef HEAVYLIGHT_HPP
+#define HEAVYLIGHT_HPP
+
+#include "node.hpp"
+#include "tree_index.hpp"
+#include "segment_tree.hpp"
+#include <vector>
+#include <optional>
+#include <functional>
+#include <utility>
+
+namespace ori {
+
+/**
+ * @class HeavyLightDecomposition
+ * @brief Path aggregate queries (sum, max, ...) and point updates on a tree of fixed shape.
+ *
+ * Every node continues the chain of its largest child (the heavy child). The chains are laid out
+ * contiguously and a segment tree combines the values along them. Any path crosses O(log n)
+ * chains, so a path query costs O(log^2 n) and a point update O(log n).
+ *
+ * The path is combined chain by chain, so the combine function should be commutative
+ * (sum, min, max). Like SubtreeAggregate, the structure keeps its own copy of the values.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam Combine Associative and commutative functor merging two values (std::plus<T> by default).
+ */
+template <typename T, typename Combine = std::plus<T>>
+class HeavyLightDecomposition {
+
+    private:
+
+        const TreeIndex<T>& index;          // Tour positions, parents and depths of the nodes
+        std::vector<size_t> head;           // Tour position of the top of the chain of each tour position
+        std::vector<size_t> chainPosition;  // Position of each tour position in the chain layout
+        std::optional<SegmentTree<T, Combine>> segments;    // Aggregates over the chain layout
+        Combine combine;                    // The merge function
+
+
+        /**
+         * @brief Computes the heavy child of every node and lays the chains out one after the other.
+         */
+        void decompose()
+        {
+            size_t n = this->index.size();
+            std::vector<size_t> heavy(n, TreeIndex<T>::npos);
+
+            // The children of v start at v + 1 and each next sibling starts right after the previous subtree
+            for (size_t v = 0; v < n; ++v)
+            {
+                size_t best = 0;
+                for (size_t c = v + 1; c <= this->index.exit_at(v); c = this->index.exit_at(c) + 1)
+                {
+                    size_t size = this->index.exit_at(c) + 1 - c;
+                    if (size > best)
+                    {
+                        best = size;
+                        heavy[v] = c;
+                    }
+                }
+            }
+
+            this->head.assign(n, 0);
+            this->chainPosition.assign(n, 0);
+            std::vector<size_t> heads;
+            if (n > 0) heads.push_back(0);
+            size_t next = 0;
+
+            // Walk each chain down its heavy children; the light children start new chains
+            while (!heads.empty())
+            {
+                size_t top = heads.back();
+                heads.pop_back();
+                for (size_t v = top; v != TreeIndex<T>::npos; v = heavy[v])
+                {
+                    this->head[v] = top;
+                    this->chainPosition[v] = next++;
+                    for (size_t c = v + 1; c <= this->index.exit_at(v); c = this->index.exit_at(c) + 1)
+                    {
+                        if (c != heavy[v])
+                        {
+                            heads.push_back(c);
+                        }
+                    }
+                }
+            }
+        }
+
+
+        /**
+         * @brief Merges a partial result into an accumulator.
+         */
+        void accumulate(std::optional<T>& total, const T& part) const
+        {
+            total = total ? this->combine(*total, part) : part;
+        }
+
+    public:
+
+        /**
+         * @brief Builds the decomposition in O(n).
+         * @param treeIndex The Euler-tour index of the tree, which must outlive this object.
+         * @param merge The combine function.
+         */
+        HeavyLightDecomposition(const TreeIndex<T>& treeIndex, Combine merge = Combine()) : index(treeIndex), combine(merge)
+        {
+            this->decompose();
+
+            size_t n = this->index.size();
+            if (n == 0) return;
+
+            std::vector<T> values(n, this->index.at(0)->get_value());
+            for (size_t v = 0; v < n; ++v)
+            {
+                values[this->chainPosition[v]] = this->index.at(v)->get_value();
+            }
+            this->segments.emplace(values, merge);
+        }
+
+
+        /**
+         * @brief Combines the values along the path between two tour positions (both endpoints included).
+         * @param a Tour position of the first endpoint.
+         * @param b Tour position of the second endpoint.
+         * @return The aggregate of the path.
+         */
+        T query_at(size_t a, size_t b) const
+        {
+            std::optional<T> total;
+
+            // Lift the endpoint whose chain head is deeper until both lie on the same chain
+            while (this->head[a] != this->head[b])
+            {
+                if (this->index.depth_at(this->head[a]) < this->index.depth_at(this->head[b]))
+                {
+                    std::swap(a, b);
+                }
+                this->accumulate(total, this->segments->query(this->chainPosition[this->head[a]], this->chainPosition[a] + 1));
+                a = this->index.parent_at(this->head[a]);
+            }
+
+            if (this->chainPosition[a] > this->chainPosition[b])
+            {
+                std::swap(a, b);
+            }
+            this->accumulate(total, this->segments->query(this->chainPosition[a], this->chainPosition[b] + 1));
+            return *total;
+        }
+
+
+        /**
+         * @brief Combines the values along the path between two nodes (both endpoints included).
+         * @param a The first endpoint.
+         * @param b The second endpoint.
+         * @return The aggregate of the path.
+         */
+        T query(const Node<T>* a, const Node<T>* b) const
+        {
+            return this->query_at(this->index.entry(a), this->index.entry(b));
+        }
+
+
+        /**
+         * @brief Combines the values along the path from the root to a node.
+         * @param node The lower endpoint of the path.
+         * @return The aggregate of the path.
+         */
+        T query_from_root(const Node<T>* node) const
+        {
+            return this->query_at(0, this->index.entry(node));
+        }
+
+
+        /**
+         * @brief Retrieves the current value of a node as seen by this structure.
+         * @param node The node to look up.
+         */
+        const T& value(const Node<T>* node) const
+        {
+            return this->segments->get(this->chainPosition[this->index.entry(node)]);
+        }
+
+
+        /**
+         * @brief Replaces the value of a node.
+         * @param node The node to update.
+         * @param value The new value.
+         */
+        void set(const Node<T>* node, const T& value)
+        {
+            this->segments->set(this->chainPosition[this->index.entry(node)], value);
+        }
+
+
+        /**
+         * @brief Adds a delta to the value of a node (requires operator+ on T).
+         * @param node The node to update.
+         * @param delta The amount to add.
+         */
+        void add(const Node<T>* node, const T& delta)
+        {
+            size_t position = this->chainPosition[this->index.entry(node)];
+            this->segments->set(position, this->segments->get(position) + delta);
+        }
+    };
+}
+
+#endif
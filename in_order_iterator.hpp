@@ -5,6 +5,9 @@
 
 #include "node.hpp"
 #include <stack>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 #include <algorithm>
 
 namespace ori {
@@ -14,14 +17,15 @@ namespace ori {
  * @brief Iterator for performing in-order traversal of a binary tree: LEFT->ROOT->RIGHT.
  * 
  * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam N The node type: Node<T>, or another type with get_value() and get_children() such as LazyNode<T>.
  */
-template <typename T>
+template <typename T, typename N = Node<T>>
 class InOrderIterator {
     
     private:
 
-        Node<T>* current;                // Pointer to the current node in the traversal
-        std::stack<Node<T>*> stack;      // Stack used to manage the traversal of nodes
+        N* current;                      // Pointer to the current node in the traversal
+        std::stack<N*> stack;            // Stack used to manage the traversal of nodes
 
 
         /**
@@ -30,11 +34,12 @@ class InOrderIterator {
          * This function ensures that the traversal starts with the leftmost node.
          * @param node The node from which to start pushing left children.
          */
-        void pushLeft(Node<T>* node) 
+        void pushLeft(N* node) 
         {
             while (node != nullptr) 
             {
                 // Push the current node onto the stack
+                this->checkBinary(node);
                 this->stack.push(node);
 
                 // Check if the current node has children and if there is a left child
@@ -50,22 +55,36 @@ class InOrderIterator {
         }
 
 
+        /**
+         * @brief Helper function to check that a node has at most two children.
+         * @param node The node to check.
+         * @throws std::invalid_argument if the node has more than two children.
+         */
+        static void checkBinary(N* node)
+        {
+            if (node->get_children().size() > 2) 
+            {
+                throw std::invalid_argument("InOrderIterator can only be used on binary trees.");
+            }
+        }
+
+
         /**
          * @brief Helper function to validate that the tree is binary.
-         * Recursively checks all nodes in the tree to ensure no node has more than two children.
+         * Iteratively checks all nodes in the tree to ensure no node has more than two children.
          * @param node The node from which to start the validation.
          * @throws std::invalid_argument if any node has more than two children.
          */
-        void validateBinaryTree(Node<T>* node)
+        static void validateBinaryTree(N* node)
         {
-            if (!node) return;
-            for (const auto& child : node->get_children()) 
+            std::vector<N*> pending;
+            if (node) pending.push_back(node);
+            while (!pending.empty()) 
             {
-                if (node->get_children().size() > 2) 
-                {
-                    throw std::invalid_argument("InOrderIterator can only be used on binary trees.");
-                }
-                validateBinaryTree(child);
+                N* next = pending.back();
+                pending.pop_back();
+                checkBinary(next);
+                pending.insert(pending.end(), next->get_children().begin(), next->get_children().end());
             }
         }
 
@@ -78,9 +97,11 @@ class InOrderIterator {
          * 
          * @param root The root node of the tree from which to start the in-order traversal.
          */
-        InOrderIterator(Node<T>* root) 
+        InOrderIterator(N* root) 
         {
-            validateBinaryTree(root);         // Validate the tree to ensure it is binary
+            // In-memory trees are validated up front; other node types such as LazyNode are checked
+            // node by node as the walk reaches them, so opening the iterator does not load the whole tree
+            if constexpr (std::is_same_v<N, Node<T>>) validateBinaryTree(root);
 
             this->current = nullptr;
             this->pushLeft(root);             // Initialize the stack by pushing left children starting from the root (included)
@@ -103,7 +124,7 @@ class InOrderIterator {
          * @brief Dereference operator to access the current node's value.
          * @return Reference to the current node.
          */
-        Node<T>& operator*() const 
+        N& operator*() const 
         {
             return *this->current;
         }
@@ -113,7 +134,7 @@ class InOrderIterator {
          * @brief Arrow operator to able access to the current node's members.
          * @return Pointer to the current node.
          */
-        Node<T>* operator->() const 
+        N* operator->() const 
         {
             return this->current;
         }
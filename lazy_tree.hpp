@@ -0,0 +1,344 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef LAZYTREE_HPP
+#define LAZYTREE_HPP
+
+#include "node.hpp"
+#include "serialization.hpp"
+#include "pre_order_iterator.hpp"
+#include "post_order_iterator.hpp"
+#include "in_order_iterator.hpp"
+#include "bfs_iterator.hpp"
+#include "dfs_iterator.hpp"
+#include "heap_iterator.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ori {
+
+    template <typename T>
+    class LazyNode;
+
+
+    /**
+    * @brief Source of the children of lazily loaded nodes (see LazyTree).
+    * A LazyNode holding a loader and a position materialises its children through it on the first
+    * get_children() call.
+    *
+    * @tparam T The data type of the value stored in the nodes.
+    */
+    template <typename T>
+    class ChildLoader {
+
+        public:
+
+            virtual ~ChildLoader() = default;
+
+            /**
+             * @brief Creates the children of a node.
+             * @param parent The node whose children are requested; the loader makes it their parent.
+             * @param position The position the node was registered with.
+             * @return The new children, in order.
+             */
+            virtual std::vector<LazyNode<T>*> load_children(LazyNode<T>* parent, uint64_t position) = 0;
+    };
+
+
+    /**
+    * @brief Node of a LazyTree: a value, a parent, and children that are created on first access.
+    * Lazy loading lives here rather than in Node, so ordinary trees pay nothing for it.
+    *
+    * @tparam T The data type of the value stored in the node.
+    */
+    template <typename T>
+    class LazyNode {
+
+        private:
+
+            T value;                                // The value stored in the node
+            std::vector<LazyNode<T>*> children;     // The child nodes, once loaded
+            LazyNode<T>* parent;                    // The parent node (nullptr for the root)
+            ChildLoader<T>* loader = nullptr;       // Source of the children while they are not loaded yet
+            uint64_t loaderPosition = 0;            // Position of the node in the loader's source
+
+        public:
+
+            /**
+             * @brief Constructor that initializes the node with a value and a parent.
+             * @param val The value to be stored in the node.
+             * @param up The parent node (nullptr for the root).
+             */
+            LazyNode(const T& val, LazyNode<T>* up = nullptr) : value(val), parent(up) {}
+
+
+            /**
+             * @brief Retrieves the value stored in the node.
+             */
+            const T& get_value() const
+            {
+                return this->value;
+            }
+
+            /**
+             * @brief Retrieves the parent node, or nullptr for the root.
+             */
+            LazyNode<T>* get_parent() const
+            {
+                return this->parent;
+            }
+
+            /**
+             * @brief Provides access to the child nodes, loading them first if needed.
+             * There is no const overload: loading modifies the node, so a const node cannot trigger it.
+             * @throws std::runtime_error if the loader fails; the node stays unloaded and may be retried.
+             */
+            std::vector<LazyNode<T>*>& get_children()
+            {
+                if (this->loader)
+                {
+                    this->children = this->loader->load_children(this, this->loaderPosition);
+                    this->loader = nullptr;
+                }
+                return this->children;
+            }
+
+            /**
+             * @brief Makes the node lazy: its children will be created by a loader on first access.
+             * @param source The loader, which must outlive the node or load its children first.
+             * @param position The position of the node in the loader's source.
+             */
+            void set_child_loader(ChildLoader<T>* source, uint64_t position)
+            {
+                this->loader = source;
+                this->loaderPosition = position;
+            }
+
+            /**
+             * @brief Checks whether the children of the node are in memory.
+             */
+            bool children_loaded() const
+            {
+                return this->loader == nullptr;
+            }
+    };
+
+
+/**
+ * @class LazyTree
+ * @brief Tree of LazyNodes loaded from a frozen tree file (see write_frozen_tree) one level at a time, on demand.
+ *
+ * Opening reads the header and the root only. Every node that has children in the file starts as a
+ * stub holding its BFS position; the first get_children() call on it reads its child range from the
+ * link column and the children's values with pread, and creates the children, again as stubs. The
+ * traversal iterators are instantiated for LazyNode, so they work unchanged, and memory grows only
+ * with the part of the tree actually visited. Materialised nodes stay in memory until the tree is destroyed.
+ *
+ * Loading happens inside get_children(), so it may throw std::runtime_error on a read error or a
+ * corrupt file, and a LazyTree must not be walked from several threads at once.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes (int, double or Complex).
+ * @tparam k Maximum number of children each node can have.
+ */
+template <typename T, int k = 2>
+class LazyTree : private ChildLoader<T> {
+
+    private:
+
+        int fd = -1;                                    // The open file
+        size_t count = 0;                               // Number of nodes in the file
+        uint64_t linksAt = 0;                           // File offset of the link column
+        uint64_t valuesAt = 0;                          // File offset of the value column
+        LazyNode<T>* root = nullptr;                        // The root, or nullptr for an empty tree
+        std::vector<std::unique_ptr<LazyNode<T>>> nodes;    // The materialised nodes
+
+
+        /**
+         * @brief Reads exactly `size` bytes at a file offset.
+         * @throws std::runtime_error if the file is shorter or cannot be read.
+         */
+        void readAt(unsigned char* data, size_t size, uint64_t offset) const
+        {
+            while (size > 0)
+            {
+                ssize_t got = ::pread(this->fd, data, size, static_cast<off_t>(offset));
+                if (got <= 0) throw std::runtime_error("LazyTree: cannot read the tree file.");
+                data += got;
+                size -= static_cast<size_t>(got);
+                offset += static_cast<uint64_t>(got);
+            }
+        }
+
+
+        /**
+         * @brief Creates a materialised node, as a stub when it has children in the file.
+         */
+        LazyNode<T>* makeNode(const T& value, LazyNode<T>* parent, uint64_t position, bool hasChildren)
+        {
+            this->nodes.push_back(std::make_unique<LazyNode<T>>(value, parent));
+            LazyNode<T>* node = this->nodes.back().get();
+            if (hasChildren) node->set_child_loader(this, position);
+            return node;
+        }
+
+
+        /**
+         * @brief Reads the children of the node at a BFS position: its link range, then their values
+         * and links (to know which of them are leaves), three preads in all.
+         */
+        std::vector<LazyNode<T>*> load_children(LazyNode<T>* parent, uint64_t position) override
+        {
+            unsigned char range[16];
+            this->readAt(range, sizeof(range), this->linksAt + 8 * position);
+            uint64_t first = load_uint(range, 8);
+            uint64_t last = load_uint(range + 8, 8);
+            if (first > last || last > this->count || last - first > static_cast<uint64_t>(k))
+            {
+                throw std::runtime_error("LazyTree: corrupt link column.");
+            }
+
+            size_t children = static_cast<size_t>(last - first);
+            std::vector<unsigned char> values(children * ValueCodec<T>::width);
+            std::vector<unsigned char> links(8 * (children + 1));
+            this->readAt(values.data(), values.size(), this->valuesAt + first * ValueCodec<T>::width);
+            this->readAt(links.data(), links.size(), this->linksAt + 8 * first);
+
+            std::vector<LazyNode<T>*> created;
+            created.reserve(children);
+            for (size_t i = 0; i < children; ++i)
+            {
+                bool hasChildren = load_uint(links.data() + 8 * (i + 1), 8) > load_uint(links.data() + 8 * i, 8);
+                LazyNode<T>* child = this->makeNode(ValueCodec<T>::decode(values.data() + i * ValueCodec<T>::width), parent, first + i, hasChildren);
+                created.push_back(child);
+            }
+            return created;
+        }
+
+    public:
+
+        /**
+         * @brief Opens a frozen tree file, reading only its header and root.
+         * @param path The file written by write_frozen_tree.
+         * @throws std::runtime_error if the file cannot be opened, is not a frozen tree of T, needs a larger k, or is too short.
+         */
+        explicit LazyTree(const std::string& path)
+        {
+            static_assert(ValueCodec<T>::width != 0, "Only fixed-width values can be loaded lazily.");
+
+            this->fd = ::open(path.c_str(), O_RDONLY);
+            if (this->fd < 0) throw std::runtime_error("LazyTree: cannot open " + path + ".");
+            try
+            {
+                BinaryReader in(this->fd, TreeFileHeader::SIZE);
+                TreeFileHeader header = TreeFileHeader::read(in);
+                if (header.valueType != ValueCodec<T>::tag || !(header.flags & TreeFileHeader::FROZEN))
+                {
+                    throw std::runtime_error("LazyTree: " + path + " is not a frozen tree of this value type.");
+                }
+                if (header.k > static_cast<uint32_t>(k))
+                {
+                    throw std::runtime_error("LazyTree: " + path + " needs a larger k.");
+                }
+
+                struct stat info;
+                if (::fstat(this->fd, &info) != 0
+                    || header.values_offset() + header.nodeCount * ValueCodec<T>::width > static_cast<uint64_t>(info.st_size))
+                {
+                    throw std::runtime_error("LazyTree: " + path + " is too short.");
+                }
+
+                this->count = static_cast<size_t>(header.nodeCount);
+                this->linksAt = header.links_offset();
+                this->valuesAt = header.values_offset();
+                if (this->count > 0)
+                {
+                    unsigned char bytes[16];
+                    this->readAt(bytes, sizeof(bytes), this->linksAt);
+                    bool hasChildren = load_uint(bytes + 8, 8) > load_uint(bytes, 8);
+                    this->readAt(bytes, ValueCodec<T>::width, this->valuesAt);
+                    this->root = this->makeNode(ValueCodec<T>::decode(bytes), nullptr, 0, hasChildren);
+                }
+            }
+            catch (...)
+            {
+                ::close(this->fd);
+                throw;
+            }
+        }
+
+
+        LazyTree(const LazyTree&) = delete;
+        LazyTree& operator=(const LazyTree&) = delete;
+
+
+        /**
+         * @brief Destructor that frees the materialised nodes (without loading the rest) and closes the file.
+         */
+        ~LazyTree()
+        {
+            ::close(this->fd);
+        }
+
+
+        /**
+         * @brief Retrieves the root, or nullptr for an empty tree.
+         */
+        LazyNode<T>* get_root() const
+        {
+            return this->root;
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes in the file.
+         */
+        size_t size() const
+        {
+            return this->count;
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes materialised so far.
+         */
+        size_t loaded_size() const
+        {
+            return this->nodes.size();
+        }
+
+
+        // Iterator access functions, with the same traversal orders as Tree; they load nodes as they reach them,
+        // and the binary walks reject a node with more than two children only once they reach it
+        PreOrderIterator<T, LazyNode<T>> begin_pre_order() const { return PreOrderIterator<T, LazyNode<T>>(root); }
+        PreOrderIterator<T, LazyNode<T>> begin_pre_order(size_t maxDepth) const { return PreOrderIterator<T, LazyNode<T>>(root, maxDepth); }
+        PreOrderIterator<T, LazyNode<T>> end_pre_order() const { return PreOrderIterator<T, LazyNode<T>>(nullptr); }
+
+        PostOrderIterator<T, LazyNode<T>> begin_post_order() const { return PostOrderIterator<T, LazyNode<T>>(root); }
+        PostOrderIterator<T, LazyNode<T>> end_post_order() const { return PostOrderIterator<T, LazyNode<T>>(nullptr); }
+
+        InOrderIterator<T, LazyNode<T>> begin_in_order() const { return InOrderIterator<T, LazyNode<T>>(root); }
+        InOrderIterator<T, LazyNode<T>> end_in_order() const { return InOrderIterator<T, LazyNode<T>>(nullptr); }
+
+        BFSIterator<T, LazyNode<T>> begin_bfs_scan() const { return BFSIterator<T, LazyNode<T>>(root); }
+        BFSIterator<T, LazyNode<T>> begin_bfs_scan(size_t maxDepth) const { return BFSIterator<T, LazyNode<T>>(root, maxDepth); }
+        BFSIterator<T, LazyNode<T>> end_bfs_scan() const { return BFSIterator<T, LazyNode<T>>(nullptr); }
+
+        BFSIterator<T, LazyNode<T>> begin() const { return begin_bfs_scan(); }
+        BFSIterator<T, LazyNode<T>> end() const { return end_bfs_scan(); }
+
+        DFSIterator<T, LazyNode<T>> begin_dfs_scan() const { return DFSIterator<T, LazyNode<T>>(root); }
+        DFSIterator<T, LazyNode<T>> begin_dfs_scan(size_t maxDepth) const { return DFSIterator<T, LazyNode<T>>(root, maxDepth); }
+        DFSIterator<T, LazyNode<T>> end_dfs_scan() const { return DFSIterator<T, LazyNode<T>>(nullptr); }
+
+        // The heap walk needs every value before its first step, so it loads the whole tree
+        HeapIterator<T, LazyNode<T>> myHeap() const { return HeapIterator<T, LazyNode<T>>(root); }
+        HeapIterator<T, LazyNode<T>> end_heap() const { return HeapIterator<T, LazyNode<T>>(nullptr); }
+    };
+}
+
+#endif
@@ -0,0 +1,311 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef LCA_HPP
+#define LCA_HPP
+
+#include "node.hpp"
+#include "tree_index.hpp"
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+
+namespace ori {
+
+/**
+ * @class BinaryLiftingLCA
+ * @brief Lowest-common-ancestor queries by binary lifting, O(log n) per query.
+ *
+ * For every node the table stores its 2^j-th ancestor. A query climbs from one node using
+ * the largest jumps that do not reach an ancestor of the other node, relying on the O(1)
+ * ancestor test of TreeIndex.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ */
+template <typename T>
+class BinaryLiftingLCA {
+
+    private:
+
+        const TreeIndex<T>& index;              // The Euler-tour index the table is built on
+        std::vector<std::vector<uint32_t>> up;  // up[j][v] = tour position of the 2^j-th ancestor of v (the root for jumps past it)
+
+    public:
+
+        /**
+         * @brief Builds the jump table in O(n log n).
+         * @param treeIndex The index of the tree, which must outlive this object.
+         * @throws std::length_error if the tree has more nodes than 32-bit tour positions can address.
+         */
+        BinaryLiftingLCA(const TreeIndex<T>& treeIndex) : index(treeIndex)
+        {
+            size_t n = this->index.size();
+            if (n == 0) return;
+            if (n > UINT32_MAX) throw std::length_error("BinaryLiftingLCA: the tree has more than 2^32 - 1 nodes.");
+
+            // First level: the direct parent (the root points to itself)
+            this->up.emplace_back(n);
+            for (size_t v = 0; v < n; ++v)
+            {
+                size_t parent = this->index.parent_at(v);
+                this->up[0][v] = static_cast<uint32_t>(parent == TreeIndex<T>::npos ? 0 : parent);
+            }
+
+            // Every further level doubles the jump length, until a jump covers the whole tree
+            for (size_t length = 2; length < n; length *= 2)
+            {
+                const std::vector<uint32_t>& previous = this->up.back();
+                std::vector<uint32_t> next(n);
+                for (size_t v = 0; v < n; ++v)
+                {
+                    next[v] = previous[previous[v]];
+                }
+                this->up.push_back(std::move(next));
+            }
+        }
+
+
+        /**
+         * @brief Finds the lowest common ancestor of two tour positions.
+         * @param a Tour position of the first node.
+         * @param b Tour position of the second node.
+         * @return Tour position of the lowest common ancestor.
+         */
+        size_t query_at(size_t a, size_t b) const
+        {
+            if (this->index.is_ancestor_at(a, b)) return a;
+            if (this->index.is_ancestor_at(b, a)) return b;
+
+            // Climb from a while staying strictly below the common ancestor
+            for (size_t j = this->up.size(); j-- > 0;)
+            {
+                size_t candidate = this->up[j][a];
+                if (!this->index.is_ancestor_at(candidate, b))
+                {
+                    a = candidate;
+                }
+            }
+            return this->up[0][a];
+        }
+
+
+        /**
+         * @brief Finds the lowest common ancestor of two nodes.
+         * @param a The first node.
+         * @param b The second node.
+         * @return Pointer to the lowest common ancestor.
+         */
+        Node<T>* query(const Node<T>* a, const Node<T>* b) const
+        {
+            return this->index.at(this->query_at(this->index.entry(a), this->index.entry(b)));
+        }
+    };
+
+
+/**
+ * @class SparseTableLCA
+ * @brief Lowest-common-ancestor queries by range-minimum over the Euler tour, O(1) per query.
+ *
+ * For two distinct nodes u and v with entry(u) < entry(v), the shallowest node in the tour
+ * range (entry(u), entry(v)] is a child of the lowest common ancestor on the path to v,
+ * so the answer is its parent. The range minimum is answered by a sparse table built in
+ * O(n log n), using the tour positions of TreeIndex directly.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ */
+template <typename T>
+class SparseTableLCA {
+
+    private:
+
+        const TreeIndex<T>& index;                  // The Euler-tour index the table is built on
+        std::vector<std::vector<uint32_t>> table;   // table[j][i] = shallowest tour position in [i, i + 2^j)
+        std::vector<uint8_t> log2;                  // log2[len] = floor(log2(len)) for range lengths
+
+
+        /**
+         * @brief Returns the shallower of two tour positions.
+         */
+        uint32_t shallower(uint32_t a, uint32_t b) const
+        {
+            return this->index.depth_at(a) <= this->index.depth_at(b) ? a : b;
+        }
+
+    public:
+
+        /**
+         * @brief Builds the sparse table in O(n log n).
+         * @param treeIndex The index of the tree, which must outlive this object.
+         * @throws std::length_error if the tree has more nodes than 32-bit tour positions can address.
+         */
+        SparseTableLCA(const TreeIndex<T>& treeIndex) : index(treeIndex)
+        {
+            size_t n = this->index.size();
+            if (n == 0) return;
+            if (n > UINT32_MAX) throw std::length_error("SparseTableLCA: the tree has more than 2^32 - 1 nodes.");
+
+            this->log2.assign(n + 1, 0);
+            for (size_t len = 2; len <= n; ++len)
+            {
+                this->log2[len] = static_cast<uint8_t>(this->log2[len / 2] + 1);
+            }
+
+            this->table.emplace_back(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                this->table[0][i] = static_cast<uint32_t>(i);
+            }
+
+            // Level j combines two halves of length 2^(j-1) from the previous level
+            for (size_t half = 1; 2 * half <= n; half *= 2)
+            {
+                const std::vector<uint32_t>& previous = this->table.back();
+                std::vector<uint32_t> next(n - 2 * half + 1);
+                for (size_t i = 0; i < next.size(); ++i)
+                {
+                    next[i] = this->shallower(previous[i], previous[i + half]);
+                }
+                this->table.push_back(std::move(next));
+            }
+        }
+
+
+        /**
+         * @brief Finds the lowest common ancestor of two tour positions.
+         * @param a Tour position of the first node.
+         * @param b Tour position of the second node.
+         * @return Tour position of the lowest common ancestor.
+         */
+        size_t query_at(size_t a, size_t b) const
+        {
+            if (a == b) return a;
+            if (a > b) std::swap(a, b);
+
+            // Shallowest position in (a, b], found by two overlapping power-of-two ranges
+            size_t first = a + 1;
+            size_t level = this->log2[b - a];
+            uint32_t best = this->shallower(this->table[level][first], this->table[level][b + 1 - (size_t(1) << level)]);
+            return this->index.parent_at(best);
+        }
+
+
+        /**
+         * @brief Finds the lowest common ancestor of two nodes.
+         * @param a The first node.
+         * @param b The second node.
+         * @return Pointer to the lowest common ancestor.
+         */
+        Node<T>* query(const Node<T>* a, const Node<T>* b) const
+        {
+            return this->index.at(this->query_at(this->index.entry(a), this->index.entry(b)));
+        }
+    };
+
+
+    /**
+     * @brief Answers a batch of lowest-common-ancestor queries offline with Tarjan's algorithm.
+     *
+     * The tour of the index is replayed as a depth-first walk. When a node is finished, every query
+     * whose other endpoint is already finished is answered by the union-find representative's
+     * ancestor, then the node is merged into its parent. The whole batch costs
+     * O((n + q) * alpha(n)) and needs no per-node tables beyond the union-find arrays.
+     *
+     * @param index The Euler-tour index of the tree.
+     * @param queries Pairs of nodes to answer.
+     * @return The lowest common ancestor of each query, in the same order.
+     */
+    template <typename T>
+    std::vector<Node<T>*> tarjan_lca(const TreeIndex<T>& index, const std::vector<std::pair<const Node<T>*, const Node<T>*>>& queries)
+    {
+        size_t n = index.size();
+        std::vector<Node<T>*> answers(queries.size(), nullptr);
+        if (n == 0) return answers;
+
+        // Group the queries by endpoint (compressed adjacency lists: start offsets + query ids)
+        std::vector<size_t> endpoints(2 * queries.size());
+        std::vector<size_t> offsets(n + 1, 0);
+        for (size_t q = 0; q < queries.size(); ++q)
+        {
+            endpoints[2 * q] = index.entry(queries[q].first);
+            endpoints[2 * q + 1] = index.entry(queries[q].second);
+            ++offsets[endpoints[2 * q] + 1];
+            ++offsets[endpoints[2 * q + 1] + 1];
+        }
+        for (size_t v = 0; v < n; ++v)
+        {
+            offsets[v + 1] += offsets[v];
+        }
+        std::vector<size_t> byNode(2 * queries.size());
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t e = 0; e < endpoints.size(); ++e)
+        {
+            byNode[fill[endpoints[e]]++] = e;
+        }
+
+        // Union-find over tour positions; `ancestor` holds the answer candidate of each set
+        std::vector<uint32_t> parent(n);
+        std::vector<uint32_t> ancestor(n);
+        std::vector<bool> finished(n, false);
+        for (size_t v = 0; v < n; ++v)
+        {
+            parent[v] = static_cast<uint32_t>(v);
+            ancestor[v] = static_cast<uint32_t>(v);
+        }
+
+        auto find = [&parent](size_t v)
+        {
+            size_t rootSet = v;
+            while (parent[rootSet] != rootSet) rootSet = parent[rootSet];
+            while (parent[v] != rootSet)
+            {
+                size_t next = parent[v];
+                parent[v] = static_cast<uint32_t>(rootSet);
+                v = next;
+            }
+            return rootSet;
+        };
+
+        auto finish = [&](size_t v)
+        {
+            finished[v] = true;
+            for (size_t i = offsets[v]; i < offsets[v + 1]; ++i)
+            {
+                size_t e = byNode[i];
+                size_t other = endpoints[e ^ 1];
+                if (finished[other] && !answers[e / 2])
+                {
+                    answers[e / 2] = index.at(ancestor[find(other)]);
+                }
+            }
+
+            // Merge the finished subtree into its parent
+            size_t up = index.parent_at(v);
+            if (up != TreeIndex<T>::npos)
+            {
+                parent[find(v)] = static_cast<uint32_t>(find(up));
+                ancestor[find(up)] = static_cast<uint32_t>(up);
+            }
+        };
+
+        // Replay the depth-first walk: a node is finished once the tour moves past its exit time
+        std::vector<size_t> open;
+        for (size_t v = 0; v < n; ++v)
+        {
+            while (!open.empty() && index.exit_at(open.back()) < v)
+            {
+                finish(open.back());
+                open.pop_back();
+            }
+            open.push_back(v);
+        }
+        while (!open.empty())
+        {
+            finish(open.back());
+            open.pop_back();
+        }
+
+        return answers;
+    }
+}
+
+#endif
@@ -4,9 +4,13 @@
 #define NODE_HPP
 
 #include <vector>
+#include <cstddef>
+#include <cstdint>
 
 namespace ori {
 
+    inline constexpr std::size_t UNLIMITED_DEPTH = static_cast<std::size_t>(-1);     // Depth limit meaning "no limit" for the traversal iterators
+
     /**
     * @brief Represents a node in a k-ary tree.
     * The Node class is a template class that holds a value of type T and has a vector of child nodes.
@@ -32,13 +36,23 @@ namespace ori {
 
             /**
              * @brief Retrieves the value stored in the node.
-             * @return The value stored in the node.
+             * @return Const reference to the value stored in the node.
              */
-            T get_value() const 
+            const T& get_value() const 
             {  
                 return value;
             }
 
+            /**
+             * @brief Replaces the value stored in the node.
+             * Nodes owned by a Tree should be updated through Tree::set_value, which keeps its indexes in sync.
+             * @param val The new value.
+             */
+            void set_value(const T& val)
+            {
+                this->value = val;
+            }
+
             /**
              * @brief Provides access to the vector of child nodes.
              * @return Reference to the vector of child nodes.
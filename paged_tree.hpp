@@ -0,0 +1,800 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef PAGEDTREE_HPP
+#define PAGEDTREE_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include "serialization.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ori {
+
+    /**
+     * @struct PageStats
+     * @brief I/O counters of a BufferPool, for tuning the page size and the memory budget.
+     */
+    struct PageStats
+    {
+        size_t hits = 0;            // Page requests served from memory
+        size_t misses = 0;          // Page requests that read the page from the file
+        size_t evictions = 0;       // Pages dropped to make room
+        size_t writebacks = 0;      // Dirty pages written to the file
+    };
+
+
+/**
+ * @class BufferPool
+ * @brief Fixed number of in-memory page frames over a file, replaced in least-recently-used order.
+ *
+ * Pages are read with pread on a miss. Modified pages are marked dirty and written back with pwrite
+ * when they are evicted or on flush(). A pointer returned by fetch() stays valid until the next
+ * fetch(), which may evict its page.
+ */
+class BufferPool {
+
+    private:
+
+        struct Frame
+        {
+            uint64_t page;
+            std::vector<unsigned char> bytes;
+            bool dirty;
+        };
+
+        int fd;                                                         // The file, owned by the caller
+        size_t pageSize;                                                // Bytes per page
+        size_t firstPage;                                               // File offset of page 0
+        size_t capacity;                                                // Maximum number of frames in memory
+        std::list<Frame> frames;                                        // Most recently used first
+        std::unordered_map<uint64_t, std::list<Frame>::iterator> table; // Page number -> frame
+        PageStats counters;
+
+
+        void writeBack(Frame& frame)
+        {
+            off_t offset = static_cast<off_t>(this->firstPage + frame.page * this->pageSize);
+            if (::pwrite(this->fd, frame.bytes.data(), this->pageSize, offset) != static_cast<ssize_t>(this->pageSize))
+            {
+                throw std::runtime_error("BufferPool: cannot write a page.");
+            }
+            frame.dirty = false;
+            ++this->counters.writebacks;
+        }
+
+    public:
+
+        /**
+         * @brief Constructs a pool over an open file.
+         * @param descriptor The file, which must stay open while the pool is used.
+         * @param bytesPerPage The page size.
+         * @param pagesOffset File offset of page 0.
+         * @param memoryBudget Bytes of page frames the pool may hold; at least one frame is always kept.
+         */
+        BufferPool(int descriptor, size_t bytesPerPage, size_t pagesOffset, size_t memoryBudget)
+            : fd(descriptor), pageSize(bytesPerPage), firstPage(pagesOffset), capacity(std::max<size_t>(1, memoryBudget / bytesPerPage)) {}
+
+
+        /**
+         * @brief Retrieves a page, reading it from the file if it is not in memory.
+         * @param page The page number.
+         * @return The page bytes, valid until the next fetch().
+         * @throws std::runtime_error if the page cannot be read or a dirty victim cannot be written.
+         */
+        unsigned char* fetch(uint64_t page)
+        {
+            auto found = this->table.find(page);
+            if (found != this->table.end())
+            {
+                ++this->counters.hits;
+                this->frames.splice(this->frames.begin(), this->frames, found->second);
+                return found->second->bytes.data();
+            }
+
+            ++this->counters.misses;
+            if (this->frames.size() >= this->capacity)
+            {
+                // Reuse the buffer of the least recently used frame
+                Frame& victim = this->frames.back();
+                if (victim.dirty) this->writeBack(victim);
+                this->table.erase(victim.page);
+                ++this->counters.evictions;
+                this->frames.splice(this->frames.begin(), this->frames, std::prev(this->frames.end()));
+            }
+            else
+            {
+                this->frames.push_front(Frame{page, std::vector<unsigned char>(this->pageSize), false});
+            }
+
+            Frame& frame = this->frames.front();
+            frame.page = page;
+            frame.dirty = false;
+            off_t offset = static_cast<off_t>(this->firstPage + page * this->pageSize);
+            if (::pread(this->fd, frame.bytes.data(), this->pageSize, offset) != static_cast<ssize_t>(this->pageSize))
+            {
+                this->frames.pop_front();
+                throw std::runtime_error("BufferPool: cannot read a page.");
+            }
+            this->table[page] = this->frames.begin();
+            return frame.bytes.data();
+        }
+
+
+        /**
+         * @brief Marks a page in memory as modified, so that it is written back before being dropped.
+         */
+        void mark_dirty(uint64_t page)
+        {
+            auto found = this->table.find(page);
+            if (found != this->table.end()) found->second->dirty = true;
+        }
+
+
+        /**
+         * @brief Writes every dirty page back to the file.
+         */
+        void flush()
+        {
+            for (Frame& frame : this->frames)
+            {
+                if (frame.dirty) this->writeBack(frame);
+            }
+        }
+
+
+        /**
+         * @brief Retrieves the number of frames the budget allows.
+         */
+        size_t frame_capacity() const
+        {
+            return this->capacity;
+        }
+
+
+        /**
+         * @brief Retrieves the number of pages currently in memory.
+         */
+        size_t resident_pages() const
+        {
+            return this->frames.size();
+        }
+
+
+        /**
+         * @brief Retrieves the I/O counters.
+         */
+        const PageStats& stats() const
+        {
+            return this->counters;
+        }
+
+
+        /**
+         * @brief Resets the I/O counters (the pages in memory are kept).
+         */
+        void reset_stats()
+        {
+            this->counters = PageStats();
+        }
+    };
+
+
+    /**
+     * @struct PagedFileLayout
+     * @brief Geometry of a paged tree file.
+     *
+     * The file starts with a 64-byte header padded to a full page: magic "ORTG", version (2 bytes),
+     * value type tag (1), reserved (1), k (4), record size (4), reserved (4), page size (8), node
+     * count (8), records per page (8). Pages follow, each holding records_per_page node records
+     * (the last one padded). A record is the child count (8 bytes), k child ids (8 bytes each) and
+     * the fixed-width value, rounded up to a multiple of 8. Node ids are pre-order positions, so the
+     * record of node i is slot i % records_per_page of page i / records_per_page.
+     */
+    template <typename T, int k>
+    struct PagedFileLayout
+    {
+        static constexpr char MAGIC[4] = {'O', 'R', 'T', 'G'};
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t HEADER_SIZE = 64;
+        static constexpr size_t VALUE_AT = 8 + 8 * static_cast<size_t>(k);
+        static constexpr size_t RECORD_SIZE = (VALUE_AT + ValueCodec<T>::width + 7) / 8 * 8;
+    };
+
+
+    /**
+     * @brief Writes a tree in the paged format read by PagedTree.
+     *
+     * Nodes are numbered and packed in pre-order, so every page holds a run of consecutive pre-order
+     * nodes: a subtree that fits in a page spans at most two pages, and a walk down a path or over a
+     * subtree touches few pages.
+     *
+     * @param tree The tree to write.
+     * @param path The destination file (replaced).
+     * @param pageSize Bytes per page; it must hold the header and at least one node record.
+     * @throws std::invalid_argument if the page size is too small.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    template <typename T, int k>
+    void write_paged_tree(const Tree<T, k>& tree, const std::string& path, size_t pageSize = 4096)
+    {
+        static_assert(ValueCodec<T>::width != 0, "Only fixed-width values can be paged.");
+        using Layout = PagedFileLayout<T, k>;
+        if (pageSize < Layout::HEADER_SIZE || pageSize < Layout::RECORD_SIZE)
+        {
+            throw std::invalid_argument("write_paged_tree: the page size is too small for a node record.");
+        }
+        size_t perPage = pageSize / Layout::RECORD_SIZE;
+
+        // Number the nodes in pre-order
+        std::vector<const Node<T>*> order;
+        std::unordered_map<const Node<T>*, uint64_t> ids;
+        std::vector<const Node<T>*> pending;
+        if (tree.root) pending.push_back(tree.root);
+        while (!pending.empty())
+        {
+            const Node<T>* node = pending.back();
+            pending.pop_back();
+            ids[node] = order.size();
+            order.push_back(node);
+            for (auto it = node->get_children().rbegin(); it != node->get_children().rend(); ++it)
+            {
+                pending.push_back(*it);
+            }
+        }
+
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("write_paged_tree: cannot open " + path + ".");
+        try
+        {
+            BinaryWriter out(file);
+            std::vector<unsigned char> page(pageSize, 0);
+            std::memcpy(page.data(), Layout::MAGIC, 4);
+            store_uint(page.data() + 4, Layout::VERSION, 2);
+            page[6] = ValueCodec<T>::tag;
+            store_uint(page.data() + 8, static_cast<uint32_t>(k), 4);
+            store_uint(page.data() + 12, Layout::RECORD_SIZE, 4);
+            store_uint(page.data() + 20, pageSize, 8);
+            store_uint(page.data() + 28, order.size(), 8);
+            store_uint(page.data() + 36, perPage, 8);
+            out.write(page.data(), pageSize);
+
+            for (size_t first = 0; first < order.size(); first += perPage)
+            {
+                std::fill(page.begin(), page.end(), 0);
+                for (size_t i = first; i < std::min(order.size(), first + perPage); ++i)
+                {
+                    unsigned char* record = page.data() + (i - first) * Layout::RECORD_SIZE;
+                    const std::vector<Node<T>*>& children = order[i]->get_children();
+                    store_uint(record, children.size(), 8);
+                    for (size_t c = 0; c < children.size(); ++c)
+                    {
+                        store_uint(record + 8 + 8 * c, ids[children[c]], 8);
+                    }
+                    ValueCodec<T>::encode(record + Layout::VALUE_AT, order[i]->get_value());
+                }
+                out.write(page.data(), pageSize);
+            }
+            out.flush();
+        }
+        catch (...)
+        {
+            std::fclose(file);
+            throw;
+        }
+        if (std::fclose(file) != 0) throw std::runtime_error("write_paged_tree: cannot write " + path + ".");
+    }
+
+
+    template <typename T, int k>
+    class PagedTree;
+
+
+/**
+ * @class PagedNode
+ * @brief Handle to one node of a PagedTree: the tree and the node id (its pre-order position).
+ *
+ * A handle holds no page: every access goes through the buffer pool, so handles stay valid while
+ * pages are evicted and reloaded.
+ */
+template <typename T, int k = 2>
+class PagedNode {
+
+    private:
+
+        PagedTree<T, k>* tree = nullptr;    // The tree the node belongs to
+        uint64_t id = 0;                    // Pre-order position of the node
+
+    public:
+
+        PagedNode() {}
+        PagedNode(PagedTree<T, k>* owner, uint64_t nodeId) : tree(owner), id(nodeId) {}
+
+
+        /**
+         * @brief Retrieves the value of the node.
+         */
+        T get_value() const
+        {
+            return this->tree->value_at(this->id);
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of the node.
+         */
+        size_t child_count() const
+        {
+            return this->tree->child_count_at(this->id);
+        }
+
+
+        /**
+         * @brief Retrieves a child of the node.
+         * @param index The position of the child among its siblings.
+         */
+        PagedNode child(size_t index) const
+        {
+            return PagedNode(this->tree, this->tree->child_at(this->id, index));
+        }
+
+
+        /**
+         * @brief Retrieves the id (pre-order position) of the node.
+         */
+        uint64_t index() const
+        {
+            return this->id;
+        }
+
+
+        bool operator==(const PagedNode& other) const
+        {
+            return this->tree == other.tree && this->id == other.id;
+        }
+
+        bool operator!=(const PagedNode& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+    /**
+     * @brief The traversal orders of a PagedIterator, matching the iterator classes of Tree.
+     */
+    enum class PagedOrder { PreOrder, PostOrder, InOrder, BFS, DFS, Heap };
+
+
+/**
+ * @class PagedIterator
+ * @brief Iterator over a PagedTree in any of the six traversal orders of Tree.
+ *
+ * The iterator keeps node ids only and reads every node through the buffer pool, so a walk needs
+ * memory for its stack or queue but not for the tree. The in-order walk requires a binary tree and
+ * throws std::invalid_argument when it reaches a node with more than two children. The heap order
+ * visits values from the smallest up and, like HeapIterator, collects every value first.
+ */
+template <typename T, int k = 2>
+class PagedIterator {
+
+    private:
+
+        PagedTree<T, k>* tree;                              // The walked tree, or nullptr for an end iterator
+        PagedOrder order;                                   // Traversal order
+        PagedNode<T, k> current;                            // The current node
+        std::deque<uint64_t> pending;                       // Pre-order, DFS, in-order: stack at the back; BFS: queue
+        std::vector<std::pair<uint64_t, size_t>> frames;    // Post-order: node and the position of its next child
+        std::vector<std::pair<T, uint64_t>> heap;           // Heap order: values still to visit and their nodes
+
+
+        static bool heapAfter(const std::pair<T, uint64_t>& a, const std::pair<T, uint64_t>& b)
+        {
+            return a.first > b.first;
+        }
+
+
+        /**
+         * @brief Pushes a node and its chain of first children (in-order walk).
+         */
+        void pushLeft(uint64_t id)
+        {
+            while (true)
+            {
+                this->pending.push_back(id);
+                if (this->tree->child_count_at(id) == 0) break;
+                id = this->tree->child_at(id, 0);
+            }
+        }
+
+
+        /**
+         * @brief Finds the next node in the chosen order.
+         * @return False when the walk is over.
+         */
+        bool step(uint64_t& next)
+        {
+            switch (this->order)
+            {
+                case PagedOrder::BFS:
+                {
+                    if (this->pending.empty()) return false;
+                    next = this->pending.front();
+                    this->pending.pop_front();
+                    size_t count = this->tree->child_count_at(next);
+                    for (size_t i = 0; i < count; ++i) this->pending.push_back(this->tree->child_at(next, i));
+                    return true;
+                }
+                case PagedOrder::PreOrder:
+                case PagedOrder::DFS:
+                {
+                    if (this->pending.empty()) return false;
+                    next = this->pending.back();
+                    this->pending.pop_back();
+                    for (size_t i = this->tree->child_count_at(next); i > 0; --i)
+                    {
+                        this->pending.push_back(this->tree->child_at(next, i - 1));
+                    }
+                    return true;
+                }
+                case PagedOrder::InOrder:
+                {
+                    if (this->pending.empty()) return false;
+                    next = this->pending.back();
+                    this->pending.pop_back();
+                    size_t count = this->tree->child_count_at(next);
+                    if (count > 2) throw std::invalid_argument("PagedIterator: in-order traversal needs a binary tree.");
+                    if (count == 2) this->pushLeft(this->tree->child_at(next, 1));
+                    return true;
+                }
+                case PagedOrder::PostOrder:
+                {
+                    while (!this->frames.empty())
+                    {
+                        auto& [id, child] = this->frames.back();
+                        if (child < this->tree->child_count_at(id))
+                        {
+                            uint64_t descendant = this->tree->child_at(id, child++);
+                            this->frames.push_back({descendant, 0});
+                            continue;
+                        }
+                        next = id;
+                        this->frames.pop_back();
+                        return true;
+                    }
+                    return false;
+                }
+                case PagedOrder::Heap:
+                {
+                    if (this->heap.empty()) return false;
+                    std::pop_heap(this->heap.begin(), this->heap.end(), heapAfter);
+                    next = this->heap.back().second;
+                    this->heap.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+
+        /**
+         * @brief Moves to the next node, or becomes an end iterator.
+         */
+        void advance()
+        {
+            uint64_t next = 0;
+            if (this->step(next))
+            {
+                this->current = PagedNode<T, k>(this->tree, next);
+                return;
+            }
+            this->tree = nullptr;
+            this->current = PagedNode<T, k>();
+        }
+
+    public:
+
+        /**
+         * @brief Constructs an iterator at the root of a tree, or an end iterator when `owner` is nullptr or empty.
+         * @param owner The tree to walk.
+         * @param walkOrder The traversal order.
+         */
+        PagedIterator(PagedTree<T, k>* owner, PagedOrder walkOrder) : tree(owner), order(walkOrder)
+        {
+            if (!this->tree) return;
+            if (this->tree->size() > 0)
+            {
+                switch (this->order)
+                {
+                    case PagedOrder::InOrder: this->pushLeft(0); break;
+                    case PagedOrder::PostOrder: this->frames.push_back({0, 0}); break;
+                    case PagedOrder::Heap:
+                        // Node ids are pre-order positions, so a scan in id order reads every page once
+                        for (uint64_t id = 0; id < this->tree->size(); ++id) this->heap.push_back({this->tree->value_at(id), id});
+                        std::make_heap(this->heap.begin(), this->heap.end(), heapAfter);
+                        break;
+                    default: this->pending.push_back(0); break;
+                }
+            }
+            this->advance();
+        }
+
+
+        const PagedNode<T, k>& operator*() const
+        {
+            return this->current;
+        }
+
+
+        const PagedNode<T, k>* operator->() const
+        {
+            return &this->current;
+        }
+
+
+        PagedIterator& operator++()
+        {
+            this->advance();
+            return *this;
+        }
+
+
+        bool operator==(const PagedIterator& other) const
+        {
+            return this->tree == other.tree && this->current == other.current;
+        }
+
+
+        bool operator!=(const PagedIterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+/**
+ * @class PagedTree
+ * @brief Out-of-core tree: node records live in fixed-size pages of a file (see write_paged_tree) and
+ * are loaded on demand through an LRU BufferPool with a memory budget.
+ *
+ * Only the pages a traversal touches are read, and at most memoryBudget bytes of them are kept, so
+ * the tree may be far larger than RAM. Values can be changed in place; changed pages are written
+ * back when evicted or on flush(). The I/O counters of the pool (stats()) show how well the page
+ * size and budget fit a workload.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes (int, double or Complex).
+ * @tparam k Maximum number of children each node can have.
+ */
+template <typename T, int k = 2>
+class PagedTree {
+
+    private:
+
+        using Layout = PagedFileLayout<T, k>;
+
+        int fd = -1;                // The open file
+        size_t pageSize = 0;        // Bytes per page
+        size_t perPage = 0;         // Node records per page
+        size_t count = 0;           // Number of nodes
+        std::unique_ptr<BufferPool> pool;
+
+
+        /**
+         * @brief Retrieves the record of a node, loading its page if needed.
+         * @throws std::out_of_range if the id is not a node of the tree.
+         */
+        unsigned char* record(uint64_t id)
+        {
+            if (id >= this->count) throw std::out_of_range("PagedTree: no node with this id.");
+            return this->pool->fetch(id / this->perPage) + (id % this->perPage) * Layout::RECORD_SIZE;
+        }
+
+    public:
+
+        /**
+         * @brief Opens a paged tree file.
+         * The header is checked against the file size before any page frame is allocated, so a forged
+         * page size or node count is rejected instead of allocating or dividing by zero.
+         * @param path The file written by write_paged_tree.
+         * @param memoryBudget Bytes of pages kept in memory.
+         * @throws std::runtime_error if the file cannot be opened or is not a paged tree of this type and k.
+         */
+        PagedTree(const std::string& path, size_t memoryBudget)
+        {
+            this->fd = ::open(path.c_str(), O_RDWR);
+            if (this->fd < 0) throw std::runtime_error("PagedTree: cannot open " + path + ".");
+
+            unsigned char header[Layout::HEADER_SIZE];
+            bool valid = ::pread(this->fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))
+                && std::memcmp(header, Layout::MAGIC, 4) == 0
+                && load_uint(header + 4, 2) == Layout::VERSION
+                && header[6] == ValueCodec<T>::tag
+                && load_uint(header + 8, 4) == static_cast<uint32_t>(k)
+                && load_uint(header + 12, 4) == Layout::RECORD_SIZE;
+            if (valid)
+            {
+                this->pageSize = static_cast<size_t>(load_uint(header + 20, 8));
+                this->count = static_cast<size_t>(load_uint(header + 28, 8));
+                this->perPage = static_cast<size_t>(load_uint(header + 36, 8));
+                struct stat info;
+                valid = ::fstat(this->fd, &info) == 0
+                    && this->pageSize >= Layout::HEADER_SIZE && this->pageSize >= Layout::RECORD_SIZE
+                    && this->perPage == this->pageSize / Layout::RECORD_SIZE
+                    && this->pageSize <= static_cast<uint64_t>(info.st_size);
+                if (valid)
+                {
+                    // The header page is followed by whole pages holding every node
+                    size_t pages = (static_cast<size_t>(info.st_size) - this->pageSize) / this->pageSize;
+                    valid = this->count <= pages * this->perPage;
+                }
+            }
+            if (!valid)
+            {
+                ::close(this->fd);
+                throw std::runtime_error("PagedTree: " + path + " is not a paged tree of this type.");
+            }
+            this->pool = std::make_unique<BufferPool>(this->fd, this->pageSize, this->pageSize, memoryBudget);
+        }
+
+
+        PagedTree(const PagedTree&) = delete;
+        PagedTree& operator=(const PagedTree&) = delete;
+
+
+        /**
+         * @brief Destructor that writes back changed pages and closes the file. Write errors are ignored here; call flush() to see them.
+         */
+        ~PagedTree()
+        {
+            try
+            {
+                this->pool->flush();
+            }
+            catch (const std::runtime_error&) {}
+            ::close(this->fd);
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes.
+         */
+        size_t size() const
+        {
+            return this->count;
+        }
+
+
+        /**
+         * @brief Retrieves the root.
+         * @throws std::logic_error if the tree is empty.
+         */
+        PagedNode<T, k> get_root()
+        {
+            if (this->count == 0) throw std::logic_error("PagedTree: the tree is empty.");
+            return PagedNode<T, k>(this, 0);
+        }
+
+
+        /**
+         * @brief Decodes the value of a node.
+         */
+        T value_at(uint64_t id)
+        {
+            return ValueCodec<T>::decode(this->record(id) + Layout::VALUE_AT);
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of a node.
+         */
+        size_t child_count_at(uint64_t id)
+        {
+            return static_cast<size_t>(load_uint(this->record(id), 8));
+        }
+
+
+        /**
+         * @brief Retrieves the id of a child of a node.
+         * @throws std::out_of_range if the node has no such child.
+         */
+        uint64_t child_at(uint64_t id, size_t index)
+        {
+            const unsigned char* bytes = this->record(id);
+            if (index >= load_uint(bytes, 8)) throw std::out_of_range("PagedTree: no child at this position.");
+            return load_uint(bytes + 8 + 8 * index, 8);
+        }
+
+
+        /**
+         * @brief Replaces the value of a node. The page is written back when evicted or on flush().
+         */
+        void set_value(const PagedNode<T, k>& node, const T& value)
+        {
+            ValueCodec<T>::encode(this->record(node.index()) + Layout::VALUE_AT, value);
+            this->pool->mark_dirty(node.index() / this->perPage);
+        }
+
+
+        /**
+         * @brief Writes every changed page back to the file.
+         * @throws std::runtime_error if writing fails.
+         */
+        void flush()
+        {
+            this->pool->flush();
+        }
+
+
+        /**
+         * @brief Retrieves the page size of the file.
+         */
+        size_t page_size() const
+        {
+            return this->pageSize;
+        }
+
+
+        /**
+         * @brief Retrieves the number of node records per page.
+         */
+        size_t nodes_per_page() const
+        {
+            return this->perPage;
+        }
+
+
+        /**
+         * @brief Retrieves the buffer pool, for its I/O counters and occupancy.
+         */
+        BufferPool& buffer_pool()
+        {
+            return *this->pool;
+        }
+
+
+        /**
+         * @brief Retrieves the I/O counters of the buffer pool.
+         */
+        const PageStats& stats() const
+        {
+            return this->pool->stats();
+        }
+
+
+        // Iterator access functions, with the same names as in Tree
+        PagedIterator<T, k> begin_pre_order() { return PagedIterator<T, k>(this, PagedOrder::PreOrder); }
+        PagedIterator<T, k> end_pre_order() { return PagedIterator<T, k>(nullptr, PagedOrder::PreOrder); }
+
+        PagedIterator<T, k> begin_post_order() { return PagedIterator<T, k>(this, PagedOrder::PostOrder); }
+        PagedIterator<T, k> end_post_order() { return PagedIterator<T, k>(nullptr, PagedOrder::PostOrder); }
+
+        PagedIterator<T, k> begin_in_order() { return PagedIterator<T, k>(this, PagedOrder::InOrder); }
+        PagedIterator<T, k> end_in_order() { return PagedIterator<T, k>(nullptr, PagedOrder::InOrder); }
+
+        PagedIterator<T, k> begin_bfs_scan() { return PagedIterator<T, k>(this, PagedOrder::BFS); }
+        PagedIterator<T, k> end_bfs_scan() { return PagedIterator<T, k>(nullptr, PagedOrder::BFS); }
+
+        PagedIterator<T, k> begin() { return begin_bfs_scan(); }
+        PagedIterator<T, k> end() { return end_bfs_scan(); }
+
+        PagedIterator<T, k> begin_dfs_scan() { return PagedIterator<T, k>(this, PagedOrder::DFS); }
+        PagedIterator<T, k> end_dfs_scan() { return PagedIterator<T, k>(nullptr, PagedOrder::DFS); }
+
+        PagedIterator<T, k> myHeap() { return PagedIterator<T, k>(this, PagedOrder::Heap); }
+        PagedIterator<T, k> end_heap() { return PagedIterator<T, k>(nullptr, PagedOrder::Heap); }
+    };
+}
+
+#endif
@@ -0,0 +1,540 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef PERSISTENTTREE_HPP
+#define PERSISTENTTREE_HPP
+
+#include "serialization.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ori {
+
+    template <typename T, int k>
+    class PersistentTree;
+
+
+/**
+ * @class PersistentNode
+ * @brief Handle to one node of a PersistentTree: the tree and the node's offset in the file.
+ *
+ * Offsets stay valid when the file grows and is mapped again, and across restarts, so handles can
+ * be kept and even stored. A default-constructed handle (offset 0) means "no node".
+ */
+template <typename T, int k = 2>
+class PersistentNode {
+
+    private:
+
+        PersistentTree<T, k>* tree = nullptr;   // The tree the node belongs to
+        uint64_t position = 0;                  // Offset of the node record in the file (0 for no node)
+
+    public:
+
+        PersistentNode() {}
+        PersistentNode(PersistentTree<T, k>* owner, uint64_t offset) : tree(owner), position(offset) {}
+
+
+        /**
+         * @brief Checks whether the handle refers to a node.
+         */
+        explicit operator bool() const
+        {
+            return this->position != 0;
+        }
+
+
+        /**
+         * @brief Retrieves the value of the node.
+         * @throws std::out_of_range if the handle refers to no node.
+         */
+        T get_value() const
+        {
+            if (!this->tree) throw std::out_of_range("PersistentTree: no node record at this offset.");
+            return this->tree->value_at(this->position);
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of the node (0 for no node).
+         */
+        size_t child_count() const
+        {
+            return this->tree ? this->tree->child_count_at(this->position) : 0;
+        }
+
+
+        /**
+         * @brief Retrieves a child of the node.
+         * @param index The position of the child among its siblings.
+         * @throws std::out_of_range if the node has no such child.
+         */
+        PersistentNode child(size_t index) const
+        {
+            if (!this->tree) throw std::out_of_range("PersistentTree: no child at this position.");
+            return PersistentNode(this->tree, this->tree->child_at(this->position, index));
+        }
+
+
+        /**
+         * @brief Retrieves the parent of the node (a handle to no node for the root or for no node).
+         */
+        PersistentNode get_parent() const
+        {
+            return this->tree ? PersistentNode(this->tree, this->tree->parent_at(this->position)) : PersistentNode();
+        }
+
+
+        /**
+         * @brief Retrieves the offset of the node record in the file.
+         */
+        uint64_t offset() const
+        {
+            return this->position;
+        }
+
+
+        bool operator==(const PersistentNode& other) const
+        {
+            return this->tree == other.tree && this->position == other.position;
+        }
+
+        bool operator!=(const PersistentNode& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+/**
+ * @class PersistentIterator
+ * @brief Breadth-first or depth-first (pre-order) iterator over a PersistentTree.
+ */
+template <typename T, int k = 2>
+class PersistentIterator {
+
+    private:
+
+        PersistentTree<T, k>* tree;         // The walked tree, or nullptr for an end iterator
+        bool breadthFirst;                  // Traversal order
+        PersistentNode<T, k> current;       // The current node
+        std::deque<uint64_t> pending;       // Offsets still to visit (front for BFS, back for DFS)
+
+
+        /**
+         * @brief Moves to the next node, or becomes an end iterator.
+         */
+        void advance()
+        {
+            if (this->pending.empty())
+            {
+                this->tree = nullptr;
+                this->current = PersistentNode<T, k>();
+                return;
+            }
+
+            uint64_t position;
+            if (this->breadthFirst)
+            {
+                position = this->pending.front();
+                this->pending.pop_front();
+                for (size_t i = 0; i < this->tree->child_count_at(position); ++i)
+                {
+                    this->pending.push_back(this->tree->child_at(position, i));
+                }
+            }
+            else
+            {
+                position = this->pending.back();
+                this->pending.pop_back();
+                for (size_t i = this->tree->child_count_at(position); i > 0; --i)
+                {
+                    this->pending.push_back(this->tree->child_at(position, i - 1));
+                }
+            }
+            this->current = PersistentNode<T, k>(this->tree, position);
+        }
+
+    public:
+
+        /**
+         * @brief Constructs an iterator at a node, or an end iterator when `start` is no node.
+         * @param owner The tree to walk.
+         * @param start The first node.
+         * @param bfs True for breadth-first order, false for depth-first pre-order.
+         */
+        PersistentIterator(PersistentTree<T, k>* owner, uint64_t start, bool bfs) : tree(owner), breadthFirst(bfs)
+        {
+            if (start != 0) this->pending.push_back(start);
+            this->advance();
+        }
+
+
+        const PersistentNode<T, k>& operator*() const
+        {
+            return this->current;
+        }
+
+
+        const PersistentNode<T, k>* operator->() const
+        {
+            return &this->current;
+        }
+
+
+        PersistentIterator& operator++()
+        {
+            this->advance();
+            return *this;
+        }
+
+
+        bool operator==(const PersistentIterator& other) const
+        {
+            return this->current == other.current && this->tree == other.tree;
+        }
+
+
+        bool operator!=(const PersistentIterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+/**
+ * @class PersistentTree
+ * @brief k-ary tree whose node arena is a memory-mapped file, so it survives restarts without a serialize step.
+ *
+ * Every node is a fixed-size record in the file: parent offset, child count, k child offsets and
+ * the fixed-width encoded value. Links are file offsets rather than pointers, so they stay valid
+ * when the file grows (it is extended and mapped again) and when it is reopened. add_root,
+ * add_sub_node and set_value write straight into the shared mapping; checkpoint() forces the
+ * changes to disk with msync.
+ *
+ * A new node record is written completely before its parent's child count is raised, so if the
+ * process crashes the last records may be unreachable, but every reachable node is complete. This
+ * holds for process crashes only: the kernel writes dirty pages back in any order, so after a power
+ * loss or an operating system crash only the state of the last checkpoint() is guaranteed.
+ *
+ * Offsets passed in (through handles or the *_at accessors) are checked against the node records
+ * in the file, so a stale or forged offset throws instead of touching the header or unmapped memory.
+ *
+ * Layout: a 64-byte header (magic "ORTP", version, value type tag, k, record size, node count,
+ * root offset), then the records. All fields are little-endian.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes (int, double or Complex).
+ * @tparam k Maximum number of children each node can have.
+ */
+template <typename T, int k = 2>
+class PersistentTree {
+
+    private:
+
+        static constexpr size_t HEADER_SIZE = 64;
+        static constexpr size_t VALUE_AT = 16 + 8 * static_cast<size_t>(k);     // Offset of the value inside a record
+        static constexpr size_t RECORD_SIZE = (VALUE_AT + ValueCodec<T>::width + 7) / 8 * 8;
+
+        int fd = -1;                            // The open file, kept for growing it
+        unsigned char* data = nullptr;          // The shared mapping of the whole file
+        size_t capacity = 0;                    // Size of the file and of the mapping in bytes
+
+
+        uint64_t field(uint64_t offset) const
+        {
+            return load_uint(this->data + offset, 8);
+        }
+
+
+        /**
+         * @brief Checks whether an offset is the start of one of the node records in the file.
+         */
+        bool isRecord(uint64_t offset) const
+        {
+            return offset >= HEADER_SIZE
+                && (offset - HEADER_SIZE) % RECORD_SIZE == 0
+                && (offset - HEADER_SIZE) / RECORD_SIZE < this->field(16);
+        }
+
+
+        /**
+         * @brief Returns an offset after checking that it starts a node record.
+         * @throws std::out_of_range if it does not.
+         */
+        uint64_t record(uint64_t offset) const
+        {
+            if (!this->isRecord(offset)) throw std::out_of_range("PersistentTree: no node record at this offset.");
+            return offset;
+        }
+
+        void setField(uint64_t offset, uint64_t value)
+        {
+            store_uint(this->data + offset, value, 8);
+        }
+
+
+        /**
+         * @brief Grows the file and maps it again.
+         * The old mapping is released only once the new one exists, so on failure the tree is left as it was.
+         * @param size The new size in bytes, at least the current one.
+         * @throws std::runtime_error if the file cannot be resized or mapped.
+         */
+        void remap(size_t size)
+        {
+            if (::ftruncate(this->fd, static_cast<off_t>(size)) != 0)
+            {
+                throw std::runtime_error("PersistentTree: cannot resize the file.");
+            }
+            void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+            if (mapping == MAP_FAILED) throw std::runtime_error("PersistentTree: cannot map the file.");
+            if (this->data) ::munmap(this->data, this->capacity);
+            this->data = static_cast<unsigned char*>(mapping);
+            this->capacity = size;
+        }
+
+
+        /**
+         * @brief Appends a detached node record, growing the file when it is full.
+         * @return The offset of the new record.
+         */
+        uint64_t allocate(const T& value)
+        {
+            uint64_t count = this->field(16);
+            uint64_t offset = HEADER_SIZE + count * RECORD_SIZE;
+            if (offset + RECORD_SIZE > this->capacity)
+            {
+                this->remap(2 * this->capacity);
+            }
+            std::memset(this->data + offset, 0, RECORD_SIZE);
+            ValueCodec<T>::encode(this->data + offset + VALUE_AT, value);
+            this->setField(16, count + 1);
+            return offset;
+        }
+
+
+        /**
+         * @brief Releases the mapping and the file.
+         */
+        void close()
+        {
+            if (this->data) ::munmap(this->data, this->capacity);
+            if (this->fd >= 0) ::close(this->fd);
+            this->data = nullptr;
+            this->fd = -1;
+        }
+
+    public:
+
+        /**
+         * @brief Opens a persistent tree file, creating an empty tree if the file does not exist or is empty.
+         * @param path The file.
+         * @param initialNodes Room reserved for this many nodes when the file is created.
+         * @throws std::runtime_error if the file cannot be opened or holds a tree of another type or k.
+         */
+        explicit PersistentTree(const std::string& path, size_t initialNodes = 1024)
+        {
+            this->fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (this->fd < 0) throw std::runtime_error("PersistentTree: cannot open " + path + ".");
+
+            struct stat info;
+            if (::fstat(this->fd, &info) != 0)
+            {
+                this->close();
+                throw std::runtime_error("PersistentTree: cannot inspect " + path + ".");
+            }
+
+            try
+            {
+                if (info.st_size == 0)
+                {
+                    this->remap(HEADER_SIZE + std::max<size_t>(initialNodes, 1) * RECORD_SIZE);
+                    std::memcpy(this->data, "ORTP", 4);
+                    store_uint(this->data + 4, 1, 2);
+                    this->data[6] = ValueCodec<T>::tag;
+                    store_uint(this->data + 8, static_cast<uint32_t>(k), 4);
+                    store_uint(this->data + 12, RECORD_SIZE, 4);
+                    return;
+                }
+
+                this->capacity = static_cast<size_t>(info.st_size);
+                void* mapping = ::mmap(nullptr, this->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+                if (mapping == MAP_FAILED) throw std::runtime_error("PersistentTree: cannot map " + path + ".");
+                this->data = static_cast<unsigned char*>(mapping);
+
+                bool valid = this->capacity >= HEADER_SIZE
+                    && std::memcmp(this->data, "ORTP", 4) == 0
+                    && load_uint(this->data + 4, 2) == 1
+                    && this->data[6] == ValueCodec<T>::tag
+                    && load_uint(this->data + 8, 4) == static_cast<uint32_t>(k)
+                    && load_uint(this->data + 12, 4) == RECORD_SIZE
+                    && this->field(16) <= (this->capacity - HEADER_SIZE) / RECORD_SIZE
+                    && (this->field(24) == 0 || this->isRecord(this->field(24)));
+                if (!valid) throw std::runtime_error("PersistentTree: " + path + " is not a persistent tree of this type.");
+            }
+            catch (...)
+            {
+                this->close();
+                throw;
+            }
+        }
+
+
+        PersistentTree(const PersistentTree&) = delete;
+        PersistentTree& operator=(const PersistentTree&) = delete;
+
+
+        /**
+         * @brief Destructor that unmaps and closes the file. Unsynchronised changes are left to the operating system.
+         */
+        ~PersistentTree()
+        {
+            this->close();
+        }
+
+
+        /**
+         * @brief Retrieves the number of node records in the file.
+         */
+        size_t size() const
+        {
+            return static_cast<size_t>(this->field(16));
+        }
+
+
+        /**
+         * @brief Retrieves the root (a handle to no node for an empty tree).
+         */
+        PersistentNode<T, k> get_root()
+        {
+            return PersistentNode<T, k>(this, this->field(24));
+        }
+
+
+        /**
+         * @brief Creates the root node.
+         * An existing root stays in the file but is no longer reachable, matching Tree::add_root replacing its root.
+         * @param value The value of the root.
+         * @return The new root.
+         */
+        PersistentNode<T, k> add_root(const T& value)
+        {
+            uint64_t offset = this->allocate(value);
+            this->setField(24, offset);
+            return PersistentNode<T, k>(this, offset);
+        }
+
+
+        /**
+         * @brief Adds a child with the given value to a node, if it has fewer than k children.
+         * @param parent The parent node.
+         * @param value The value of the child.
+         * @return The new child, or a handle to no node if the parent is full or no node.
+         * @throws std::out_of_range if the parent's offset is not a node record.
+         */
+        PersistentNode<T, k> add_sub_node(const PersistentNode<T, k>& parent, const T& value)
+        {
+            if (!parent || this->child_count_at(parent.offset()) >= static_cast<size_t>(k))
+            {
+                return PersistentNode<T, k>();
+            }
+
+            uint64_t offset = this->allocate(value);     // May remap, so nothing is read from the old mapping after this
+            uint64_t count = this->field(parent.offset() + 8);
+            this->setField(offset, parent.offset());
+            this->setField(parent.offset() + 16 + 8 * count, offset);
+            this->setField(parent.offset() + 8, count + 1);
+            return PersistentNode<T, k>(this, offset);
+        }
+
+
+        /**
+         * @brief Replaces the value of a node in the file. Does nothing for a handle to no node.
+         * @throws std::out_of_range if the node's offset is not a node record.
+         */
+        void set_value(const PersistentNode<T, k>& node, const T& value)
+        {
+            if (!node) return;
+            ValueCodec<T>::encode(this->data + this->record(node.offset()) + VALUE_AT, value);
+        }
+
+
+        /**
+         * @brief Forces all changes made so far to disk (msync, then fsync for the file size).
+         * @throws std::runtime_error if syncing fails.
+         */
+        void checkpoint()
+        {
+            if (::msync(this->data, this->capacity, MS_SYNC) != 0 || ::fsync(this->fd) != 0)
+            {
+                throw std::runtime_error("PersistentTree: checkpoint failed.");
+            }
+        }
+
+
+        /**
+         * @brief Decodes the value of the node record at an offset.
+         * @throws std::out_of_range if the offset is not a node record.
+         */
+        T value_at(uint64_t offset) const
+        {
+            return ValueCodec<T>::decode(this->data + this->record(offset) + VALUE_AT);
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of the node record at an offset.
+         * @throws std::out_of_range if the offset is not a node record.
+         * @throws std::runtime_error if the record holds more than k children.
+         */
+        size_t child_count_at(uint64_t offset) const
+        {
+            uint64_t count = this->field(this->record(offset) + 8);
+            if (count > static_cast<uint64_t>(k)) throw std::runtime_error("PersistentTree: corrupt child count.");
+            return static_cast<size_t>(count);
+        }
+
+
+        /**
+         * @brief Retrieves the offset of a child of the node record at an offset.
+         * @throws std::out_of_range if the offset is not a node record or the node has no such child.
+         */
+        uint64_t child_at(uint64_t offset, size_t index) const
+        {
+            if (index >= this->child_count_at(offset)) throw std::out_of_range("PersistentTree: no child at this position.");
+            return this->field(offset + 16 + 8 * index);
+        }
+
+
+        /**
+         * @brief Retrieves the offset of the parent of the node record at an offset (0 for the root).
+         * @throws std::out_of_range if the offset is not a node record.
+         */
+        uint64_t parent_at(uint64_t offset) const
+        {
+            return this->field(this->record(offset));
+        }
+
+
+        // Iterator access functions, with the same names as in Tree
+        PersistentIterator<T, k> begin_bfs_scan() { return PersistentIterator<T, k>(this, this->field(24), true); }
+        PersistentIterator<T, k> end_bfs_scan() { return PersistentIterator<T, k>(this, 0, true); }
+
+        PersistentIterator<T, k> begin() { return begin_bfs_scan(); }
+        PersistentIterator<T, k> end() { return end_bfs_scan(); }
+
+        PersistentIterator<T, k> begin_dfs_scan() { return PersistentIterator<T, k>(this, this->field(24), false); }
+        PersistentIterator<T, k> end_dfs_scan() { return PersistentIterator<T, k>(this, 0, false); }
+
+        PersistentIterator<T, k> begin_pre_order() { return PersistentIterator<T, k>(this, this->field(24), false); }
+        PersistentIterator<T, k> end_pre_order() { return PersistentIterator<T, k>(this, 0, false); }
+    };
+}
+
+#endif
@@ -5,90 +5,83 @@
 
 #include "node.hpp"
 #include <stack>
-#include <set>
-#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
-using std::set;
 namespace ori {
 
 /**
  * @class PostOrderIterator
  * @brief Iterator for performing post-order traversal on a binary tree: LEFT->RIGHT->ROOT.
  *
+ * The iterator keeps the path from the start node to the current node on a stack, together with
+ * the position of the next child to descend into at every level. It never looks nodes up by
+ * address, so it also walks DAGs where one node is shared by several parents (see CompactTree).
+ *
  * @tparam T Data type of the node's value.
+ * @tparam N The node type: Node<T>, or another type with get_value() and get_children() such as LazyNode<T>.
  */
-template <typename T>
+template <typename T, typename N = Node<T>>
 class PostOrderIterator {
     
     private:
 
-        Node<T>* current;                // Current node being processed
-        std::stack<Node<T>*> stack;      // Stack to track the path and manage backtracking
-        set<Node<T>*> visited;           // Set to track visited nodes to prevent reprocessing
+        N* current;                                         // Current node being processed
+        std::stack<std::pair<N*, size_t>> stack;            // Path to the current node, with the next child position to visit at each level
 
 
         /**
-         * @brief Moves the iterator to the next leaf node from the current position.
+         * @brief Moves the iterator down to the first leaf below a node.
          * 
-         * This helper function traverses down the tree from the current node, 
-         * pushing nodes onto the stack until a leaf node is reached. 
-         * It starts from the current node and continuously moves to the leftmost child 
-         * (if it exists and hasn't been visited yet) until it finds a leaf node.
-         * Once a leaf node is found, it becomes the current node.
+         * This helper function pushes the node and then its leftmost descendants onto the stack 
+         * until a leaf is reached. The leaf becomes the current node.
+         * @param node The node from which to descend.
          */
-        void moveToNextLeaf() 
+        void moveToNextLeaf(N* node) 
         {
-            // Traverse down to the next leaf node
-            while (current) 
+            while (node) 
             {
-                
-                this->stack.push(current);      // Push the current node onto the stack
-                
-                // Check if the current node has unvisited children
-                if (!this->current->get_children().empty() 
-                && this->visited.find(this->current) == this->visited.end())     // Here I checks if the current node is not found in the visited set        
-                {
-                    // Move to the leftmost child (first child in the children vector)
-                    this->current = this->current->get_children().front();
-                } 
-
-                // If no unvisited children, break the loop
-                else 
-                {
-                    break;
-                }
+                this->checkBinary(node);
+                this->stack.push({node, 1});    // The first child is visited right away, the next one to visit is the second
+                if (node->get_children().empty()) break;
+                node = node->get_children().front();
             }
+            this->current = this->stack.empty() ? nullptr : this->stack.top().first;
+        }
 
-            // If the stack is not empty, set the current node to the top of the stack
-            if (!this->stack.empty()) 
-            {
-                this->current = this->stack.top();
-            } 
 
-            // If the stack is empty, the traversal completed
-            else 
+        /**
+         * @brief Helper function to check that a node has at most two children.
+         * @param node The node to check.
+         * @throws std::invalid_argument if the node has more than two children.
+         */
+        static void checkBinary(N* node)
+        {
+            if (node->get_children().size() > 2) 
             {
-                this->current = nullptr;
+                throw std::invalid_argument("PostOrderIterator can only be used on binary trees.");
             }
         }
 
 
         /**
          * @brief Helper function to validate that the tree is binary.
-         * Recursively checks all nodes in the tree to ensure no node has more than two children.
+         * Iteratively checks all nodes in the tree to ensure no node has more than two children.
          * @param node The node from which to start the validation.
          * @throws std::invalid_argument if any node has more than two children.
          */
-        void validateBinaryTree(Node<T>* node)
+        static void validateBinaryTree(N* node)
         {
-            if (!node) return;
-            for (const auto& child : node->get_children()) 
+            std::vector<N*> pending;
+            if (node) pending.push_back(node);
+            while (!pending.empty()) 
             {
-                if (node->get_children().size() > 2) 
-                {
-                    throw std::invalid_argument("PostOrderIterator can only be used on binary trees.");
-                }
-                validateBinaryTree(child);
+                N* next = pending.back();
+                pending.pop_back();
+                checkBinary(next);
+                pending.insert(pending.end(), next->get_children().begin(), next->get_children().end());
             }
         }
 
@@ -100,17 +93,14 @@ class PostOrderIterator {
          * It attempts to move to the first leaf node as a starting point for post-order traversal.
          * @param root Root node of the tree from which to start traversal.
          */
-        PostOrderIterator(Node<T>* root)
+        PostOrderIterator(N* root)
         {
-            validateBinaryTree(root);   // Validate the tree to ensure it is binary
+            // In-memory trees are validated up front; other node types such as LazyNode are checked
+            // node by node as the walk reaches them, so opening the iterator does not load the whole tree
+            if constexpr (std::is_same_v<N, Node<T>>) validateBinaryTree(root);
 
-            this->current = root;       // Set the current node to the provided root node
-            
-            // If the current node is not null, move to the next leaf node
-            if (this->current) 
-            {
-                this->moveToNextLeaf();
-            }
+            this->current = nullptr;
+            this->moveToNextLeaf(root); // Descend from the provided root node to its first leaf
         }
 
 
@@ -118,14 +108,14 @@ class PostOrderIterator {
          * @brief Copy constructor.
          * @param other The iterator to copy from.
          */
-        PostOrderIterator(const PostOrderIterator& other) : current(other.current), stack(other.stack), visited(other.visited) {}
+        PostOrderIterator(const PostOrderIterator& other) : current(other.current), stack(other.stack) {}
 
 
         /**
          * @brief Dereferences the iterator to access the current node's value.
          * @return Reference to the current node.
          */
-        Node<T>& operator*() 
+        N& operator*() 
         {
             return *this->current;
         }
@@ -135,7 +125,7 @@ class PostOrderIterator {
          * @brief Accesses members of the current node.
          * @return Pointer to the current node.
          */
-        Node<T>* operator->() 
+        N* operator->() 
         {
             return this->current;
         }
@@ -155,36 +145,25 @@ class PostOrderIterator {
                 return *this;
             }
 
-            this->visited.insert(this->current);        // Mark the current node as visited
-            this->stack.pop();                          // Remove the current node from the stack
-
-            // Find the next node using the stack and visited nodes
-            if (!this->stack.empty()) 
-            {   
-                // Get the parent node of the current node
-                Node<T>* parent = this->stack.top();
-
-                // Find the position of the current node among its siblings
-                auto it = std::find(parent->get_children().begin(), parent->get_children().end(), this->current);       // By find function I identufy the position of the current node within its parent's list of children
-                                                                                                                        // Below is the signature of std::find:
-                                                                                                                        // template<class InputIt, class T>
-                                                                                                                        // InputIt find(InputIt first, InputIt last, const T& value);
-                // Find the next sibling that hasn't been visited (if it + 1 is not equal to end(), it means there is another sibling)
-                if ((it + 1) != parent->get_children().end())
-                {
-                    this->current = *(it + 1);  // If the current node has a next sibling, move to it
-                    this->moveToNextLeaf();     // Move down to the leaf node from the current position
-                } 
-
-                // If no unvisited siblings are left, move up to the parent
-                else 
-                {
-                    this->current = parent;
-                }
-            } 
-            else 
+            this->stack.pop();      // The current node is done
+
+            // If the stack is empty, the traversal completed
+            if (this->stack.empty()) 
             {
                 this->current = nullptr;
+                return *this;
+            }
+
+            // Move to the next sibling's first leaf, or up to the parent once all its children are done
+            std::pair<N*, size_t>& parent = this->stack.top();
+            if (parent.second < parent.first->get_children().size())
+            {
+                N* sibling = parent.first->get_children()[parent.second++];
+                this->moveToNextLeaf(sibling);
+            }
+            else 
+            {
+                this->current = parent.first;
             }
             return *this;
         }
@@ -221,7 +200,6 @@ class PostOrderIterator {
             {
                 this->current = other.current;
                 this->stack = other.stack;
-                this->visited = other.visited;
             }
             return *this;
         }
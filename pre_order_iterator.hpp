@@ -5,6 +5,9 @@
 
 #include "node.hpp"
 #include <stack>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace ori {
 
@@ -14,32 +17,50 @@ namespace ori {
  *
  * @tparam T Data type of the node's value.
  * @tparam k Maximum number of children a node can have.
+ * @tparam N The node type: Node<T>, or another type with get_value() and get_children() such as LazyNode<T>.
  */
-template <typename T>
+template <typename T, typename N = Node<T>>
 class PreOrderIterator {
     
     private:
 
-        Node<T>* current;                // Current node being processed
-        std::stack<Node<T>*> stack;      // Stack to manage the traversal order
+        N* current;                      // Current node being processed
+        std::stack<N*> stack;            // Stack to manage the traversal order
+        std::stack<size_t> depths;       // Depth of each node in the stack, relative to the starting node
+        size_t maxDepth;                 // Nodes deeper than this are not visited
+        bool skipNext = false;           // Whether the children of the current node must be skipped
+
+
+        /**
+         * @brief Helper function to check that a node has at most two children.
+         * @param node The node to check.
+         * @throws std::invalid_argument if the node has more than two children.
+         */
+        static void checkBinary(N* node)
+        {
+            if (node->get_children().size() > 2) 
+            {
+                throw std::invalid_argument("PreOrderIterator can only be used on binary trees.");
+            }
+        }
 
 
         /**
          * @brief Helper function to validate that the tree is binary.
-         * Recursively checks all nodes in the tree to ensure no node has more than two children.
+         * Iteratively checks all nodes in the tree to ensure no node has more than two children.
          * @param node The node from which to start the validation.
          * @throws std::invalid_argument if any node has more than two children.
          */
-        void validateBinaryTree(Node<T>* node)
+        static void validateBinaryTree(N* node)
         {
-            if (!node) return;
-            for (const auto& child : node->get_children()) 
+            std::vector<N*> pending;
+            if (node) pending.push_back(node);
+            while (!pending.empty()) 
             {
-                if (node->get_children().size() > 2) 
-                {
-                    throw std::invalid_argument("PreOrderIterator can only be used on binary trees.");
-                }
-                validateBinaryTree(child);
+                N* next = pending.back();
+                pending.pop_back();
+                checkBinary(next);
+                pending.insert(pending.end(), next->get_children().begin(), next->get_children().end());
             }
         }
 
@@ -49,15 +70,19 @@ class PreOrderIterator {
          * @brief Initializes the iterator to start at the given node.
          * This constructor sets pushes the initial node onto the stack to begin the traversal.
          * @param node Starting node of the traversal.
+         * @param depthLimit Maximum depth to visit, relative to the starting node (unlimited by default).
          */
-        PreOrderIterator(Node<T>* node) : current(node) 
+        PreOrderIterator(N* node, size_t depthLimit = UNLIMITED_DEPTH) : current(node), maxDepth(depthLimit) 
         {
-            validateBinaryTree(node);       // Validate the tree to ensure it is binary
+            // In-memory trees are validated up front; other node types such as LazyNode are checked
+            // node by node as the walk reaches them, so opening the iterator does not load the whole tree
+            if constexpr (std::is_same_v<N, Node<T>>) validateBinaryTree(node);
 
             // If the starting node is not null
             if (this->current) 
             {
                 this->stack.push(this->current);
+                this->depths.push(0);
             }
         }
 
@@ -66,14 +91,15 @@ class PreOrderIterator {
          * @brief Copy constructor.
          * @param other The iterator to copy from.
          */
-        PreOrderIterator(const PreOrderIterator& other) : current(other.current), stack(other.stack) {}
+        PreOrderIterator(const PreOrderIterator& other) 
+            : current(other.current), stack(other.stack), depths(other.depths), maxDepth(other.maxDepth), skipNext(other.skipNext) {}
 
 
         /**
          * @brief Dereferences the iterator to access the current node's value.
          * @return Reference to the current node.
          */
-        Node<T>& operator*() 
+        N& operator*() 
         {
             return *this->current;
         }
@@ -83,7 +109,7 @@ class PreOrderIterator {
          * @brief Accesses members of the current node.
          * @return Pointer to the current node.
          */
-        Node<T>* operator->() 
+        N* operator->() 
         {
             return this->current;
         }
@@ -108,19 +134,29 @@ class PreOrderIterator {
             // Pop the current node from the top of the stack
             this->current = this->stack.top();
             this->stack.pop();
+            size_t depth = this->depths.top();
+            this->depths.pop();
 
             // Get the children of the current node
+            this->checkBinary(this->current);
             const auto& children = this->current->get_children();
 
-            // Push the children onto the stack in reverse order to process them in left-to-right order
-            if (children.size() > 1) 
+            // Push the children onto the stack in reverse order to process them in left-to-right order,
+            // unless they were skipped or lie beyond the depth limit
+            if (!this->skipNext && depth < this->maxDepth) 
             {
-                this->stack.push(children[1]);      // If there are more than one child, push the right child first
-            }
-            if (!children.empty()) 
-            {
-                this->stack.push(children[0]);      // Push the left child
+                if (children.size() > 1) 
+                {
+                    this->stack.push(children[1]);      // If there are more than one child, push the right child first
+                    this->depths.push(depth + 1);
+                }
+                if (!children.empty()) 
+                {
+                    this->stack.push(children[0]);      // Push the left child
+                    this->depths.push(depth + 1);
+                }
             }
+            this->skipNext = false;
 
             // Update the current node to the top of the stack
             if (!this->stack.empty()) 
@@ -138,6 +174,26 @@ class PreOrderIterator {
         }
         
 
+        /**
+         * @brief Marks the subtree below the current node as not to be visited.
+         * The next increment moves past the current node without expanding its children.
+         */
+        void skip_children() 
+        {
+            this->skipNext = true;
+        }
+
+
+        /**
+         * @brief Retrieves the depth of the current node, relative to the starting node.
+         * @return The depth of the current node (0 for the starting node).
+         */
+        size_t depth() const 
+        {
+            return this->depths.top();
+        }
+
+
         /**
          * @brief Compares this iterator with another for equality.
          * @param other The iterator to compare against.
@@ -170,6 +226,9 @@ class PreOrderIterator {
             {
                 this->current = other.current;
                 this->stack = other.stack;
+                this->depths = other.depths;
+                this->maxDepth = other.maxDepth;
+                this->skipNext = other.skipNext;
             }
             return *this;
         }
@@ -0,0 +1,153 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef SEGMENTTREE_HPP
+#define SEGMENTTREE_HPP
+
+#include <vector>
+#include <optional>
+#include <stdexcept>
+
+namespace ori {
+
+    /**
+     * @brief Combine functor returning the smaller of two values (uses operator<).
+     */
+    template <typename T>
+    struct MinCombine
+    {
+        T operator()(const T& a, const T& b) const
+        {
+            return b < a ? b : a;
+        }
+    };
+
+    /**
+     * @brief Combine functor returning the larger of two values (uses operator<).
+     */
+    template <typename T>
+    struct MaxCombine
+    {
+        T operator()(const T& a, const T& b) const
+        {
+            return a < b ? b : a;
+        }
+    };
+
+
+/**
+ * @class SegmentTree
+ * @brief Bottom-up segment tree over an array, with O(log n) point updates and range queries.
+ *
+ * The combine function only has to be associative; it does not need to be commutative and no
+ * identity element is required, so it works for sums, minimums, maximums and for types such as
+ * Complex with a user-supplied combine.
+ *
+ * @tparam V The type of the stored values.
+ * @tparam Combine Binary functor merging two values, applied left to right.
+ */
+template <typename V, typename Combine>
+class SegmentTree {
+
+    private:
+
+        size_t count;               // Number of leaves
+        std::vector<V> data;        // data[count + i] is leaf i, data[i] combines data[2i] and data[2i+1]
+        Combine combine;            // The merge function
+
+    public:
+
+        /**
+         * @brief Builds the segment tree over the given values in O(n).
+         * @param values The leaf values.
+         * @param merge The combine function.
+         */
+        SegmentTree(const std::vector<V>& values, Combine merge = Combine()) : count(values.size()), combine(merge)
+        {
+            if (values.empty()) return;
+
+            this->data.assign(2 * this->count, values[0]);
+            for (size_t i = 0; i < this->count; ++i)
+            {
+                this->data[this->count + i] = values[i];
+            }
+            for (size_t i = this->count - 1; i > 0; --i)
+            {
+                this->data[i] = this->combine(this->data[2 * i], this->data[2 * i + 1]);
+            }
+        }
+
+
+        /**
+         * @brief Retrieves the number of leaves.
+         */
+        size_t size() const
+        {
+            return this->count;
+        }
+
+
+        /**
+         * @brief Retrieves the value of a single leaf.
+         * @param position The leaf position.
+         * @return The leaf value.
+         */
+        const V& get(size_t position) const
+        {
+            return this->data[this->count + position];
+        }
+
+
+        /**
+         * @brief Replaces the value of a leaf and refreshes its ancestors in O(log n).
+         * @param position The leaf position.
+         * @param value The new value.
+         */
+        void set(size_t position, const V& value)
+        {
+            size_t i = this->count + position;
+            this->data[i] = value;
+            for (i /= 2; i > 0; i /= 2)
+            {
+                this->data[i] = this->combine(this->data[2 * i], this->data[2 * i + 1]);
+            }
+        }
+
+
+        /**
+         * @brief Combines the leaves in the range [first, last) in O(log n).
+         * @param first The first position of the range.
+         * @param last One past the last position of the range.
+         * @return The combined value.
+         * @throws std::out_of_range if the range is empty or exceeds the array.
+         */
+        V query(size_t first, size_t last) const
+        {
+            if (first >= last || last > this->count)
+            {
+                throw std::out_of_range("SegmentTree: invalid query range.");
+            }
+
+            // Left and right partial results are kept apart to respect the order of the combine function
+            std::optional<V> left;
+            std::optional<V> right;
+            for (first += this->count, last += this->count; first < last; first /= 2, last /= 2)
+            {
+                if (first & 1)
+                {
+                    left = left ? this->combine(*left, this->data[first]) : this->data[first];
+                    ++first;
+                }
+                if (last & 1)
+                {
+                    --last;
+                    right = right ? this->combine(this->data[last], *right) : this->data[last];
+                }
+            }
+
+            if (left && right) return this->combine(*left, *right);
+            return left ? *left : *right;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,1665 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef SERIALIZATION_HPP
+#define SERIALIZATION_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include "complex.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <queue>
+#include <array>
+#include <algorithm>
+#include <unordered_map>
+#include <stdexcept>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <exception>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ori {
+
+    /**
+     * @brief Decodes an unsigned little-endian integer of `width` bytes from memory.
+     */
+    inline uint64_t load_uint(const unsigned char* bytes, size_t width)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < width; ++i)
+        {
+            value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+        }
+        return value;
+    }
+
+
+    /**
+     * @brief Encodes an unsigned integer of `width` bytes into memory in little-endian order.
+     */
+    inline void store_uint(unsigned char* bytes, uint64_t value, size_t width)
+    {
+        for (size_t i = 0; i < width; ++i)
+        {
+            bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+
+    /**
+     * @brief Encodes a double into memory as its little-endian IEEE-754 bit pattern.
+     */
+    inline void store_double(unsigned char* bytes, double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        store_uint(bytes, bits, 8);
+    }
+
+
+    /**
+     * @brief Decodes a little-endian IEEE-754 double from memory.
+     */
+    inline double load_double(const unsigned char* bytes)
+    {
+        uint64_t bits = load_uint(bytes, 8);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+
+/**
+ * @class BinaryWriter
+ * @brief Buffered byte sink over a FILE* or a file descriptor, writing integers in little-endian order.
+ *
+ * Bytes are collected in a fixed buffer and handed to the file in large writes. The writer does not
+ * own the file: flush() (or the destructor) pushes the buffered bytes, closing is left to the caller.
+ */
+class BinaryWriter {
+
+    private:
+
+        std::FILE* file = nullptr;      // Target stream, or nullptr when writing to a descriptor
+        int fd = -1;                    // Target descriptor, or -1 when writing to a stream
+        std::vector<char> buffer;       // Bytes not yet handed to the target
+        size_t used = 0;                // Number of buffered bytes
+        uint64_t written = 0;           // Total number of bytes accepted so far
+
+
+        /**
+         * @brief Hands the buffered bytes to the target.
+         * @throws std::runtime_error if the target rejects them.
+         */
+        void drain()
+        {
+            const char* data = this->buffer.data();
+            size_t left = this->used;
+            if (this->file)
+            {
+                if (std::fwrite(data, 1, left, this->file) != left)
+                {
+                    throw std::runtime_error("BinaryWriter: write to stream failed.");
+                }
+            }
+            while (!this->file && left > 0)
+            {
+                ssize_t n = ::write(this->fd, data, left);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) throw std::runtime_error("BinaryWriter: write to descriptor failed.");
+                data += n;
+                left -= static_cast<size_t>(n);
+            }
+            this->used = 0;
+        }
+
+    public:
+
+        /**
+         * @brief Creates a writer over an open stream.
+         * @param stream The stream, opened for binary writing.
+         * @param bufferSize The size of the internal buffer in bytes.
+         */
+        explicit BinaryWriter(std::FILE* stream, size_t bufferSize = 1 << 16) : file(stream), buffer(bufferSize) {}
+
+
+        /**
+         * @brief Creates a writer over an open file descriptor.
+         * @param descriptor The descriptor, opened for writing.
+         * @param bufferSize The size of the internal buffer in bytes.
+         */
+        explicit BinaryWriter(int descriptor, size_t bufferSize = 1 << 16) : fd(descriptor), buffer(bufferSize) {}
+
+
+        BinaryWriter(const BinaryWriter&) = delete;
+        BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+
+        /**
+         * @brief Destructor that pushes the remaining bytes. Errors are ignored here; call flush() to see them.
+         */
+        ~BinaryWriter()
+        {
+            try
+            {
+                this->flush();
+            }
+            catch (const std::runtime_error&)
+            {
+            }
+        }
+
+
+        /**
+         * @brief Appends raw bytes.
+         */
+        void write(const void* data, size_t size)
+        {
+            const char* bytes = static_cast<const char*>(data);
+            this->written += size;
+            while (size > 0)
+            {
+                if (this->used == this->buffer.size()) this->drain();
+                size_t chunk = std::min(size, this->buffer.size() - this->used);
+                std::memcpy(this->buffer.data() + this->used, bytes, chunk);
+                this->used += chunk;
+                bytes += chunk;
+                size -= chunk;
+            }
+        }
+
+
+        /**
+         * @brief Appends an unsigned integer of `width` bytes in little-endian order.
+         */
+        void put_uint(uint64_t value, size_t width)
+        {
+            unsigned char bytes[8];
+            for (size_t i = 0; i < width; ++i)
+            {
+                bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+            this->write(bytes, width);
+        }
+
+
+        /**
+         * @brief Appends a double as its IEEE-754 bit pattern in little-endian order.
+         */
+        void put_double(double value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            this->put_uint(bits, 8);
+        }
+
+
+        /**
+         * @brief Pushes the buffered bytes to the target (and flushes the stream when writing to one).
+         * @throws std::runtime_error if the target rejects them.
+         */
+        void flush()
+        {
+            this->drain();
+            if (this->file && std::fflush(this->file) != 0)
+            {
+                throw std::runtime_error("BinaryWriter: flushing the stream failed.");
+            }
+        }
+
+
+        /**
+         * @brief Retrieves the total number of bytes written through this writer.
+         */
+        uint64_t bytes_written() const
+        {
+            return this->written;
+        }
+    };
+
+
+/**
+ * @class BinaryReader
+ * @brief Buffered byte source over a FILE* or a file descriptor, the counterpart of BinaryWriter.
+ * The reader fetches whole buffers, so it may consume bytes past the data it was asked for.
+ */
+class BinaryReader {
+
+    private:
+
+        std::FILE* file = nullptr;      // Source stream, or nullptr when reading from a descriptor
+        int fd = -1;                    // Source descriptor, or -1 when reading from a stream
+        std::vector<char> buffer;       // Bytes read ahead
+        size_t position = 0;            // Next unread byte in the buffer
+        size_t available = 0;           // Number of valid bytes in the buffer
+
+
+        /**
+         * @brief Refills the buffer from the source.
+         * @return False at the end of the input.
+         */
+        bool refill()
+        {
+            this->position = 0;
+            this->available = 0;
+            if (this->file)
+            {
+                this->available = std::fread(this->buffer.data(), 1, this->buffer.size(), this->file);
+                return this->available > 0;
+            }
+            while (true)
+            {
+                ssize_t n = ::read(this->fd, this->buffer.data(), this->buffer.size());
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) throw std::runtime_error("BinaryReader: read from descriptor failed.");
+                this->available = static_cast<size_t>(n);
+                return n > 0;
+            }
+        }
+
+    public:
+
+        /**
+         * @brief Creates a reader over an open stream.
+         */
+        explicit BinaryReader(std::FILE* stream, size_t bufferSize = 1 << 16) : file(stream), buffer(bufferSize) {}
+
+
+        /**
+         * @brief Creates a reader over an open file descriptor.
+         */
+        explicit BinaryReader(int descriptor, size_t bufferSize = 1 << 16) : fd(descriptor), buffer(bufferSize) {}
+
+
+        BinaryReader(const BinaryReader&) = delete;
+        BinaryReader& operator=(const BinaryReader&) = delete;
+
+
+        /**
+         * @brief Reads exactly `size` bytes.
+         * @throws std::runtime_error if the input ends first.
+         */
+        void read(void* data, size_t size)
+        {
+            char* bytes = static_cast<char*>(data);
+            while (size > 0)
+            {
+                if (this->position == this->available && !this->refill())
+                {
+                    throw std::runtime_error("BinaryReader: unexpected end of input.");
+                }
+                size_t chunk = std::min(size, this->available - this->position);
+                std::memcpy(bytes, this->buffer.data() + this->position, chunk);
+                this->position += chunk;
+                bytes += chunk;
+                size -= chunk;
+            }
+        }
+
+
+        /**
+         * @brief Reads an unsigned little-endian integer of `width` bytes.
+         */
+        uint64_t get_uint(size_t width)
+        {
+            unsigned char bytes[8];
+            this->read(bytes, width);
+            return load_uint(bytes, width);
+        }
+
+
+        /**
+         * @brief Skips `size` bytes.
+         * @throws std::runtime_error if the input ends first.
+         */
+        void skip(uint64_t size)
+        {
+            char scratch[256];
+            while (size > 0)
+            {
+                size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, sizeof(scratch)));
+                this->read(scratch, chunk);
+                size -= chunk;
+            }
+        }
+
+
+        /**
+         * @brief Reads a double stored as its little-endian bit pattern.
+         */
+        double get_double()
+        {
+            uint64_t bits = this->get_uint(8);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    };
+
+
+    /**
+     * @brief Encoding of one value type in the binary tree format.
+     * Specialised for the supported payloads; `tag` identifies the type in the file header and
+     * `width` is the encoded size in bytes, or 0 when it varies. Fixed-width codecs also provide
+     * `decode` and `encode`, which read and write a value straight in memory (used by FrozenTree
+     * and PersistentTree).
+     */
+    template <typename T>
+    struct ValueCodec;
+
+    template <>
+    struct ValueCodec<int>
+    {
+        static constexpr uint8_t tag = 1;
+        static constexpr size_t width = 4;
+        static void write(BinaryWriter& out, int value) { out.put_uint(static_cast<uint32_t>(value), 4); }
+        static int read(BinaryReader& in) { return static_cast<int>(static_cast<uint32_t>(in.get_uint(4))); }
+        static int decode(const unsigned char* bytes) { return static_cast<int>(static_cast<uint32_t>(load_uint(bytes, 4))); }
+        static void encode(unsigned char* bytes, int value) { store_uint(bytes, static_cast<uint32_t>(value), 4); }
+    };
+
+    template <>
+    struct ValueCodec<double>
+    {
+        static constexpr uint8_t tag = 2;
+        static constexpr size_t width = 8;
+        static void write(BinaryWriter& out, double value) { out.put_double(value); }
+        static double read(BinaryReader& in) { return in.get_double(); }
+        static double decode(const unsigned char* bytes) { return load_double(bytes); }
+        static void encode(unsigned char* bytes, double value) { store_double(bytes, value); }
+    };
+
+    template <>
+    struct ValueCodec<std::string>
+    {
+        static constexpr uint8_t tag = 3;
+        static constexpr size_t width = 0;      // A 32-bit length followed by the bytes
+
+        static void write(BinaryWriter& out, const std::string& value)
+        {
+            out.put_uint(value.size(), 4);
+            out.write(value.data(), value.size());
+        }
+
+        static std::string read(BinaryReader& in)
+        {
+            std::string value(static_cast<size_t>(in.get_uint(4)), '\0');
+            in.read(&value[0], value.size());
+            return value;
+        }
+    };
+
+    template <>
+    struct ValueCodec<Complex>
+    {
+        static constexpr uint8_t tag = 4;
+        static constexpr size_t width = 16;     // Real part, then imaginary part
+
+        static void write(BinaryWriter& out, const Complex& value)
+        {
+            out.put_double(value.getReal());
+            out.put_double(value.getImage());
+        }
+
+        static Complex read(BinaryReader& in)
+        {
+            double real = in.get_double();
+            return Complex(real, in.get_double());
+        }
+
+        static Complex decode(const unsigned char* bytes)
+        {
+            return Complex(load_double(bytes), load_double(bytes + 8));
+        }
+
+        static void encode(unsigned char* bytes, const Complex& value)
+        {
+            store_double(bytes, value.getReal());
+            store_double(bytes + 8, value.getImage());
+        }
+    };
+
+
+    /**
+     * @brief CRC-32 (the IEEE polynomial used by zlib) of a byte range, the block checksum of compressed files.
+     */
+    inline uint32_t crc32(const unsigned char* bytes, size_t size)
+    {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> entries{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[i] = c;
+            }
+            return entries;
+        }();
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+
+    /**
+     * @brief Appends an unsigned integer as a LEB128 varint (7 bits per byte, low bits first).
+     */
+    inline void put_varint(std::vector<unsigned char>& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+
+    /**
+     * @brief Decodes a LEB128 varint and advances the cursor past it.
+     * @throws std::runtime_error if the varint runs past `end` or is longer than 64 bits.
+     */
+    inline uint64_t get_varint(const unsigned char*& cursor, const unsigned char* end)
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (cursor == end) break;
+            unsigned char byte = *cursor++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw std::runtime_error("read_tree: malformed varint in a compressed block.");
+    }
+
+
+    /**
+     * @brief Maps a signed integer to an unsigned one so that values close to zero get short varints (0, -1, 1, -2 -> 0, 1, 2, 3).
+     */
+    inline uint64_t zigzag_encode(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+
+    /**
+     * @brief Inverse of zigzag_encode.
+     */
+    inline int64_t zigzag_decode(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+
+    /**
+     * @brief Encoding of the value column of compressed files, one block of values at a time.
+     * Every block is encoded on its own, so it can be checked and decoded without its neighbours.
+     * The general case stores the fixed-width encoding of ValueCodec; int, double and std::string
+     * are specialised below.
+     */
+    template <typename T>
+    struct ValueCompressor
+    {
+        static void encode(const std::vector<T>& block, std::vector<unsigned char>& out)
+        {
+            size_t start = out.size();
+            out.resize(start + block.size() * ValueCodec<T>::width);
+            for (size_t i = 0; i < block.size(); ++i)
+            {
+                ValueCodec<T>::encode(out.data() + start + i * ValueCodec<T>::width, block[i]);
+            }
+        }
+
+        static void decode(const unsigned char* cursor, const unsigned char* end, size_t count, std::vector<T>& values)
+        {
+            if (static_cast<size_t>(end - cursor) != count * ValueCodec<T>::width)
+            {
+                throw std::runtime_error("read_tree: value block of the wrong size.");
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                values.push_back(ValueCodec<T>::decode(cursor + i * ValueCodec<T>::width));
+            }
+        }
+    };
+
+
+    /**
+     * @brief Integers: the difference from the previous value in BFS order, zigzag-mapped, as a varint.
+     * Neighbouring values in BFS order are often close, so most take one or two bytes.
+     */
+    template <>
+    struct ValueCompressor<int>
+    {
+        static void encode(const std::vector<int>& block, std::vector<unsigned char>& out)
+        {
+            int64_t previous = 0;
+            for (int value : block)
+            {
+                put_varint(out, zigzag_encode(value - previous));
+                previous = value;
+            }
+        }
+
+        static void decode(const unsigned char* cursor, const unsigned char* end, size_t count, std::vector<int>& values)
+        {
+            int64_t previous = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                previous += zigzag_decode(get_varint(cursor, end));
+                values.push_back(static_cast<int>(previous));
+            }
+            if (cursor != end) throw std::runtime_error("read_tree: value block of the wrong size.");
+        }
+    };
+
+
+    /**
+     * @brief Doubles: the XOR of the bit pattern with the previous value's (as in Gorilla), stored
+     * byte-aligned as a control byte (leading zero bytes << 4 | trailing zero bytes) and the bytes
+     * in between. Equal neighbours cost one byte; close ones share sign, exponent and high mantissa bytes.
+     */
+    template <>
+    struct ValueCompressor<double>
+    {
+        static void encode(const std::vector<double>& block, std::vector<unsigned char>& out)
+        {
+            uint64_t previous = 0;
+            for (double value : block)
+            {
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                uint64_t x = bits ^ previous;
+                previous = bits;
+
+                unsigned leading = 0;
+                while (leading < 8 && ((x >> (56 - 8 * leading)) & 0xFF) == 0) ++leading;
+                unsigned trailing = 0;
+                while (leading + trailing < 8 && ((x >> (8 * trailing)) & 0xFF) == 0) ++trailing;
+
+                out.push_back(static_cast<unsigned char>(leading << 4 | trailing));
+                for (unsigned i = trailing; i < 8 - leading; ++i)
+                {
+                    out.push_back(static_cast<unsigned char>(x >> (8 * i)));
+                }
+            }
+        }
+
+        static void decode(const unsigned char* cursor, const unsigned char* end, size_t count, std::vector<double>& values)
+        {
+            uint64_t previous = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (cursor == end) throw std::runtime_error("read_tree: value block of the wrong size.");
+                unsigned leading = *cursor >> 4;
+                unsigned trailing = *cursor & 0x0F;
+                ++cursor;
+                if (leading + trailing > 8 || static_cast<size_t>(end - cursor) < 8 - leading - trailing)
+                {
+                    throw std::runtime_error("read_tree: malformed value block.");
+                }
+                uint64_t x = 0;
+                for (unsigned b = trailing; b < 8 - leading; ++b)
+                {
+                    x |= static_cast<uint64_t>(*cursor++) << (8 * b);
+                }
+                previous ^= x;
+                double value;
+                std::memcpy(&value, &previous, sizeof(value));
+                values.push_back(value);
+            }
+            if (cursor != end) throw std::runtime_error("read_tree: value block of the wrong size.");
+        }
+    };
+
+
+    /**
+     * @brief Strings: a per-block dictionary of the distinct strings (count, then length and bytes of
+     * each), followed by the dictionary index of every value, all as varints.
+     */
+    template <>
+    struct ValueCompressor<std::string>
+    {
+        static void encode(const std::vector<std::string>& block, std::vector<unsigned char>& out)
+        {
+            std::unordered_map<std::string, uint64_t> ids;
+            std::vector<const std::string*> dictionary;
+            std::vector<uint64_t> indexes;
+            indexes.reserve(block.size());
+            for (const std::string& value : block)
+            {
+                auto [entry, added] = ids.emplace(value, dictionary.size());
+                if (added) dictionary.push_back(&entry->first);
+                indexes.push_back(entry->second);
+            }
+
+            put_varint(out, dictionary.size());
+            for (const std::string* word : dictionary)
+            {
+                put_varint(out, word->size());
+                out.insert(out.end(), word->begin(), word->end());
+            }
+            for (uint64_t index : indexes)
+            {
+                put_varint(out, index);
+            }
+        }
+
+        static void decode(const unsigned char* cursor, const unsigned char* end, size_t count, std::vector<std::string>& values)
+        {
+            uint64_t words = get_varint(cursor, end);
+            if (words > static_cast<uint64_t>(end - cursor)) throw std::runtime_error("read_tree: malformed value block.");
+            std::vector<std::string> dictionary;
+            dictionary.reserve(static_cast<size_t>(words));
+            for (uint64_t i = 0; i < words; ++i)
+            {
+                uint64_t length = get_varint(cursor, end);
+                if (length > static_cast<uint64_t>(end - cursor)) throw std::runtime_error("read_tree: malformed value block.");
+                dictionary.emplace_back(reinterpret_cast<const char*>(cursor), static_cast<size_t>(length));
+                cursor += length;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint64_t index = get_varint(cursor, end);
+                if (index >= dictionary.size()) throw std::runtime_error("read_tree: malformed value block.");
+                values.push_back(dictionary[static_cast<size_t>(index)]);
+            }
+            if (cursor != end) throw std::runtime_error("read_tree: value block of the wrong size.");
+        }
+    };
+
+
+    /**
+     * @struct TreeFileHeader
+     * @brief The fixed 24-byte header of the binary tree format.
+     *
+     * Layout (little-endian): magic "ORTB" (4 bytes), format version (2), value type tag (1),
+     * width of a child count (1), k (4), flags (4, reserved, 0), node count (8). The header is
+     * followed by the topology column (one child count per node, in BFS order) and the value
+     * column (one encoded value per node, in the same order).
+     *
+     * A frozen file (flag FROZEN) is laid out for direct access instead: after the topology column
+     * and padding to a multiple of 8 bytes comes a link column of n + 1 64-bit BFS positions, the
+     * first child of each node followed by n (children are consecutive in BFS order, so node i has
+     * links[i + 1] - links[i] children), then the fixed-width value column. Offsets are relative to
+     * the start of the header.
+     *
+     * A compressed file (flag COMPRESSED) has the same two columns, split into blocks of a fixed
+     * number of nodes (the last block may be shorter), with the block size (4 bytes) right after the
+     * header. Every block is its payload length (4), the CRC-32 of its payload (4) and the payload:
+     * varint child counts for the topology column, ValueCompressor<T> output for the value column.
+     *
+     * A sharded file (flag SHARDED) splits the tree into subtrees that decode independently: after the
+     * header come the shard count (8 bytes), one ShardEntry per shard, then the shard payloads in
+     * index order. A payload holds the shard's nodes in pre-order, first their varint child counts
+     * within the shard, then their values as ValueCompressor<T> output.
+     */
+    struct TreeFileHeader
+    {
+        static constexpr char MAGIC[4] = {'O', 'R', 'T', 'B'};
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t SIZE = 24;
+        static constexpr uint32_t FROZEN = 1;       // Flag: link column and fixed-width values for memory mapping
+        static constexpr uint32_t COMPRESSED = 2;   // Flag: varint topology and compressed values in checksummed blocks
+        static constexpr uint32_t SHARDED = 4;      // Flag: independently decodable subtree shards behind an index
+
+        uint16_t version = VERSION;
+        uint8_t valueType = 0;
+        uint8_t countWidth = 1;
+        uint32_t k = 0;
+        uint32_t flags = 0;
+        uint64_t nodeCount = 0;
+
+
+        /**
+         * @brief Writes the header.
+         */
+        void write(BinaryWriter& out) const
+        {
+            out.write(MAGIC, 4);
+            out.put_uint(this->version, 2);
+            out.put_uint(this->valueType, 1);
+            out.put_uint(this->countWidth, 1);
+            out.put_uint(this->k, 4);
+            out.put_uint(this->flags, 4);
+            out.put_uint(this->nodeCount, 8);
+        }
+
+
+        /**
+         * @brief Reads and checks a header.
+         * @throws std::runtime_error if the magic or the version does not match.
+         */
+        static TreeFileHeader read(BinaryReader& in)
+        {
+            char magic[4];
+            in.read(magic, 4);
+            if (std::memcmp(magic, MAGIC, 4) != 0)
+            {
+                throw std::runtime_error("read_tree: not a binary tree file.");
+            }
+            TreeFileHeader header;
+            header.version = static_cast<uint16_t>(in.get_uint(2));
+            header.valueType = static_cast<uint8_t>(in.get_uint(1));
+            header.countWidth = static_cast<uint8_t>(in.get_uint(1));
+            header.k = static_cast<uint32_t>(in.get_uint(4));
+            header.flags = static_cast<uint32_t>(in.get_uint(4));
+            header.nodeCount = in.get_uint(8);
+            if (header.version != VERSION)
+            {
+                throw std::runtime_error("read_tree: unsupported format version.");
+            }
+            return header;
+        }
+
+
+        /**
+         * @brief Retrieves the offset of the link column of a frozen file.
+         */
+        uint64_t links_offset() const
+        {
+            uint64_t end = SIZE + this->nodeCount * this->countWidth;
+            return (end + 7) / 8 * 8;
+        }
+
+
+        /**
+         * @brief Retrieves the offset of the value column of a frozen file.
+         */
+        uint64_t values_offset() const
+        {
+            return this->links_offset() + 8 * (this->nodeCount + 1);
+        }
+    };
+
+
+    /**
+     * @brief Calls `visit` on every node of a subtree in BFS order, without copying any value.
+     */
+    template <typename T, typename Visit>
+    void visitBreadthFirst(const Node<T>* root, Visit visit)
+    {
+        std::queue<const Node<T>*> pending;
+        if (root) pending.push(root);
+        while (!pending.empty())
+        {
+            const Node<T>* node = pending.front();
+            pending.pop();
+            visit(node);
+            for (const Node<T>* child : node->get_children())
+            {
+                pending.push(child);
+            }
+        }
+    }
+
+
+    /**
+     * @brief Streams a tree in the binary format.
+     *
+     * The tree is walked three times (count, topology, values), so nothing beyond the BFS queue
+     * is materialised: values go straight from the nodes into the writer's buffer.
+     * @param tree The tree to write.
+     * @param out The destination; it is flushed at the end.
+     * @throws std::runtime_error if writing fails.
+     */
+    template <typename T, int k>
+    void write_tree(const Tree<T, k>& tree, BinaryWriter& out)
+    {
+        TreeFileHeader header;
+        header.valueType = ValueCodec<T>::tag;
+        header.countWidth = k < 256 ? 1 : 4;
+        header.k = static_cast<uint32_t>(k);
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>*) { ++header.nodeCount; });
+        header.write(out);
+
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>* node) { out.put_uint(node->get_children().size(), header.countWidth); });
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>* node) { ValueCodec<T>::write(out, node->get_value()); });
+        out.flush();
+    }
+
+
+    /**
+     * @brief Streams a tree in the binary format to an open stream (see write_tree above).
+     */
+    template <typename T, int k>
+    void write_tree(const Tree<T, k>& tree, std::FILE* file)
+    {
+        BinaryWriter out(file);
+        write_tree(tree, out);
+    }
+
+
+    /**
+     * @brief Streams a tree in the binary format to an open file descriptor (see write_tree above).
+     */
+    template <typename T, int k>
+    void write_tree(const Tree<T, k>& tree, int fd)
+    {
+        BinaryWriter out(fd);
+        write_tree(tree, out);
+    }
+
+
+    /**
+     * @brief Streams a tree in the frozen variant of the binary format, which FrozenTree maps and walks in place.
+     * Only fixed-width value types (int, double, Complex) can be frozen. The link column costs 8 bytes per node.
+     * @param tree The tree to write.
+     * @param out The destination, positioned at the start of the file; it is flushed at the end.
+     * @throws std::runtime_error if writing fails.
+     */
+    template <typename T, int k>
+    void write_frozen_tree(const Tree<T, k>& tree, BinaryWriter& out)
+    {
+        static_assert(ValueCodec<T>::width != 0, "Only fixed-width values can be frozen.");
+
+        TreeFileHeader header;
+        header.valueType = ValueCodec<T>::tag;
+        header.countWidth = k < 256 ? 1 : 4;
+        header.k = static_cast<uint32_t>(k);
+        header.flags = TreeFileHeader::FROZEN;
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>*) { ++header.nodeCount; });
+        header.write(out);
+
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>* node) { out.put_uint(node->get_children().size(), header.countWidth); });
+        const char zeros[8] = {};
+        out.write(zeros, static_cast<size_t>(header.links_offset() - TreeFileHeader::SIZE - header.nodeCount * header.countWidth));
+
+        uint64_t next = 1;      // BFS position of the next node's first child
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>* node) {
+            out.put_uint(next, 8);
+            next += node->get_children().size();
+        });
+        out.put_uint(header.nodeCount, 8);
+
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>* node) { ValueCodec<T>::write(out, node->get_value()); });
+        out.flush();
+    }
+
+
+    /**
+     * @brief Streams a tree in the frozen format to an open stream (see write_frozen_tree above).
+     */
+    template <typename T, int k>
+    void write_frozen_tree(const Tree<T, k>& tree, std::FILE* file)
+    {
+        BinaryWriter out(file);
+        write_frozen_tree(tree, out);
+    }
+
+
+    /**
+     * @brief Streams a tree in the frozen format to an open file descriptor (see write_frozen_tree above).
+     */
+    template <typename T, int k>
+    void write_frozen_tree(const Tree<T, k>& tree, int fd)
+    {
+        BinaryWriter out(fd);
+        write_frozen_tree(tree, out);
+    }
+
+
+    /**
+     * @brief Writes one block of a compressed column: payload length, CRC-32, payload. The payload is then cleared.
+     */
+    inline void writeCompressedBlock(BinaryWriter& out, std::vector<unsigned char>& payload)
+    {
+        out.put_uint(payload.size(), 4);
+        out.put_uint(crc32(payload.data(), payload.size()), 4);
+        out.write(payload.data(), payload.size());
+        payload.clear();
+    }
+
+
+    /**
+     * @brief Reads `size` bytes whose length came from the input into `payload`.
+     * The buffer grows with the bytes actually read, so a forged length fails as truncated input
+     * instead of forcing a huge allocation up front.
+     * @throws std::runtime_error if the input is truncated.
+     */
+    inline void readPayload(BinaryReader& in, std::vector<unsigned char>& payload, uint64_t size)
+    {
+        const size_t STEP = size_t(1) << 20;
+        payload.clear();
+        while (payload.size() < size)
+        {
+            size_t done = payload.size();
+            payload.resize(done + static_cast<size_t>(std::min<uint64_t>(STEP, size - done)));
+            in.read(payload.data() + done, payload.size() - done);
+        }
+    }
+
+
+    /**
+     * @brief Reads one block of a compressed column and checks its CRC-32.
+     * @param in The source.
+     * @param payload Receives the payload.
+     * @param column Name of the column, for error messages.
+     * @param index Position of the block in its column, for error messages.
+     * @throws std::runtime_error if the input is truncated or the checksum does not match.
+     */
+    inline void readCompressedBlock(BinaryReader& in, std::vector<unsigned char>& payload, const char* column, size_t index)
+    {
+        size_t size = static_cast<size_t>(in.get_uint(4));
+        uint32_t checksum = static_cast<uint32_t>(in.get_uint(4));
+        readPayload(in, payload, size);
+        if (crc32(payload.data(), size) != checksum)
+        {
+            throw std::runtime_error("read_tree: checksum mismatch in block " + std::to_string(index) + " of the " + column + " column.");
+        }
+    }
+
+
+    /**
+     * @brief Streams a tree in the compressed variant of the binary format, which read_tree reads like the others.
+     *
+     * Child counts become varints and values go through ValueCompressor<T> (delta + zigzag varints
+     * for int, XOR encoding for double, a dictionary for std::string), in blocks of `blockSize` nodes
+     * that each carry a CRC-32, so corruption is reported with the block it hit.
+     * @param tree The tree to write.
+     * @param out The destination; it is flushed at the end.
+     * @param blockSize Nodes per block: larger blocks compress strings better, smaller ones localise errors.
+     * @throws std::invalid_argument if blockSize is 0.
+     * @throws std::runtime_error if writing fails.
+     */
+    template <typename T, int k>
+    void write_compressed_tree(const Tree<T, k>& tree, BinaryWriter& out, size_t blockSize = 4096)
+    {
+        if (blockSize == 0 || blockSize > UINT32_MAX)
+        {
+            throw std::invalid_argument("write_compressed_tree: the block size must be between 1 and 2^32 - 1.");
+        }
+
+        TreeFileHeader header;
+        header.valueType = ValueCodec<T>::tag;
+        header.k = static_cast<uint32_t>(k);
+        header.flags = TreeFileHeader::COMPRESSED;
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>*) { ++header.nodeCount; });
+        header.write(out);
+        out.put_uint(blockSize, 4);
+
+        std::vector<unsigned char> payload;
+        size_t filled = 0;
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>* node) {
+            put_varint(payload, node->get_children().size());
+            if (++filled == blockSize)
+            {
+                writeCompressedBlock(out, payload);
+                filled = 0;
+            }
+        });
+        if (filled > 0) writeCompressedBlock(out, payload);
+
+        std::vector<T> block;
+        block.reserve(std::min<size_t>(blockSize, static_cast<size_t>(header.nodeCount)));
+        auto flushValues = [&]() {
+            ValueCompressor<T>::encode(block, payload);
+            writeCompressedBlock(out, payload);
+            block.clear();
+        };
+        visitBreadthFirst<T>(tree.root, [&](const Node<T>* node) {
+            block.push_back(node->get_value());
+            if (block.size() == blockSize) flushValues();
+        });
+        if (!block.empty()) flushValues();
+        out.flush();
+    }
+
+
+    /**
+     * @brief Streams a tree in the compressed format to an open stream (see write_compressed_tree above).
+     */
+    template <typename T, int k>
+    void write_compressed_tree(const Tree<T, k>& tree, std::FILE* file, size_t blockSize = 4096)
+    {
+        BinaryWriter out(file);
+        write_compressed_tree(tree, out, blockSize);
+    }
+
+
+    /**
+     * @brief Streams a tree in the compressed format to an open file descriptor (see write_compressed_tree above).
+     */
+    template <typename T, int k>
+    void write_compressed_tree(const Tree<T, k>& tree, int fd, size_t blockSize = 4096)
+    {
+        BinaryWriter out(fd);
+        write_compressed_tree(tree, out, blockSize);
+    }
+
+
+    /**
+     * @struct ShardEntry
+     * @brief One entry of the shard index of a sharded file (see write_sharded_tree), 48 bytes on disk.
+     */
+    struct ShardEntry
+    {
+        static constexpr size_t SIZE = 48;
+        static constexpr uint64_t NO_PARENT = UINT64_MAX;
+
+        uint64_t offset = 0;                    // Offset of the payload from the start of the header
+        uint32_t size = 0;                      // Payload length in bytes
+        uint32_t checksum = 0;                  // CRC-32 of the payload
+        uint64_t nodeCount = 0;                 // Nodes in the shard
+        uint64_t parentShard = NO_PARENT;       // Shard holding the parent of the shard root (NO_PARENT for the root shard)
+        uint64_t parentPosition = 0;            // Pre-order position of that parent within its shard
+        uint64_t slot = 0;                      // Position of the shard root among the children of its parent
+
+
+        /**
+         * @brief Writes the entry.
+         */
+        void write(BinaryWriter& out) const
+        {
+            out.put_uint(this->offset, 8);
+            out.put_uint(this->size, 4);
+            out.put_uint(this->checksum, 4);
+            out.put_uint(this->nodeCount, 8);
+            out.put_uint(this->parentShard, 8);
+            out.put_uint(this->parentPosition, 8);
+            out.put_uint(this->slot, 8);
+        }
+
+
+        /**
+         * @brief Decodes an entry from its 48 bytes.
+         */
+        static ShardEntry decode(const unsigned char* bytes)
+        {
+            ShardEntry entry;
+            entry.offset = load_uint(bytes, 8);
+            entry.size = static_cast<uint32_t>(load_uint(bytes + 8, 4));
+            entry.checksum = static_cast<uint32_t>(load_uint(bytes + 12, 4));
+            entry.nodeCount = load_uint(bytes + 16, 8);
+            entry.parentShard = load_uint(bytes + 24, 8);
+            entry.parentPosition = load_uint(bytes + 32, 8);
+            entry.slot = load_uint(bytes + 40, 8);
+            return entry;
+        }
+    };
+
+
+    /**
+     * @brief Streams a tree in the sharded variant of the binary format, for parallel loading with read_sharded_tree.
+     *
+     * The tree is cut into subtrees of roughly `shardSize` nodes: walking up from the leaves, a node
+     * whose not-yet-cut subtree reaches `shardSize` nodes starts a shard of its own, and the root
+     * starts the last one. A shard therefore holds between `shardSize` and about k * `shardSize`
+     * nodes, except the root shard, which may be smaller. Shards are numbered in pre-order of their
+     * roots, so a shard comes after the shard of its parent, and the cut children of a node come in
+     * child order. Each payload is encoded in memory first and written after the index.
+     * @param tree The tree to write.
+     * @param out The destination; it is flushed at the end.
+     * @param shardSize Target number of nodes per shard: smaller shards spread better over threads, larger ones compress better.
+     * @throws std::invalid_argument if shardSize is 0.
+     * @throws std::runtime_error if writing fails or a shard payload exceeds 4 GiB.
+     */
+    template <typename T, int k>
+    void write_sharded_tree(const Tree<T, k>& tree, BinaryWriter& out, size_t shardSize = 65536)
+    {
+        if (shardSize == 0) throw std::invalid_argument("write_sharded_tree: the shard size must be at least 1.");
+
+        // Pre-order walk: order[i] is node i, parent[i] and slot[i] locate it among its parent's children
+        std::vector<const Node<T>*> order;
+        std::vector<size_t> parent;
+        std::vector<size_t> slot;
+        struct Pending
+        {
+            const Node<T>* node;
+            size_t parent;
+            size_t slot;
+        };
+        std::vector<Pending> pending;
+        if (tree.root) pending.push_back({tree.root, 0, 0});
+        while (!pending.empty())
+        {
+            Pending current = pending.back();
+            pending.pop_back();
+            size_t at = order.size();
+            order.push_back(current.node);
+            parent.push_back(current.parent);
+            slot.push_back(current.slot);
+            const std::vector<Node<T>*>& children = current.node->get_children();
+            for (size_t c = children.size(); c > 0; --c) pending.push_back({children[c - 1], at, c - 1});
+        }
+
+        // Children before parents: cut a node when its uncut subtree is large enough
+        size_t count = order.size();
+        std::vector<size_t> remaining(count, 1);
+        std::vector<bool> cut(count, false);
+        for (size_t i = count; i-- > 1; )
+        {
+            if (remaining[i] >= shardSize) cut[i] = true;
+            else remaining[parent[i]] += remaining[i];
+        }
+        if (count > 0) cut[0] = true;
+
+        // Assign shards and in-shard pre-order positions, and collect the payloads
+        std::vector<ShardEntry> index;
+        std::vector<size_t> shardOf(count), position(count), inShardChildren(count, 0);
+        for (size_t i = 1; i < count; ++i)
+        {
+            if (!cut[i]) ++inShardChildren[parent[i]];
+        }
+        std::vector<std::vector<unsigned char>> topology;
+        std::vector<std::vector<T>> values;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (cut[i])
+            {
+                ShardEntry entry;
+                if (i > 0)
+                {
+                    entry.parentShard = shardOf[parent[i]];
+                    entry.parentPosition = position[parent[i]];
+                    entry.slot = slot[i];
+                }
+                shardOf[i] = index.size();
+                index.push_back(entry);
+                topology.emplace_back();
+                values.emplace_back();
+            }
+            else
+            {
+                shardOf[i] = shardOf[parent[i]];
+            }
+            size_t s = shardOf[i];
+            position[i] = static_cast<size_t>(index[s].nodeCount++);
+            put_varint(topology[s], inShardChildren[i]);
+            values[s].push_back(order[i]->get_value());
+        }
+
+        TreeFileHeader header;
+        header.valueType = ValueCodec<T>::tag;
+        header.k = static_cast<uint32_t>(k);
+        header.flags = TreeFileHeader::SHARDED;
+        header.nodeCount = count;
+        header.write(out);
+        out.put_uint(index.size(), 8);
+
+        uint64_t offset = TreeFileHeader::SIZE + 8 + index.size() * ShardEntry::SIZE;
+        for (size_t s = 0; s < index.size(); ++s)
+        {
+            ValueCompressor<T>::encode(values[s], topology[s]);
+            std::vector<T>().swap(values[s]);
+            if (topology[s].size() > UINT32_MAX) throw std::runtime_error("write_sharded_tree: shard payload too large.");
+            index[s].offset = offset;
+            index[s].size = static_cast<uint32_t>(topology[s].size());
+            index[s].checksum = crc32(topology[s].data(), topology[s].size());
+            offset += index[s].size;
+            index[s].write(out);
+        }
+        for (const std::vector<unsigned char>& payload : topology)
+        {
+            out.write(payload.data(), payload.size());
+        }
+        out.flush();
+    }
+
+
+    /**
+     * @brief Streams a tree in the sharded format to an open stream (see write_sharded_tree above).
+     */
+    template <typename T, int k>
+    void write_sharded_tree(const Tree<T, k>& tree, std::FILE* file, size_t shardSize = 65536)
+    {
+        BinaryWriter out(file);
+        write_sharded_tree(tree, out, shardSize);
+    }
+
+
+    /**
+     * @brief Streams a tree in the sharded format to an open file descriptor (see write_sharded_tree above).
+     */
+    template <typename T, int k>
+    void write_sharded_tree(const Tree<T, k>& tree, int fd, size_t shardSize = 65536)
+    {
+        BinaryWriter out(fd);
+        write_sharded_tree(tree, out, shardSize);
+    }
+
+
+    /**
+     * @brief Checks and decodes one shard payload into linked nodes, in pre-order (the first is the shard root).
+     * The nodes are owned by the caller; nothing is left allocated when decoding throws.
+     * @throws std::runtime_error if the checksum does not match or the payload is malformed.
+     */
+    template <typename T, int k>
+    std::vector<Node<T>*> decodeShard(const ShardEntry& entry, const unsigned char* payload, size_t shard)
+    {
+        if (crc32(payload, entry.size) != entry.checksum)
+        {
+            throw std::runtime_error("read_tree: checksum mismatch in shard " + std::to_string(shard) + ".");
+        }
+        if (entry.nodeCount == 0 || entry.nodeCount > entry.size)
+        {
+            throw std::runtime_error("read_tree: corrupt shard " + std::to_string(shard) + ".");
+        }
+
+        size_t count = static_cast<size_t>(entry.nodeCount);
+        const unsigned char* cursor = payload;
+        const unsigned char* end = payload + entry.size;
+        std::vector<uint64_t> childCounts(count);
+        for (uint64_t& children : childCounts) children = get_varint(cursor, end);
+        std::vector<T> values;
+        values.reserve(count);
+        ValueCompressor<T>::decode(cursor, end, count, values);
+
+        // Rebuild the pre-order shape with a stack of nodes still waiting for children
+        std::vector<Node<T>*> nodes;
+        nodes.reserve(count);
+        std::vector<std::pair<Node<T>*, uint64_t>> open;
+        bool valid = true;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (childCounts[i] > static_cast<uint64_t>(k) || (i > 0 && open.empty()))
+            {
+                valid = false;
+                break;
+            }
+            Node<T>* node = new Node<T>(values[i]);
+            nodes.push_back(node);
+            if (!open.empty())
+            {
+                open.back().first->add_child(node);
+                if (--open.back().second == 0) open.pop_back();
+            }
+            if (childCounts[i] > 0) open.push_back({node, childCounts[i]});
+        }
+        if (!valid || !open.empty())
+        {
+            for (Node<T>* node : nodes) delete node;
+            throw std::runtime_error("read_tree: corrupt topology in shard " + std::to_string(shard) + ".");
+        }
+        return nodes;
+    }
+
+
+    /**
+     * @brief Hangs every shard root under its parent, in index order, and returns the root of the tree.
+     * On failure the nodes are left unlinked for the caller to free.
+     * @throws std::runtime_error if the index does not describe a tree with at most k children per node.
+     */
+    template <typename T, int k>
+    Node<T>* stitchShards(const std::vector<ShardEntry>& index, const std::vector<std::vector<Node<T>*>>& shards)
+    {
+        for (size_t s = 1; s < index.size(); ++s)
+        {
+            const ShardEntry& entry = index[s];
+            if (entry.parentShard >= s || entry.parentPosition >= shards[entry.parentShard].size())
+            {
+                throw std::runtime_error("read_tree: corrupt shard index.");
+            }
+            Node<T>* parent = shards[entry.parentShard][entry.parentPosition];
+            std::vector<Node<T>*>& children = parent->get_children();
+            if (entry.slot > children.size() || children.size() >= static_cast<size_t>(k))
+            {
+                throw std::runtime_error("read_tree: corrupt shard index.");
+            }
+            Node<T>* root = shards[s].front();
+            children.insert(children.begin() + static_cast<std::ptrdiff_t>(entry.slot), root);
+        }
+        return shards.empty() ? nullptr : shards.front().front();
+    }
+
+
+    /**
+     * @brief Checks the shard index of a sharded file against its header and, when known, the file size.
+     * @param available The number of bytes from the start of the tree to the end of the file.
+     * @throws std::runtime_error if the index is inconsistent or a shard ends past the file.
+     */
+    inline void checkShardIndex(const TreeFileHeader& header, const std::vector<ShardEntry>& index, uint64_t available = UINT64_MAX)
+    {
+        uint64_t nodes = 0;
+        uint64_t offset = TreeFileHeader::SIZE + 8 + index.size() * ShardEntry::SIZE;
+        for (size_t s = 0; s < index.size(); ++s)
+        {
+            bool rootShard = index[s].parentShard == ShardEntry::NO_PARENT;
+            if (index[s].offset != offset || rootShard != (s == 0) || index[s].nodeCount > header.nodeCount - nodes)
+            {
+                throw std::runtime_error("read_tree: corrupt shard index.");
+            }
+            if (index[s].size > available || offset > available - index[s].size)
+            {
+                throw std::runtime_error("read_tree: shard " + std::to_string(s) + " ends past the end of the file.");
+            }
+            nodes += index[s].nodeCount;
+            offset += index[s].size;
+        }
+        if (nodes != header.nodeCount) throw std::runtime_error("read_tree: corrupt shard index.");
+    }
+
+
+    /**
+     * @brief Frees the nodes of decoded shards that were not handed to a tree.
+     */
+    template <typename T>
+    void freeShards(std::vector<std::vector<Node<T>*>>& shards)
+    {
+        for (std::vector<Node<T>*>& nodes : shards)
+        {
+            for (Node<T>* node : nodes) delete node;
+            nodes.clear();
+        }
+    }
+
+
+    /**
+     * @brief Replaces the contents of a tree with stitched shards, or frees the shards when stitching fails.
+     */
+    template <typename T, int k>
+    void adoptShards(Tree<T, k>& tree, const std::vector<ShardEntry>& index, std::vector<std::vector<Node<T>*>>& shards)
+    {
+        Node<T>* root = nullptr;
+        try
+        {
+            root = stitchShards<T, k>(index, shards);
+        }
+        catch (...)
+        {
+            freeShards(shards);
+            throw;
+        }
+        tree.clear();
+        tree.add_root(root);
+    }
+
+
+    /**
+     * @brief Reads a tree in the binary format, replacing the contents of `tree`.
+     *
+     * BFS order places the children of every node next to each other, so the parent of each node
+     * follows from the child counts alone; the tree is then built in one block with build_from_parents.
+     * Frozen files are accepted too (their link column is skipped), and so are compressed files, whose
+     * block checksums are verified as the blocks arrive, and sharded files, decoded one shard after the
+     * other (read_sharded_tree decodes them in parallel).
+     * @param tree The tree to fill.
+     * @param in The source.
+     * @throws std::runtime_error if the input is truncated, malformed or corrupt, holds another value type or needs a larger k.
+     */
+    template <typename T, int k>
+    void read_tree(Tree<T, k>& tree, BinaryReader& in)
+    {
+        TreeFileHeader header = TreeFileHeader::read(in);
+        if (header.valueType != ValueCodec<T>::tag)
+        {
+            throw std::runtime_error("read_tree: the file holds another value type.");
+        }
+        if (header.k > static_cast<uint32_t>(k) || (header.countWidth != 1 && header.countWidth != 4))
+        {
+            throw std::runtime_error("read_tree: the file needs a larger k.");
+        }
+
+        if (header.flags & TreeFileHeader::SHARDED)
+        {
+            uint64_t shardCount = in.get_uint(8);
+            if (shardCount > header.nodeCount) throw std::runtime_error("read_tree: corrupt shard index.");
+            std::vector<ShardEntry> index;
+            unsigned char bytes[ShardEntry::SIZE];
+            for (uint64_t s = 0; s < shardCount; ++s)
+            {
+                in.read(bytes, sizeof(bytes));
+                index.push_back(ShardEntry::decode(bytes));
+            }
+            checkShardIndex(header, index);
+
+            std::vector<std::vector<Node<T>*>> shards;
+            std::vector<unsigned char> payload;
+            try
+            {
+                for (size_t s = 0; s < index.size(); ++s)
+                {
+                    readPayload(in, payload, index[s].size);
+                    shards.push_back(decodeShard<T, k>(index[s], payload.data(), s));
+                }
+            }
+            catch (...)
+            {
+                freeShards(shards);
+                throw;
+            }
+            adoptShards(tree, index, shards);
+            return;
+        }
+
+        bool compressed = header.flags & TreeFileHeader::COMPRESSED;
+        size_t blockSize = compressed ? static_cast<size_t>(in.get_uint(4)) : 0;
+        if (compressed && blockSize == 0)
+        {
+            throw std::runtime_error("read_tree: compressed file with an empty block size.");
+        }
+        std::vector<unsigned char> payload;
+        const unsigned char* cursor = nullptr;
+        const unsigned char* end = nullptr;
+
+        // The node count comes from the input, so the parent column grows as the child counts arrive
+        if (header.nodeCount > SIZE_MAX / sizeof(size_t)) throw std::runtime_error("read_tree: corrupt node count.");
+        size_t count = static_cast<size_t>(header.nodeCount);
+        std::vector<size_t> parents;
+        if (count > 0) parents.push_back(Tree<T, k>::NO_PARENT);
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint64_t children;
+            if (compressed)
+            {
+                if (i % blockSize == 0)
+                {
+                    if (cursor != end) throw std::runtime_error("read_tree: topology block of the wrong size.");
+                    readCompressedBlock(in, payload, "topology", i / blockSize);
+                    cursor = payload.data();
+                    end = cursor + payload.size();
+                }
+                children = get_varint(cursor, end);
+            }
+            else
+            {
+                children = in.get_uint(header.countWidth);
+            }
+            if (children > header.k || children > count - parents.size())
+            {
+                throw std::runtime_error("read_tree: corrupt topology.");
+            }
+            for (uint64_t c = 0; c < children; ++c)
+            {
+                parents.push_back(i);
+            }
+        }
+        if (parents.size() != count)
+        {
+            throw std::runtime_error("read_tree: corrupt topology.");
+        }
+
+        if (header.flags & TreeFileHeader::FROZEN)
+        {
+            in.skip(header.values_offset() - TreeFileHeader::SIZE - header.nodeCount * header.countWidth);
+        }
+
+        // Every node has been read by now, so the count is backed by the input
+        std::vector<T> values;
+        values.reserve(count);
+        if (compressed)
+        {
+            if (cursor != end) throw std::runtime_error("read_tree: topology block of the wrong size.");
+            for (size_t first = 0; first < count; first += blockSize)
+            {
+                readCompressedBlock(in, payload, "value", first / blockSize);
+                ValueCompressor<T>::decode(payload.data(), payload.data() + payload.size(), std::min(blockSize, count - first), values);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                values.push_back(ValueCodec<T>::read(in));
+            }
+        }
+        tree.build_from_parents(values, parents);
+    }
+
+
+    /**
+     * @brief Reads a tree in the binary format from an open stream (see read_tree above).
+     */
+    template <typename T, int k>
+    void read_tree(Tree<T, k>& tree, std::FILE* file)
+    {
+        BinaryReader in(file);
+        read_tree(tree, in);
+    }
+
+
+    /**
+     * @brief Reads a tree in the binary format from an open file descriptor (see read_tree above).
+     */
+    template <typename T, int k>
+    void read_tree(Tree<T, k>& tree, int fd)
+    {
+        BinaryReader in(fd);
+        read_tree(tree, in);
+    }
+
+
+    /**
+     * @brief Reads a tree from an open file descriptor, decoding the shards of a sharded file on a pool of threads.
+     *
+     * The header and the shard index are read first; then up to `threads` workers take shards in
+     * index order from a shared counter, read each payload with pread, check it and build its nodes.
+     * The calling thread finally hangs every shard root under its parent, which costs O(shards).
+     * Files that are not sharded are handed to read_tree. The descriptor is left past the tree.
+     * @param tree The tree to fill.
+     * @param fd The descriptor, positioned at the start of the tree file.
+     * @param threads The maximum number of threads (0 uses the number of hardware threads).
+     * @throws std::runtime_error if the input cannot be read or is truncated, malformed or corrupt, holds another value type or needs a larger k.
+     */
+    template <typename T, int k>
+    void read_sharded_tree(Tree<T, k>& tree, int fd, size_t threads = 0)
+    {
+        off_t base = ::lseek(fd, 0, SEEK_CUR);
+        if (base < 0) throw std::runtime_error("read_sharded_tree: the descriptor is not seekable.");
+
+        TreeFileHeader header;
+        std::vector<ShardEntry> index;
+        {
+            BinaryReader in(fd, 1 << 12);
+            header = TreeFileHeader::read(in);
+            if (header.flags & TreeFileHeader::SHARDED)
+            {
+                uint64_t shardCount = in.get_uint(8);
+                if (shardCount > header.nodeCount) throw std::runtime_error("read_tree: corrupt shard index.");
+                unsigned char bytes[ShardEntry::SIZE];
+                for (uint64_t s = 0; s < shardCount; ++s)
+                {
+                    in.read(bytes, sizeof(bytes));
+                    index.push_back(ShardEntry::decode(bytes));
+                }
+            }
+        }
+        if (!(header.flags & TreeFileHeader::SHARDED))
+        {
+            if (::lseek(fd, base, SEEK_SET) < 0) throw std::runtime_error("read_sharded_tree: the descriptor is not seekable.");
+            read_tree(tree, fd);
+            return;
+        }
+        if (header.valueType != ValueCodec<T>::tag) throw std::runtime_error("read_tree: the file holds another value type.");
+        if (header.k > static_cast<uint32_t>(k)) throw std::runtime_error("read_tree: the file needs a larger k.");
+
+        // Bound the shard sizes by the file before the workers allocate their payloads
+        struct stat status;
+        uint64_t available = UINT64_MAX;
+        if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode))
+        {
+            available = status.st_size > base ? static_cast<uint64_t>(status.st_size - base) : 0;
+        }
+        checkShardIndex(header, index, available);
+
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        size_t workers = std::max<size_t>(1, std::min(threads, index.size()));
+        std::vector<std::vector<Node<T>*>> shards(index.size());
+        std::vector<std::exception_ptr> errors(workers);
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+
+        auto work = [&](size_t worker) {
+            std::vector<unsigned char> payload;
+            try
+            {
+                for (size_t s = next++; s < index.size() && !failed; s = next++)
+                {
+                    payload.resize(index[s].size);
+                    unsigned char* data = payload.data();
+                    size_t left = payload.size();
+                    off_t at = base + static_cast<off_t>(index[s].offset);
+                    while (left > 0)
+                    {
+                        ssize_t got = ::pread(fd, data, left, at);
+                        if (got < 0 && errno == EINTR) continue;
+                        if (got <= 0) throw std::runtime_error("read_tree: shard " + std::to_string(s) + " is truncated.");
+                        data += got;
+                        left -= static_cast<size_t>(got);
+                        at += got;
+                    }
+                    shards[s] = decodeShard<T, k>(index[s], payload.data(), s);
+                }
+            }
+            catch (...)
+            {
+                errors[worker] = std::current_exception();
+                failed = true;
+            }
+        };
+
+        // Like Tree::runTasks: worker 0 runs on the calling thread
+        std::vector<std::future<void>> running;
+        for (size_t w = 1; w < workers; ++w) running.push_back(std::async(std::launch::async, work, w));
+        work(0);
+        for (std::future<void>& task : running) task.get();
+
+        for (std::exception_ptr& error : errors)
+        {
+            if (!error) continue;
+            freeShards(shards);
+            std::rethrow_exception(error);
+        }
+        adoptShards(tree, index, shards);
+        uint64_t end = index.empty() ? TreeFileHeader::SIZE + 8 : index.back().offset + index.back().size;
+        ::lseek(fd, base + static_cast<off_t>(end), SEEK_SET);
+    }
+
+
+    /**
+     * @brief Opens a tree file and reads it with read_sharded_tree (see above).
+     * @throws std::runtime_error if the file cannot be opened, or as read_sharded_tree.
+     */
+    template <typename T, int k>
+    void read_sharded_tree(Tree<T, k>& tree, const std::string& path, size_t threads = 0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("read_sharded_tree: cannot open " + path + ".");
+        try
+        {
+            read_sharded_tree(tree, fd, threads);
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+    }
+}
+
+#endif
@@ -0,0 +1,194 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef SORTEDINDEX_HPP
+#define SORTEDINDEX_HPP
+
+#include "node.hpp"
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <type_traits>
+#include <utility>
+
+namespace ori {
+
+    /**
+     * @brief Detects whether a type supports operator<.
+     * The ordered index and the zone maps are available only for such types, so a Tree of any other
+     * type compiles and works without them.
+     */
+    template <typename T, typename = void>
+    struct is_ordered : std::false_type {};
+
+    template <typename T>
+    struct is_ordered<T, std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>> : std::true_type {};
+
+    template <typename T>
+    inline constexpr bool is_ordered_v = is_ordered<T>::value;
+
+
+    class Complex;
+
+    /**
+     * @brief Detects whether operator< on a type is a strict weak ordering, which sorting and binary search need.
+     * Every ordered type is assumed to be one, except Complex: its operator< compares magnitudes and
+     * holds both ways for distinct numbers of equal magnitude, so there is no ordered index over Complex values.
+     */
+    template <typename T>
+    struct is_strictly_ordered : is_ordered<T> {};
+
+    template <>
+    struct is_strictly_ordered<Complex> : std::false_type {};
+
+    template <typename T>
+    inline constexpr bool is_strictly_ordered_v = is_strictly_ordered<T>::value;
+
+
+/**
+ * @class SortedIndex
+ * @brief Ordered index of nodes by value, answering range scans in O(log n + m).
+ *
+ * The nodes are kept in a sorted array. Insertions are appended to a pending buffer and merged
+ * lazily before the next query: the buffer is sorted on its own and merged in linear time, so a
+ * burst of m insertions costs O(m log m + n) once instead of a full re-sort per query. Value
+ * changes are deferred the same way: update() only records the node in O(1), and the next merge
+ * takes the moved nodes out of the array and sorts them back in with the insertions.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes (operator< must be a strict weak ordering, see is_strictly_ordered).
+ */
+template <typename T>
+class SortedIndex {
+
+    private:
+
+        std::vector<Node<T>*> sorted;       // Indexed nodes in value order
+        std::vector<Node<T>*> pending;      // Nodes inserted since the last merge
+        std::unordered_set<Node<T>*> moved; // Indexed nodes whose value changed since the last merge
+
+
+        /**
+         * @brief Orders two nodes by their values.
+         */
+        static bool lessByValue(const Node<T>* a, const Node<T>* b)
+        {
+            return a->get_value() < b->get_value();
+        }
+
+
+        /**
+         * @brief Merges the pending insertions into the sorted array.
+         */
+        void merge()
+        {
+            if (!this->moved.empty())
+            {
+                for (std::vector<Node<T>*>* part : {&this->pending, &this->sorted})
+                {
+                    part->erase(std::remove_if(part->begin(), part->end(),
+                        [&](Node<T>* node) { return this->moved.count(node) != 0; }), part->end());
+                }
+                this->pending.insert(this->pending.end(), this->moved.begin(), this->moved.end());
+                this->moved.clear();
+            }
+            if (this->pending.empty()) return;
+
+            std::sort(this->pending.begin(), this->pending.end(), lessByValue);
+            size_t middle = this->sorted.size();
+            this->sorted.insert(this->sorted.end(), this->pending.begin(), this->pending.end());
+            std::inplace_merge(this->sorted.begin(), this->sorted.begin() + static_cast<std::ptrdiff_t>(middle), this->sorted.end(), lessByValue);
+            this->pending.clear();
+        }
+
+    public:
+
+        /**
+         * @brief Retrieves the number of indexed nodes.
+         */
+        size_t size() const
+        {
+            return this->sorted.size() + this->pending.size();
+        }
+
+
+        /**
+         * @brief Removes all entries.
+         */
+        void clear()
+        {
+            this->sorted.clear();
+            this->pending.clear();
+            this->moved.clear();
+        }
+
+
+        /**
+         * @brief Adds a node to the index under its current value.
+         * @param node The node to add.
+         */
+        void insert(Node<T>* node)
+        {
+            this->pending.push_back(node);
+        }
+
+
+        /**
+         * @brief Records in O(1) that the value of an indexed node changed; it is re-sorted at the next merge.
+         * @param node The node, which must be in the index.
+         */
+        void update(Node<T>* node)
+        {
+            this->moved.insert(node);
+        }
+
+
+        /**
+         * @brief Removes a set of nodes from the index in one O(n + m) pass.
+         * @param nodes The nodes to remove.
+         */
+        void erase_all(const std::vector<Node<T>*>& nodes)
+        {
+            if (nodes.empty()) return;
+
+            std::unordered_set<const Node<T>*> doomed(nodes.begin(), nodes.end());
+            for (Node<T>* node : nodes)
+            {
+                this->moved.erase(node);
+            }
+            for (std::vector<Node<T>*>* part : {&this->pending, &this->sorted})
+            {
+                part->erase(std::remove_if(part->begin(), part->end(),
+                    [&](const Node<T>* node) { return doomed.count(node) != 0; }), part->end());
+            }
+        }
+
+
+        /**
+         * @brief Finds all nodes whose value lies in [lo, hi].
+         * @param lo The lower bound (inclusive).
+         * @param hi The upper bound (inclusive).
+         * @return The matching nodes in value order.
+         */
+        std::vector<Node<T>*> range(const T& lo, const T& hi)
+        {
+            this->merge();
+            auto first = std::lower_bound(this->sorted.begin(), this->sorted.end(), lo,
+                [](const Node<T>* node, const T& value) { return node->get_value() < value; });
+            auto last = std::upper_bound(first, this->sorted.end(), hi,
+                [](const T& value, const Node<T>* node) { return value < node->get_value(); });
+            return std::vector<Node<T>*>(first, last);
+        }
+
+
+        /**
+         * @brief Retrieves all indexed nodes in value order.
+         * @return Reference to the sorted array, valid until the next modification of the index.
+         */
+        const std::vector<Node<T>*>& ordered()
+        {
+            this->merge();
+            return this->sorted;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef SUBTREEAGGREGATE_HPP
+#define SUBTREEAGGREGATE_HPP
+
+#include "node.hpp"
+#include "tree_index.hpp"
+#include "segment_tree.hpp"
+#include <vector>
+#include <functional>
+
+namespace ori {
+
+/**
+ * @class SubtreeAggregate
+ * @brief Interactive subtree aggregate queries (sum, min, max, ...) with point updates, both O(log n).
+ *
+ * The node values are laid out by their Euler-tour position, where every subtree is a contiguous
+ * range, and a segment tree combines them. The structure keeps its own copy of the values:
+ * updates made through it are reflected by its queries but are not written back to the nodes.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam Combine Associative functor merging two values (std::plus<T> by default).
+ */
+template <typename T, typename Combine = std::plus<T>>
+class SubtreeAggregate {
+
+    private:
+
+        const TreeIndex<T>& index;          // Maps nodes to tour positions
+        SegmentTree<T, Combine> segments;   // Aggregates over the tour
+
+
+        /**
+         * @brief Collects the node values in tour order.
+         */
+        static std::vector<T> collectValues(const TreeIndex<T>& treeIndex)
+        {
+            std::vector<T> values;
+            values.reserve(treeIndex.size());
+            for (Node<T>* node : treeIndex)
+            {
+                values.push_back(node->get_value());
+            }
+            return values;
+        }
+
+    public:
+
+        /**
+         * @brief Builds the aggregate structure in O(n).
+         * @param treeIndex The Euler-tour index of the tree, which must outlive this object.
+         * @param combine The combine function.
+         */
+        SubtreeAggregate(const TreeIndex<T>& treeIndex, Combine combine = Combine())
+            : index(treeIndex), segments(collectValues(treeIndex), combine) {}
+
+
+        /**
+         * @brief Combines the values of all nodes in the subtree of a node.
+         * @param node The root of the subtree.
+         * @return The aggregate of the subtree, including the node itself.
+         */
+        T query(const Node<T>* node) const
+        {
+            auto range = this->index.subtree_range(node);
+            return this->segments.query(range.first, range.second);
+        }
+
+
+        /**
+         * @brief Retrieves the current value of a node as seen by this structure.
+         * @param node The node to look up.
+         */
+        const T& value(const Node<T>* node) const
+        {
+            return this->segments.get(this->index.entry(node));
+        }
+
+
+        /**
+         * @brief Replaces the value of a node.
+         * @param node The node to update.
+         * @param value The new value.
+         */
+        void set(const Node<T>* node, const T& value)
+        {
+            this->segments.set(this->index.entry(node), value);
+        }
+
+
+        /**
+         * @brief Adds a delta to the value of a node (requires operator+ on T).
+         * @param node The node to update.
+         * @param delta The amount to add.
+         */
+        void add(const Node<T>* node, const T& delta)
+        {
+            size_t position = this->index.entry(node);
+            this->segments.set(position, this->segments.get(position) + delta);
+        }
+    };
+}
+
+#endif
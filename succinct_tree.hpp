@@ -0,0 +1,815 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef SUCCINCTTREE_HPP
+#define SUCCINCTTREE_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include <vector>
+#include <deque>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <utility>
+
+namespace ori {
+
+/**
+ * @class RankSelectBits
+ * @brief Static bit vector with constant-time rank and near-constant-time select over its set bits.
+ *
+ * Rank reads a cumulative count per 512-bit superblock and a 16-bit count per word, then counts
+ * the bits of one word. Select starts from a sample kept for every 512th set bit, binary-searches
+ * the superblocks up to the next sample (usually one or two), then walks at most eight words.
+ * The counts add about 0.38 bits per stored bit.
+ */
+class RankSelectBits {
+
+    private:
+
+        std::vector<uint64_t> words{0};         // The bits, least significant first, plus a zero word at the end
+        size_t length = 0;                      // Number of bits
+        std::vector<uint64_t> superRanks;       // Set bits before every superblock, then the total
+        std::vector<uint16_t> wordRanks;        // Set bits before every word, counted from the start of its superblock
+        std::vector<size_t> samples;            // Superblock holding set bit number 512 * i
+
+    public:
+
+        static constexpr size_t WORDS_PER_SUPERBLOCK = 8;      // 512-bit superblocks
+
+
+        /**
+         * @brief Appends a bit. All bits must be appended before build() is called.
+         */
+        void push_back(bool bit)
+        {
+            if (bit) this->words[this->length / 64] |= uint64_t(1) << (this->length % 64);
+            if (++this->length % 64 == 0) this->words.push_back(0);
+        }
+
+
+        /**
+         * @brief Builds the rank and select counts in one pass over the words.
+         */
+        void build()
+        {
+            size_t superblocks = (this->words.size() + WORDS_PER_SUPERBLOCK - 1) / WORDS_PER_SUPERBLOCK;
+            this->superRanks.assign(superblocks + 1, 0);
+            this->wordRanks.assign(this->words.size(), 0);
+            uint64_t total = 0;
+            for (size_t w = 0; w < this->words.size(); ++w)
+            {
+                if (w % WORDS_PER_SUPERBLOCK == 0) this->superRanks[w / WORDS_PER_SUPERBLOCK] = total;
+                this->wordRanks[w] = static_cast<uint16_t>(total - this->superRanks[w / WORDS_PER_SUPERBLOCK]);
+                total += static_cast<uint64_t>(__builtin_popcountll(this->words[w]));
+            }
+            this->superRanks[superblocks] = total;
+
+            this->samples.clear();
+            for (size_t s = 0; s < superblocks; ++s)
+            {
+                while (this->samples.size() * 512 < this->superRanks[s + 1]) this->samples.push_back(s);
+            }
+        }
+
+
+        /**
+         * @brief Retrieves the number of bits.
+         */
+        size_t size() const
+        {
+            return this->length;
+        }
+
+
+        /**
+         * @brief Retrieves the bit at a position.
+         */
+        bool get(size_t position) const
+        {
+            return (this->words[position / 64] >> (position % 64)) & 1;
+        }
+
+
+        /**
+         * @brief Retrieves the word holding a position, for scans that process several bits at a time.
+         */
+        uint64_t word(size_t index) const
+        {
+            return this->words[index];
+        }
+
+
+        /**
+         * @brief Counts the set bits before a position, in O(1).
+         * @param position A position in [0, size()].
+         */
+        size_t rank1(size_t position) const
+        {
+            uint64_t below = this->words[position / 64] & ((uint64_t(1) << (position % 64)) - 1);
+            return static_cast<size_t>(this->superRanks[position / 512] + this->wordRanks[position / 64])
+                + static_cast<size_t>(__builtin_popcountll(below));
+        }
+
+
+        /**
+         * @brief Retrieves the number of set bits before the start of a superblock.
+         */
+        size_t superblock_rank(size_t superblock) const
+        {
+            return static_cast<size_t>(this->superRanks[superblock]);
+        }
+
+
+        /**
+         * @brief Finds the position of a set bit.
+         * @param index The number of set bits before the wanted one; must be less than rank1(size()).
+         */
+        size_t select1(size_t index) const
+        {
+            size_t sample = index / 512;
+            size_t first = this->samples[sample];
+            size_t last = sample + 1 < this->samples.size() ? this->samples[sample + 1] + 1 : this->superRanks.size() - 1;
+            size_t s = static_cast<size_t>(std::upper_bound(this->superRanks.begin() + static_cast<std::ptrdiff_t>(first),
+                                                            this->superRanks.begin() + static_cast<std::ptrdiff_t>(last),
+                                                            static_cast<uint64_t>(index)) - this->superRanks.begin()) - 1;
+
+            size_t remaining = index - static_cast<size_t>(this->superRanks[s]);
+            size_t w = s * WORDS_PER_SUPERBLOCK;
+            size_t end = std::min(w + WORDS_PER_SUPERBLOCK, this->words.size());
+            while (w + 1 < end && this->wordRanks[w + 1] <= remaining) ++w;
+            remaining -= this->wordRanks[w];
+
+            uint64_t bits = this->words[w];
+            for (; remaining > 0; --remaining) bits &= bits - 1;     // Drop the lower set bits
+            return w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+        }
+
+
+        /**
+         * @brief Retrieves the memory used by the bits and the counts, in bytes.
+         */
+        size_t memory_bytes() const
+        {
+            return this->words.size() * sizeof(uint64_t) + this->superRanks.size() * sizeof(uint64_t)
+                + this->wordRanks.size() * sizeof(uint16_t) + this->samples.size() * sizeof(size_t);
+        }
+    };
+
+
+    template <typename T, int k>
+    class SuccinctTree;
+
+
+/**
+ * @class SuccinctNode
+ * @brief Handle to one node of a SuccinctTree: the tree and the position of the node's opening parenthesis.
+ *
+ * A default-constructed handle means "no node", as returned for the parent of the root.
+ */
+template <typename T, int k = 2>
+class SuccinctNode {
+
+    private:
+
+        const SuccinctTree<T, k>* tree = nullptr;   // The tree the node belongs to, or nullptr for no node
+        size_t position = 0;                        // Position of the opening parenthesis in the topology
+
+    public:
+
+        SuccinctNode() {}
+        SuccinctNode(const SuccinctTree<T, k>* owner, size_t open) : tree(owner), position(open) {}
+
+
+        /**
+         * @brief Checks whether the handle refers to a node.
+         */
+        explicit operator bool() const
+        {
+            return this->tree != nullptr;
+        }
+
+
+        /**
+         * @brief Retrieves the value of the node.
+         */
+        const T& get_value() const
+        {
+            return this->tree->value_at(this->position);
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of the node.
+         */
+        size_t child_count() const
+        {
+            return this->tree->child_count_at(this->position);
+        }
+
+
+        /**
+         * @brief Retrieves a child of the node.
+         * @param index The position of the child among its siblings.
+         * @throws std::out_of_range if the node has no such child.
+         */
+        SuccinctNode child(size_t index) const
+        {
+            return SuccinctNode(this->tree, this->tree->child_at(this->position, index));
+        }
+
+
+        /**
+         * @brief Retrieves the parent of the node (a handle to no node for the root).
+         */
+        SuccinctNode get_parent() const
+        {
+            size_t parent = this->tree->parent_at(this->position);
+            return parent == SuccinctTree<T, k>::NONE ? SuccinctNode() : SuccinctNode(this->tree, parent);
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes in the subtree of the node, itself included.
+         */
+        size_t subtree_size() const
+        {
+            return this->tree->subtree_size_at(this->position);
+        }
+
+
+        /**
+         * @brief Retrieves the depth of the node (0 for the root).
+         */
+        size_t depth() const
+        {
+            return this->tree->depth_at(this->position);
+        }
+
+
+        /**
+         * @brief Retrieves the pre-order position of the node, which is also its position in the value column.
+         */
+        size_t index() const
+        {
+            return this->tree->index_at(this->position);
+        }
+
+
+        bool operator==(const SuccinctNode& other) const
+        {
+            return this->tree == other.tree && this->position == other.position;
+        }
+
+        bool operator!=(const SuccinctNode& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+    /**
+     * @brief Traversal orders of SuccinctIterator.
+     */
+    enum class SuccinctOrder { PreOrder, PostOrder, BFS };
+
+
+/**
+ * @class SuccinctIterator
+ * @brief Pre-order, post-order or breadth-first iterator over a SuccinctTree.
+ *
+ * Pre-order visits the opening parentheses from left to right and post-order the closing ones, so
+ * both are sequential scans of the topology without a stack; breadth-first keeps a queue.
+ */
+template <typename T, int k = 2>
+class SuccinctIterator {
+
+    private:
+
+        const SuccinctTree<T, k>* tree;     // The walked tree, or nullptr for an end iterator
+        SuccinctOrder order;                // Traversal order
+        SuccinctNode<T, k> current;         // The current node
+        size_t scan = 0;                    // Pre- and post-order: the next topology position to look at
+        std::deque<size_t> queue;           // BFS: nodes still to visit
+
+        /**
+         * @brief Moves to the next node, or becomes an end iterator.
+         */
+        void advance()
+        {
+            if (this->order == SuccinctOrder::BFS)
+            {
+                if (!this->queue.empty())
+                {
+                    size_t position = this->queue.front();
+                    this->queue.pop_front();
+                    this->current = SuccinctNode<T, k>(this->tree, position);
+                    for (size_t child = this->tree->first_child_at(position); child != SuccinctTree<T, k>::NONE;
+                         child = this->tree->next_sibling_at(child))
+                    {
+                        this->queue.push_back(child);
+                    }
+                    return;
+                }
+            }
+            else
+            {
+                bool open = this->order == SuccinctOrder::PreOrder;
+                size_t found = this->tree->next_bit(this->scan, open);
+                if (found != SuccinctTree<T, k>::NONE)
+                {
+                    this->scan = found + 1;
+                    this->current = SuccinctNode<T, k>(this->tree, open ? found : this->tree->open_of(found));
+                    return;
+                }
+            }
+            this->tree = nullptr;
+            this->current = SuccinctNode<T, k>();
+        }
+
+    public:
+
+        /**
+         * @brief Constructs an iterator at the first node of a tree, or an end iterator when `owner` is nullptr or empty.
+         * @param owner The tree to walk.
+         * @param walk The traversal order.
+         */
+        SuccinctIterator(const SuccinctTree<T, k>* owner, SuccinctOrder walk) : tree(owner), order(walk)
+        {
+            if (this->tree && this->tree->size() > 0 && this->order == SuccinctOrder::BFS) this->queue.push_back(0);
+            if (this->tree) this->advance();
+        }
+
+
+        const SuccinctNode<T, k>& operator*() const
+        {
+            return this->current;
+        }
+
+
+        const SuccinctNode<T, k>* operator->() const
+        {
+            return &this->current;
+        }
+
+
+        SuccinctIterator& operator++()
+        {
+            this->advance();
+            return *this;
+        }
+
+
+        bool operator==(const SuccinctIterator& other) const
+        {
+            return this->tree == other.tree && this->current == other.current;
+        }
+
+
+        bool operator!=(const SuccinctIterator& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+
+/**
+ * @class SuccinctTree
+ * @brief Read-only tree whose shape is stored as balanced parentheses, about 2 bits per node, with the values in a separate column.
+ *
+ * A pre-order walk of the source tree writes "(" (a set bit) when it enters a node and ")" when it
+ * leaves it, and appends the node's value to the value column. A node is identified by the position
+ * of its "(", so its pre-order position is a rank and the node at a pre-order position is a select.
+ * The depth after a position is its excess, the number of "(" minus the number of ")" up to it;
+ * matching parentheses and the enclosing node are found by searching for the next or previous
+ * position with a given excess. The searches scan the current 512-bit block a byte at a time with
+ * lookup tables and otherwise use a range-minimum tree over the blocks (the minimum excess of every
+ * block), so they take O(log(n / 512)) tree steps in the worst case and a block scan in the usual
+ * case where the answer is near.
+ *
+ * With the rank, select and block counts the shape takes about 3.1 bits per node. Handles and
+ * iterators replace Node pointers; no per-node object exists.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam k Maximum number of children each node can have.
+ */
+template <typename T, int k = 2>
+class SuccinctTree {
+
+    private:
+
+        static constexpr size_t BLOCK = 512;    // Bits per range-minimum block, aligned with the rank superblocks
+
+        /**
+         * @brief Excess change and lowest and highest running excess of every byte, bits read from least significant.
+         */
+        struct ByteExcess
+        {
+            std::array<int8_t, 256> total;
+            std::array<int8_t, 256> low;
+            std::array<int8_t, 256> high;
+
+            ByteExcess()
+            {
+                for (int b = 0; b < 256; ++b)
+                {
+                    int excess = 0, lowest = 8, highest = -8;
+                    for (int bit = 0; bit < 8; ++bit)
+                    {
+                        excess += (b >> bit) & 1 ? 1 : -1;
+                        lowest = std::min(lowest, excess);
+                        highest = std::max(highest, excess);
+                    }
+                    this->total[static_cast<size_t>(b)] = static_cast<int8_t>(excess);
+                    this->low[static_cast<size_t>(b)] = static_cast<int8_t>(lowest);
+                    this->high[static_cast<size_t>(b)] = static_cast<int8_t>(highest);
+                }
+            }
+        };
+
+        RankSelectBits bits;                // The parentheses, "(" as a set bit
+        std::vector<T> values;              // Values in pre-order
+        std::vector<uint32_t> blockMin;     // Range-minimum tree of the block excess minima; leaf i is blockMin[leaves + i]
+        size_t leaves = 1;                  // Number of leaves of the range-minimum tree (a power of two)
+
+
+        static const ByteExcess& byteExcess()
+        {
+            static const ByteExcess table;
+            return table;
+        }
+
+
+        /**
+         * @brief Retrieves the excess after a position (the depth of the node a "(" there opens).
+         */
+        int64_t excess(size_t position) const
+        {
+            return 2 * static_cast<int64_t>(this->bits.rank1(position + 1)) - static_cast<int64_t>(position + 1);
+        }
+
+
+        /**
+         * @brief Retrieves the excess before the first position of a block.
+         */
+        int64_t blockStartExcess(size_t block) const
+        {
+            return 2 * static_cast<int64_t>(this->bits.superblock_rank(block)) - static_cast<int64_t>(block * BLOCK);
+        }
+
+
+        /**
+         * @brief Finds the first position in [from, to) whose excess equals a target, skipping whole bytes that cannot reach it.
+         * @param running The excess before `from`.
+         * @return The match, or NONE.
+         */
+        size_t scanForward(size_t from, size_t to, int64_t running, int64_t target) const
+        {
+            const ByteExcess& table = byteExcess();
+            for (size_t j = from; j < to; )
+            {
+                if (j % 8 == 0 && j + 8 <= to)
+                {
+                    size_t byte = static_cast<size_t>((this->bits.word(j / 64) >> (j % 64)) & 0xFF);
+                    if (running + table.low[byte] > target || running + table.high[byte] < target)
+                    {
+                        running += table.total[byte];
+                        j += 8;
+                        continue;
+                    }
+                }
+                running += this->bits.get(j) ? 1 : -1;
+                if (running == target) return j;
+                ++j;
+            }
+            return NONE;
+        }
+
+
+        /**
+         * @brief Finds the last position in [from, to) whose excess equals a target, walking backwards.
+         * @param running The excess at `to - 1`.
+         * @return The match, or NONE.
+         */
+        size_t scanBackward(size_t from, size_t to, int64_t running, int64_t target) const
+        {
+            const ByteExcess& table = byteExcess();
+            for (size_t j = to; j > from; )
+            {
+                // `running` is the excess at j - 1
+                if (j % 8 == 0 && j - 8 >= from)
+                {
+                    size_t byte = static_cast<size_t>((this->bits.word((j - 8) / 64) >> ((j - 8) % 64)) & 0xFF);
+                    int64_t before = running - table.total[byte];
+                    if (before + table.low[byte] > target || before + table.high[byte] < target)
+                    {
+                        running = before;
+                        j -= 8;
+                        continue;
+                    }
+                }
+                if (running == target) return j - 1;
+                running -= this->bits.get(j - 1) ? 1 : -1;
+                --j;
+            }
+            return NONE;
+        }
+
+
+        /**
+         * @brief Finds the first position after `position` whose excess equals a target lower than the excess at `position`.
+         */
+        size_t forwardSearch(size_t position, int64_t target) const
+        {
+            size_t block = position / BLOCK;
+            size_t found = this->scanForward(position + 1, std::min((block + 1) * BLOCK, this->bits.size()), this->excess(position), target);
+            if (found != NONE) return found;
+
+            // Climb until a right sibling subtree reaches the target, then descend to its leftmost such block
+            size_t node = this->leaves + block;
+            for (;;)
+            {
+                if (node == 1) return NONE;
+                if (node % 2 == 0 && this->blockMin[node + 1] <= target) break;
+                node /= 2;
+            }
+            node += 1;
+            while (node < this->leaves)
+            {
+                node *= 2;
+                if (this->blockMin[node] > target) ++node;
+            }
+            block = node - this->leaves;
+            return this->scanForward(block * BLOCK, std::min((block + 1) * BLOCK, this->bits.size()), this->blockStartExcess(block), target);
+        }
+
+
+        /**
+         * @brief Finds the last position before `position` whose excess equals a target lower than the excess just before `position`.
+         */
+        size_t backwardSearch(size_t position, int64_t target) const
+        {
+            if (position == 0) return NONE;
+            size_t block = position / BLOCK;
+            size_t found = this->scanBackward(block * BLOCK, position, this->excess(position - 1), target);
+            if (found != NONE) return found;
+
+            size_t node = this->leaves + block;
+            for (;;)
+            {
+                if (node == 1) return NONE;
+                if (node % 2 == 1 && this->blockMin[node - 1] <= target) break;
+                node /= 2;
+            }
+            node -= 1;
+            while (node < this->leaves)
+            {
+                node = 2 * node + 1;
+                if (this->blockMin[node] > target) --node;
+            }
+            block = node - this->leaves;
+            return this->scanBackward(block * BLOCK, (block + 1) * BLOCK, this->blockStartExcess(block + 1), target);      // A block before another one is full
+        }
+
+    public:
+
+        static constexpr size_t NONE = static_cast<size_t>(-1);    // "No node" / "not found" position
+
+
+        /**
+         * @brief Builds the succinct form of a tree in O(n).
+         * The source tree is walked once; it is not modified and may be destroyed afterwards.
+         * @param tree The tree to encode.
+         */
+        explicit SuccinctTree(const Tree<T, k>& tree)
+        {
+            if (tree.root)
+            {
+                // Each frame is a node and the position of its next child to enter
+                std::vector<std::pair<const Node<T>*, size_t>> frames{{tree.root, 0}};
+                this->bits.push_back(true);
+                this->values.push_back(tree.root->get_value());
+                while (!frames.empty())
+                {
+                    auto& [node, next] = frames.back();
+                    if (next < node->get_children().size())
+                    {
+                        const Node<T>* child = node->get_children()[next++];
+                        this->bits.push_back(true);
+                        this->values.push_back(child->get_value());
+                        frames.push_back({child, 0});
+                        continue;
+                    }
+                    this->bits.push_back(false);
+                    frames.pop_back();
+                }
+            }
+            this->bits.build();
+
+            // Leaves hold the lowest excess inside every block; padding leaves never match
+            size_t blocks = (this->bits.size() + BLOCK - 1) / BLOCK;
+            while (this->leaves < blocks) this->leaves *= 2;
+            this->blockMin.assign(2 * this->leaves, UINT32_MAX);
+            int64_t running = 0;
+            for (size_t position = 0; position < this->bits.size(); ++position)
+            {
+                running += this->bits.get(position) ? 1 : -1;
+                uint32_t& low = this->blockMin[this->leaves + position / BLOCK];
+                low = std::min(low, static_cast<uint32_t>(running));
+            }
+            for (size_t node = this->leaves - 1; node > 0; --node)
+            {
+                this->blockMin[node] = std::min(this->blockMin[2 * node], this->blockMin[2 * node + 1]);
+            }
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes.
+         */
+        size_t size() const
+        {
+            return this->values.size();
+        }
+
+
+        /**
+         * @brief Retrieves the root.
+         * @throws std::logic_error if the tree is empty.
+         */
+        SuccinctNode<T, k> get_root() const
+        {
+            if (this->values.empty()) throw std::logic_error("SuccinctTree: the tree is empty.");
+            return SuccinctNode<T, k>(this, 0);
+        }
+
+
+        /**
+         * @brief Retrieves the node at a pre-order position, with one select.
+         * @throws std::out_of_range if the position is not less than size().
+         */
+        SuccinctNode<T, k> node_at(size_t index) const
+        {
+            if (index >= this->values.size()) throw std::out_of_range("SuccinctTree: pre-order position outside the tree.");
+            return SuccinctNode<T, k>(this, this->bits.select1(index));
+        }
+
+
+        /**
+         * @brief Retrieves the pre-order position of the node opened at a topology position, with one rank.
+         */
+        size_t index_at(size_t position) const
+        {
+            return this->bits.rank1(position);
+        }
+
+
+        /**
+         * @brief Retrieves the value of the node opened at a topology position.
+         */
+        const T& value_at(size_t position) const
+        {
+            return this->values[this->bits.rank1(position)];
+        }
+
+
+        /**
+         * @brief Retrieves the depth of the node opened at a topology position (0 for the root), with one rank.
+         */
+        size_t depth_at(size_t position) const
+        {
+            return static_cast<size_t>(this->excess(position) - 1);
+        }
+
+
+        /**
+         * @brief Finds the ")" matching the "(" at a topology position.
+         */
+        size_t close_of(size_t position) const
+        {
+            return this->forwardSearch(position, this->excess(position) - 1);
+        }
+
+
+        /**
+         * @brief Finds the "(" matching the ")" at a topology position.
+         */
+        size_t open_of(size_t position) const
+        {
+            size_t before = this->backwardSearch(position, this->excess(position));
+            return before == NONE ? 0 : before + 1;     // Only the root's "(" has no position before it
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes in the subtree of the node opened at a topology position.
+         */
+        size_t subtree_size_at(size_t position) const
+        {
+            return (this->close_of(position) - position + 1) / 2;
+        }
+
+
+        /**
+         * @brief Retrieves the first child of the node opened at a topology position, or NONE for a leaf.
+         */
+        size_t first_child_at(size_t position) const
+        {
+            return this->bits.get(position + 1) ? position + 1 : NONE;
+        }
+
+
+        /**
+         * @brief Retrieves the next sibling of the node opened at a topology position, or NONE for a last child.
+         */
+        size_t next_sibling_at(size_t position) const
+        {
+            size_t after = this->close_of(position) + 1;
+            return after < this->bits.size() && this->bits.get(after) ? after : NONE;
+        }
+
+
+        /**
+         * @brief Retrieves the number of children of the node opened at a topology position (at most k sibling steps).
+         */
+        size_t child_count_at(size_t position) const
+        {
+            size_t count = 0;
+            for (size_t child = this->first_child_at(position); child != NONE; child = this->next_sibling_at(child)) ++count;
+            return count;
+        }
+
+
+        /**
+         * @brief Retrieves a child of the node opened at a topology position (at most k sibling steps).
+         * @throws std::out_of_range if the node has no such child.
+         */
+        size_t child_at(size_t position, size_t index) const
+        {
+            size_t child = this->first_child_at(position);
+            for (; child != NONE && index > 0; --index) child = this->next_sibling_at(child);
+            if (child == NONE) throw std::out_of_range("SuccinctTree: child index out of range.");
+            return child;
+        }
+
+
+        /**
+         * @brief Retrieves the parent of the node opened at a topology position, or NONE for the root.
+         */
+        size_t parent_at(size_t position) const
+        {
+            int64_t depth = this->excess(position);
+            if (depth == 1) return NONE;
+            size_t before = this->backwardSearch(position, depth - 2);
+            return before == NONE ? 0 : before + 1;
+        }
+
+
+        /**
+         * @brief Finds the first "(" (or ")") at or after a topology position, a word at a time.
+         * @return Its position, or NONE.
+         */
+        size_t next_bit(size_t position, bool open) const
+        {
+            if (position >= this->bits.size()) return NONE;
+            size_t w = position / 64;
+            uint64_t word = (open ? this->bits.word(w) : ~this->bits.word(w)) & (~uint64_t(0) << (position % 64));
+            while (word == 0)
+            {
+                if (++w * 64 >= this->bits.size()) return NONE;
+                word = open ? this->bits.word(w) : ~this->bits.word(w);
+            }
+            size_t found = w * 64 + static_cast<size_t>(__builtin_ctzll(word));
+            return found < this->bits.size() ? found : NONE;
+        }
+
+
+        /**
+         * @brief Retrieves the memory used by the shape (parentheses, rank and select counts, range-minimum tree), in bytes.
+         */
+        size_t topology_bytes() const
+        {
+            return this->bits.memory_bytes() + this->blockMin.size() * sizeof(uint32_t);
+        }
+
+
+        // Iterator access functions, with the same names as in Tree
+        SuccinctIterator<T, k> begin_pre_order() const { return SuccinctIterator<T, k>(this, SuccinctOrder::PreOrder); }
+        SuccinctIterator<T, k> end_pre_order() const { return SuccinctIterator<T, k>(nullptr, SuccinctOrder::PreOrder); }
+
+        SuccinctIterator<T, k> begin_post_order() const { return SuccinctIterator<T, k>(this, SuccinctOrder::PostOrder); }
+        SuccinctIterator<T, k> end_post_order() const { return SuccinctIterator<T, k>(nullptr, SuccinctOrder::PostOrder); }
+
+        SuccinctIterator<T, k> begin_bfs_scan() const { return SuccinctIterator<T, k>(this, SuccinctOrder::BFS); }
+        SuccinctIterator<T, k> end_bfs_scan() const { return SuccinctIterator<T, k>(nullptr, SuccinctOrder::BFS); }
+
+        SuccinctIterator<T, k> begin() const { return begin_bfs_scan(); }
+        SuccinctIterator<T, k> end() const { return end_bfs_scan(); }
+
+        SuccinctIterator<T, k> begin_dfs_scan() const { return begin_pre_order(); }
+        SuccinctIterator<T, k> end_dfs_scan() const { return end_pre_order(); }
+    };
+}
+
+#endif
@@ -4,8 +4,24 @@
 #include "tree.hpp"
 #include "node.hpp"
 #include "complex.hpp"
+#include "tree_index.hpp"
+#include "lca.hpp"
+#include "subtree_aggregate.hpp"
+#include "heavy_light.hpp"
+#include "diff.hpp"
+#include "compact_tree.hpp"
+#include "serialization.hpp"
+#include "frozen_tree.hpp"
+#include "persistent_tree.hpp"
+#include "paged_tree.hpp"
+#include "lazy_tree.hpp"
+#include "text_parser.hpp"
+#include "succinct_tree.hpp"
+#include "tree_journal.hpp"
 #include <sstream>
 #include <stdexcept>
+#include <csignal>
+#include <sys/resource.h>
 #include <memory>
 #include <vector>
 
@@ -708,4 +724,2270 @@ TEST_CASE("Edge Case: Only Right Children") {
         ss << node->get_value() << " ";
     }
     CHECK(ss.str() == "1 2 3 4 ");
-}
\ No newline at end of file
+}
+
+
+//--------------------------//
+//     TreeIndex tests      //
+//--------------------------//
+
+TEST_CASE("TreeIndex ancestor tests and subtree ranges") {
+    Tree<int, 3> tree;
+    Node<int>* n1 = new Node<int>(1);
+    Node<int>* n2 = new Node<int>(2);
+    Node<int>* n3 = new Node<int>(3);
+    Node<int>* n4 = new Node<int>(4);
+    Node<int>* n5 = new Node<int>(5);
+    Node<int>* n6 = new Node<int>(6);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n2, n5);
+    tree.add_sub_node(n3, n6);
+
+    TreeIndex<int> index(tree);
+    CHECK(index.size() == 6);
+    CHECK(index.is_ancestor(n1, n6));
+    CHECK(index.is_ancestor(n2, n5));
+    CHECK(index.is_ancestor(n4, n4));
+    CHECK_FALSE(index.is_ancestor(n2, n6));
+    CHECK_FALSE(index.is_ancestor(n5, n2));
+
+    // The subtree of n2 is a contiguous slice of the tour: 2 4 5
+    CHECK(index.subtree_size(n2) == 3);
+    CHECK(index.subtree_range(n2) == std::make_pair<size_t, size_t>(1, 4));
+    stringstream ss;
+    for (auto it = index.subtree_begin(n2); it != index.subtree_end(n2); ++it) 
+    {
+        ss << (*it)->get_value() << " ";
+    }
+    CHECK(ss.str() == "2 4 5 ");
+
+    Node<int> outsider(7);
+    CHECK_FALSE(index.contains(&outsider));
+    CHECK_THROWS_AS(index.entry(&outsider), std::invalid_argument);
+}
+
+TEST_CASE("TreeIndex detects stale snapshots") {
+    Tree<int> tree;
+    Node<int>* n1 = new Node<int>(1);
+    Node<int>* n2 = new Node<int>(2);
+    tree.add_root(n1);
+
+    TreeIndex<int> index(tree);
+    CHECK_FALSE(index.is_stale(tree));
+
+    tree.add_sub_node(n1, n2);
+    CHECK(index.is_stale(tree));
+
+    // A rejected insertion (the node is full) does not change the version
+    Tree<int, 1> unary;
+    Node<int>* u1 = new Node<int>(1);
+    Node<int>* u2 = new Node<int>(2);
+    Node<int>* u3 = new Node<int>(3);
+    unary.add_root(u1);
+    unary.add_sub_node(u1, u2);
+    TreeIndex<int> unaryIndex(unary);
+    unary.add_sub_node(u1, u3);
+    CHECK_FALSE(unaryIndex.is_stale(unary));
+    CHECK(index.is_stale(unary));
+    delete u3;
+}
+
+
+//--------------------------//
+//        LCA tests         //
+//--------------------------//
+
+TEST_CASE("LCA engines agree on every pair of nodes") {
+    Tree<int, 3> tree;
+    vector<Node<int>*> nodes;
+    for (int i = 0; i < 13; ++i) 
+    {
+        nodes.push_back(new Node<int>(i));
+    }
+
+    //            0
+    //       1    2     3
+    //     4 5    6   7 8 9
+    //    10     11      12
+    tree.add_root(nodes[0]);
+    tree.add_sub_node(nodes[0], nodes[1]);
+    tree.add_sub_node(nodes[0], nodes[2]);
+    tree.add_sub_node(nodes[0], nodes[3]);
+    tree.add_sub_node(nodes[1], nodes[4]);
+    tree.add_sub_node(nodes[1], nodes[5]);
+    tree.add_sub_node(nodes[2], nodes[6]);
+    tree.add_sub_node(nodes[3], nodes[7]);
+    tree.add_sub_node(nodes[3], nodes[8]);
+    tree.add_sub_node(nodes[3], nodes[9]);
+    tree.add_sub_node(nodes[4], nodes[10]);
+    tree.add_sub_node(nodes[6], nodes[11]);
+    tree.add_sub_node(nodes[9], nodes[12]);
+
+    TreeIndex<int> index(tree);
+    BinaryLiftingLCA<int> lifting(index);
+    SparseTableLCA<int> sparse(index);
+
+    CHECK(lifting.query(nodes[10], nodes[5])->get_value() == 1);
+    CHECK(sparse.query(nodes[10], nodes[5])->get_value() == 1);
+    CHECK(lifting.query(nodes[11], nodes[12])->get_value() == 0);
+    CHECK(sparse.query(nodes[12], nodes[7])->get_value() == 3);
+    CHECK(sparse.query(nodes[4], nodes[10])->get_value() == 4);
+    CHECK(lifting.query(nodes[8], nodes[8])->get_value() == 8);
+
+    // Compare the three engines on all pairs
+    vector<std::pair<const Node<int>*, const Node<int>*>> queries;
+    for (auto a : nodes) 
+    {
+        for (auto b : nodes) 
+        {
+            queries.push_back({a, b});
+        }
+    }
+    vector<Node<int>*> offline = tarjan_lca(index, queries);
+    bool agree = true;
+    for (size_t q = 0; q < queries.size(); ++q) 
+    {
+        Node<int>* expected = lifting.query(queries[q].first, queries[q].second);
+        agree = agree && expected == sparse.query(queries[q].first, queries[q].second) && expected == offline[q];
+    }
+    CHECK(agree);
+}
+
+TEST_CASE("LCA on a path-shaped tree") {
+    Tree<int, 1> path;
+    vector<Node<int>*> nodes;
+    for (int i = 0; i < 100; ++i) 
+    {
+        nodes.push_back(new Node<int>(i));
+        if (i == 0) path.add_root(nodes[0]);
+        else path.add_sub_node(nodes[static_cast<size_t>(i) - 1], nodes.back());
+    }
+
+    TreeIndex<int> index(path);
+    BinaryLiftingLCA<int> lifting(index);
+    SparseTableLCA<int> sparse(index);
+    CHECK(lifting.query(nodes[99], nodes[37])->get_value() == 37);
+    CHECK(sparse.query(nodes[3], nodes[98])->get_value() == 3);
+    CHECK(tarjan_lca(index, {{nodes[64], nodes[65]}})[0]->get_value() == 64);
+}
+
+
+//--------------------------//
+//  Subtree aggregate tests //
+//--------------------------//
+
+TEST_CASE("Subtree sum, min and max with point updates") {
+    Tree<int, 3> tree;
+    Node<int>* n1 = new Node<int>(5);
+    Node<int>* n2 = new Node<int>(3);
+    Node<int>* n3 = new Node<int>(8);
+    Node<int>* n4 = new Node<int>(1);
+    Node<int>* n5 = new Node<int>(4);
+    Node<int>* n6 = new Node<int>(9);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n2, n5);
+    tree.add_sub_node(n3, n6);
+
+    TreeIndex<int> index(tree);
+    SubtreeAggregate<int> sums(index);
+    SubtreeAggregate<int, MinCombine<int>> mins(index);
+    SubtreeAggregate<int, MaxCombine<int>> maxs(index);
+
+    CHECK(sums.query(n1) == 30);
+    CHECK(sums.query(n2) == 8);
+    CHECK(mins.query(n3) == 8);
+    CHECK(maxs.query(n2) == 4);
+
+    sums.add(n4, 10);
+    CHECK(sums.value(n4) == 11);
+    CHECK(sums.query(n2) == 18);
+    CHECK(sums.query(n3) == 17);
+    CHECK(sums.query(n1) == 40);
+
+    mins.set(n6, -2);
+    CHECK(mins.query(n1) == -2);
+    CHECK(mins.query(n2) == 1);
+}
+
+TEST_CASE("Subtree aggregates over Complex values") {
+    Tree<Complex> tree;
+    Node<Complex>* n1 = new Node<Complex>(Complex(1.0, 1.0));
+    Node<Complex>* n2 = new Node<Complex>(Complex(2.0, -1.0));
+    Node<Complex>* n3 = new Node<Complex>(Complex(0.5, 3.0));
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+
+    TreeIndex<Complex> index(tree);
+    SubtreeAggregate<Complex> sums(index);
+    CHECK(sums.query(n1) == Complex(3.5, 3.0));
+
+    // User-supplied combine: keep the value with the largest magnitude
+    auto largest = [](const Complex& a, const Complex& b) { return a > b ? a : b; };
+    SubtreeAggregate<Complex, decltype(largest)> magnitudes(index, largest);
+    CHECK(magnitudes.query(n1) == Complex(0.5, 3.0));
+    magnitudes.set(n2, Complex(-4.0, 0.0));
+    CHECK(magnitudes.query(n1) == Complex(-4.0, 0.0));
+    CHECK(magnitudes.query(n3) == Complex(0.5, 3.0));
+}
+
+
+//--------------------------//
+//   Heavy-light tests      //
+//--------------------------//
+
+TEST_CASE("Heavy-light path sums and maxima with point updates") {
+    Tree<int, 3> tree;
+    vector<Node<int>*> nodes;
+    for (int i = 0; i < 10; ++i) 
+    {
+        nodes.push_back(new Node<int>(i + 1));
+    }
+
+    //          1
+    //       2     3
+    //     4 5 6    7
+    //    8        9 10
+    tree.add_root(nodes[0]);
+    tree.add_sub_node(nodes[0], nodes[1]);
+    tree.add_sub_node(nodes[0], nodes[2]);
+    tree.add_sub_node(nodes[1], nodes[3]);
+    tree.add_sub_node(nodes[1], nodes[4]);
+    tree.add_sub_node(nodes[1], nodes[5]);
+    tree.add_sub_node(nodes[2], nodes[6]);
+    tree.add_sub_node(nodes[3], nodes[7]);
+    tree.add_sub_node(nodes[6], nodes[8]);
+    tree.add_sub_node(nodes[6], nodes[9]);
+
+    TreeIndex<int> index(tree);
+    HeavyLightDecomposition<int> sums(index);
+    HeavyLightDecomposition<int, MaxCombine<int>> maxima(index);
+
+    CHECK(sums.query_from_root(nodes[7]) == 1 + 2 + 4 + 8);
+    CHECK(sums.query(nodes[7], nodes[9]) == 8 + 4 + 2 + 1 + 3 + 7 + 10);
+    CHECK(sums.query(nodes[4], nodes[5]) == 5 + 2 + 6);
+    CHECK(sums.query(nodes[8], nodes[8]) == 9);
+    CHECK(maxima.query(nodes[7], nodes[4]) == 8);
+    CHECK(maxima.query(nodes[1], nodes[2]) == 3);
+
+    sums.add(nodes[1], 100);
+    CHECK(sums.value(nodes[1]) == 102);
+    CHECK(sums.query(nodes[4], nodes[5]) == 5 + 102 + 6);
+    CHECK(sums.query(nodes[8], nodes[9]) == 9 + 7 + 10);
+
+    maxima.set(nodes[0], 50);
+    CHECK(maxima.query(nodes[7], nodes[9]) == 50);
+    CHECK(maxima.query(nodes[3], nodes[7]) == 8);
+}
+
+
+//--------------------------//
+//    Value index tests     //
+//--------------------------//
+
+TEST_CASE("Value index finds nodes and duplicates") {
+    Tree<int, 3> tree;
+    Node<int>* n1 = new Node<int>(10);
+    Node<int>* n2 = new Node<int>(20);
+    Node<int>* n3 = new Node<int>(30);
+    Node<int>* n4 = new Node<int>(20);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+
+    // Enabling indexes the existing nodes, later insertions are indexed as they come
+    tree.enable_value_index();
+    CHECK(tree.has_value_index());
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n2, n4);
+
+    CHECK(tree.find(10) == n1);
+    CHECK(tree.find(30) == n3);
+    CHECK(tree.find(99) == nullptr);
+    vector<Node<int>*> twenties = tree.find_all(20);
+    CHECK(twenties.size() == 2);
+    CHECK(std::find(twenties.begin(), twenties.end(), n4) != twenties.end());
+
+    // A subtree attached in one call is indexed as a whole
+    Node<int>* n5 = new Node<int>(50);
+    Node<int>* n6 = new Node<int>(60);
+    n5->add_child(n6);
+    tree.add_sub_node(n3, n5);
+    CHECK(tree.find(60) == n6);
+
+    // Without the index the same answers come from a BFS scan
+    tree.disable_value_index();
+    CHECK(tree.find(60) == n6);
+    CHECK(tree.find_all(20).size() == 2);
+}
+
+TEST_CASE("Value index with many keys and Complex values") {
+    Tree<int, 2> tree;
+    vector<Node<int>*> nodes;
+    tree.enable_value_index();
+    for (int i = 0; i < 1000; ++i) 
+    {
+        nodes.push_back(new Node<int>(i % 500));
+        if (i == 0) tree.add_root(nodes[0]);
+        else tree.add_sub_node(nodes[static_cast<size_t>(i - 1) / 2], nodes.back());
+    }
+    bool allFound = true;
+    for (int v = 0; v < 500; ++v) 
+    {
+        allFound = allFound && tree.find_all(v).size() == 2;
+    }
+    CHECK(allFound);
+
+    ValueIndex<int> index;
+    index.insert(nodes[3]);
+    index.insert(nodes[503]);
+    CHECK(index.erase(nodes[3]));
+    CHECK_FALSE(index.erase(nodes[3]));
+    CHECK(index.find(3) == nodes[503]);
+    CHECK(index.size() == 1);
+
+    Tree<Complex> complexTree;
+    Node<Complex>* c1 = new Node<Complex>(Complex(1.0, 2.0));
+    Node<Complex>* c2 = new Node<Complex>(Complex(-0.0, 3.0));
+    complexTree.add_root(c1);
+    complexTree.add_sub_node(c1, c2);
+    complexTree.enable_value_index();
+    CHECK(complexTree.find(Complex(0.0, 3.0)) == c2);
+    CHECK(std::hash<Complex>()(Complex(0.0, 1.0)) == std::hash<Complex>()(Complex(-0.0, 1.0)));
+}
+
+
+//--------------------------//
+//    Sorted index tests    //
+//--------------------------//
+
+TEST_CASE("Sorted index answers range scans in value order") {
+    Tree<double, 5> tree;
+    Node<double>* n1 = new Node<double>(5.5);
+    Node<double>* n2 = new Node<double>(1.1);
+    Node<double>* n3 = new Node<double>(9.9);
+    Node<double>* n4 = new Node<double>(3.3);
+    Node<double>* n5 = new Node<double>(7.7);
+    Node<double>* n6 = new Node<double>(3.3);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.enable_sorted_index();
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n3, n5);
+
+    stringstream ss;
+    for (Node<double>* node : tree.find_range(2.0, 8.0)) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "3.3 5.5 7.7 ");
+
+    // Insertions after a query are merged before the next one
+    tree.add_sub_node(n2, n6);
+    CHECK(tree.find_range(3.3, 3.3).size() == 2);
+    CHECK(tree.find_range(10.0, 20.0).empty());
+    CHECK(tree.find_range(0.0, 100.0).size() == 6);
+
+    // Same answers from the unindexed scan
+    tree.disable_sorted_index();
+    ss.str("");
+    for (Node<double>* node : tree.find_range(2.0, 8.0)) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "3.3 3.3 5.5 7.7 ");
+
+    // Replacing the root resets the index
+    Tree<string, 2> words;
+    words.enable_sorted_index();
+    Node<string>* w1 = new Node<string>("kiwi");
+    Node<string>* w2 = new Node<string>("apple");
+    Node<string>* w3 = new Node<string>("mango");
+    words.add_root(w1);
+    words.add_sub_node(w1, w2);
+    words.add_sub_node(w1, w3);
+    vector<Node<string>*> fruits = words.find_range("b", "m");
+    CHECK(fruits.size() == 1);
+    CHECK(fruits[0] == w1);
+}
+
+
+//--------------------------//
+//     Zone map tests       //
+//--------------------------//
+
+TEST_CASE("Zone maps track subtree ranges on insertion") {
+    Tree<double, 5> tree;
+    Node<double>* n1 = new Node<double>(50.0);
+    Node<double>* n2 = new Node<double>(10.0);
+    Node<double>* n3 = new Node<double>(80.0);
+    Node<double>* n4 = new Node<double>(12.0);
+    Node<double>* n5 = new Node<double>(5.0);
+    Node<double>* n6 = new Node<double>(95.0);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.enable_zone_maps();
+    CHECK(tree.has_zone_maps());
+    CHECK(tree.subtree_range(n1) == std::make_pair(10.0, 80.0));
+
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n4, n5);
+    tree.add_sub_node(n3, n6);
+    CHECK(tree.get_parent(n4) == n2);
+    CHECK(tree.subtree_range(n2) == std::make_pair(5.0, 12.0));
+    CHECK(tree.subtree_range(n3).second == 95.0);
+    CHECK(tree.subtree_range(n1) == std::make_pair(5.0, 95.0));
+
+    // A null child is ignored
+    tree.add_sub_node(n6, nullptr);
+    CHECK(n6->get_children().empty());
+
+    tree.disable_zone_maps();
+    CHECK_FALSE(tree.has_parent_links());
+    CHECK_THROWS_AS(tree.subtree_range(n1), std::logic_error);
+    CHECK_THROWS_AS(tree.get_parent(n4), std::logic_error);
+}
+
+TEST_CASE("Pruned searches return the same nodes as full scans") {
+    Tree<double, 5> tree;
+    vector<Node<double>*> nodes;
+    for (int i = 0; i < 200; ++i) 
+    {
+        nodes.push_back(new Node<double>((i * 37) % 200 + 0.5));
+        if (i == 0) tree.add_root(nodes[0]);
+        else tree.add_sub_node(nodes[static_cast<size_t>(i - 1) / 5], nodes.back());
+    }
+
+    vector<Node<double>*> fullGreater = tree.find_greater(150.0);
+    vector<Node<double>*> fullLess = tree.find_less(20.0);
+    vector<Node<double>*> fullRange = tree.find_range(40.0, 60.0);
+    tree.enable_zone_maps();
+    CHECK(tree.find_greater(150.0) == fullGreater);
+    CHECK(tree.find_less(20.0) == fullLess);
+    CHECK(tree.find_range(40.0, 60.0) == fullRange);
+    CHECK(fullGreater.size() == 50);
+    CHECK(fullRange.size() == 20);
+
+    auto evens = tree.find_all_if([](double v) { return static_cast<int>(v) % 2 == 0; });
+    CHECK(evens.size() == 100);
+}
+
+
+//--------------------------//
+//   Bloom filter tests     //
+//--------------------------//
+
+TEST_CASE("Bloom filters prune containment queries on string trees") {
+    Tree<string, 3> tree;
+    Node<string>* root = new Node<string>("root");
+    Node<string>* left = new Node<string>("left");
+    Node<string>* right = new Node<string>("right");
+    Node<string>* leaf1 = new Node<string>("apple");
+    Node<string>* leaf2 = new Node<string>("banana");
+    Node<string>* leaf3 = new Node<string>("cherry");
+
+    tree.add_root(root);
+    tree.add_sub_node(root, left);
+    tree.add_sub_node(root, right);
+    tree.enable_bloom_filters(512, 4);
+    CHECK(tree.has_bloom_filters());
+    tree.add_sub_node(left, leaf1);
+    tree.add_sub_node(left, leaf2);
+    tree.add_sub_node(right, leaf3);
+
+    // No false negatives, and the filters grew with the insertions
+    CHECK(tree.subtree_may_contain(root, "banana"));
+    CHECK(tree.subtree_may_contain(left, "apple"));
+    CHECK(tree.subtree_may_contain(right, "cherry"));
+    CHECK(tree.subtree_contains(left, "banana"));
+    CHECK_FALSE(tree.subtree_contains(right, "banana"));
+    CHECK_FALSE(tree.subtree_contains(root, "durian"));
+    CHECK(tree.find("cherry") == leaf3);
+
+    // A subtree attached in one call is merged into all ancestors
+    Node<string>* branch = new Node<string>("branch");
+    Node<string>* fig = new Node<string>("fig");
+    branch->add_child(fig);
+    tree.add_sub_node(leaf3, branch);
+    CHECK(tree.subtree_may_contain(right, "fig"));
+    CHECK(tree.subtree_may_contain(root, "fig"));
+    CHECK(tree.find_all("fig").size() == 1);
+
+    CHECK_THROWS_AS(tree.enable_bloom_filters(0, 3), std::invalid_argument);
+    tree.disable_bloom_filters();
+    CHECK_FALSE(tree.has_bloom_filters());
+    CHECK_FALSE(tree.has_parent_links());
+    CHECK(tree.subtree_may_contain(right, "durian"));
+}
+
+
+//--------------------------//
+//   Pruned traversal tests //
+//--------------------------//
+
+TEST_CASE("skip_children prunes subtrees in pre-order, DFS and BFS") {
+    Tree<int> tree;
+    Node<int>* n1 = new Node<int>(1);
+    Node<int>* n2 = new Node<int>(2);
+    Node<int>* n3 = new Node<int>(3);
+    Node<int>* n4 = new Node<int>(4);
+    Node<int>* n5 = new Node<int>(5);
+    Node<int>* n6 = new Node<int>(6);
+    Node<int>* n7 = new Node<int>(7);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n2, n5);
+    tree.add_sub_node(n3, n6);
+    tree.add_sub_node(n4, n7);
+
+    // Skip everything below node 2
+    stringstream ss;
+    for (auto node = tree.begin_pre_order(); node != tree.end_pre_order(); ++node) 
+    {
+        ss << node->get_value() << " ";
+        if (node->get_value() == 2) node.skip_children();
+    }
+    CHECK(ss.str() == "1 2 3 6 ");
+
+    ss.str("");
+    for (auto node = tree.begin_dfs_scan(); node != tree.end_dfs_scan(); ++node) 
+    {
+        ss << node->get_value() << " ";
+        if (node->get_value() == 4 || node->get_value() == 3) node.skip_children();
+    }
+    CHECK(ss.str() == "1 2 4 5 3 ");
+
+    ss.str("");
+    for (auto node = tree.begin_bfs_scan(); node != tree.end_bfs_scan(); ++node) 
+    {
+        ss << node->get_value() << " ";
+        if (node->get_value() == 2) node.skip_children();
+    }
+    CHECK(ss.str() == "1 2 3 6 ");
+
+    // Skipping the last node ends the traversal normally
+    ss.str("");
+    for (auto node = tree.begin_bfs_scan(); node != tree.end_bfs_scan(); ++node) 
+    {
+        ss << node->get_value() << " ";
+        node.skip_children();
+    }
+    CHECK(ss.str() == "1 ");
+}
+
+TEST_CASE("Depth-limited traversals") {
+    Tree<int, 3> tree;
+    Node<int>* n1 = new Node<int>(1);
+    Node<int>* n2 = new Node<int>(2);
+    Node<int>* n3 = new Node<int>(3);
+    Node<int>* n4 = new Node<int>(4);
+    Node<int>* n5 = new Node<int>(5);
+    Node<int>* n6 = new Node<int>(6);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n3, n5);
+    tree.add_sub_node(n4, n6);
+
+    stringstream ss;
+    for (auto node = tree.begin_bfs_scan(1); node != tree.end_bfs_scan(); ++node) 
+    {
+        ss << node->get_value() << ":" << node.depth() << " ";
+    }
+    CHECK(ss.str() == "1:0 2:1 3:1 ");
+
+    ss.str("");
+    for (auto node = tree.begin_dfs_scan(2); node != tree.end_dfs_scan(); ++node) 
+    {
+        ss << node->get_value() << ":" << node.depth() << " ";
+    }
+    CHECK(ss.str() == "1:0 2:1 4:2 3:1 5:2 ");
+
+    ss.str("");
+    for (auto node = tree.begin_pre_order(0); node != tree.end_pre_order(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "1 ");
+    CHECK(++tree.begin_bfs_scan(0) == tree.end_bfs_scan());
+    CHECK(++tree.begin_dfs_scan(0) == tree.end_dfs_scan());
+}
+
+
+//--------------------------//
+//   Subtree traversal tests //
+//--------------------------//
+
+TEST_CASE("Every traversal order can start from a subtree root") {
+    Tree<int> tree;
+    Node<int>* n1 = new Node<int>(1);
+    Node<int>* n2 = new Node<int>(2);
+    Node<int>* n3 = new Node<int>(3);
+    Node<int>* n4 = new Node<int>(4);
+    Node<int>* n5 = new Node<int>(5);
+    Node<int>* n6 = new Node<int>(6);
+    Node<int>* n7 = new Node<int>(7);
+
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n2, n4);
+    tree.add_sub_node(n2, n5);
+    tree.add_sub_node(n4, n6);
+    tree.add_sub_node(n5, n7);
+
+    stringstream ss;
+    for (auto node = tree.begin_pre_order_from(n2); node != tree.end_pre_order(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "2 4 6 5 7 ");
+
+    ss.str("");
+    for (auto node = tree.begin_post_order_from(n2); node != tree.end_post_order(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "6 4 7 5 2 ");
+
+    ss.str("");
+    for (auto node = tree.begin_in_order_from(n2); node != tree.end_in_order(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "6 4 2 7 5 ");
+
+    ss.str("");
+    for (auto node = tree.begin_bfs_scan_from(n2); node != tree.end_bfs_scan(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "2 4 5 6 7 ");
+
+    ss.str("");
+    for (auto node = tree.begin_dfs_scan_from(n5); node != tree.end_dfs_scan(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "5 7 ");
+
+    ss.str("");
+    for (auto node = tree.begin_heap_from(n2); node != tree.end_heap(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "2 4 5 6 7 ");
+
+    // Start node and depth limit combined
+    ss.str("");
+    for (auto node = tree.begin_bfs_scan_from(n2, 1); node != tree.end_bfs_scan(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "2 4 5 ");
+
+    // A leaf traverses only itself
+    ss.str("");
+    for (auto node = tree.begin_post_order_from(n7); node != tree.end_post_order(); ++node) 
+    {
+        ss << node->get_value() << " ";
+    }
+    CHECK(ss.str() == "7 ");
+}
+
+
+//--------------------------//
+//   Merkle hashing tests   //
+//--------------------------//
+
+TEST_CASE("Merkle hashes detect equal subtrees and changes") {
+    Tree<string, 3> a;
+    Tree<string, 3> b;
+    for (Tree<string, 3>* t : {&a, &b}) 
+    {
+        Node<string>* root = new Node<string>("root");
+        Node<string>* x = new Node<string>("x");
+        Node<string>* y = new Node<string>("y");
+        t->add_root(root);
+        t->enable_merkle_hashing();
+        t->add_sub_node(root, x);
+        t->add_sub_node(root, y);
+        t->add_sub_node(x, new Node<string>("leaf"));
+        t->add_sub_node(y, new Node<string>("leaf"));
+    }
+    CHECK(a.root_hash() == b.root_hash());
+
+    // x and y hold different values, but their children are identical leaves
+    Node<string>* ax = a.root->get_children()[0];
+    Node<string>* ay = a.root->get_children()[1];
+    CHECK_FALSE(a.subtree_equal(ax, ay));
+    CHECK(a.subtree_equal(ax->get_children()[0], ay->get_children()[0], true));
+    CHECK(a.subtree_equal(ax, b, b.root->get_children()[0], true));
+
+    // An insertion deep in the tree changes every hash on the path to the root
+    uint64_t before = a.root_hash();
+    uint64_t sibling = a.subtree_hash(ay);
+    a.add_sub_node(ax->get_children()[0], new Node<string>("new"));
+    CHECK(a.root_hash() != before);
+    CHECK(a.root_hash() != b.root_hash());
+    CHECK(a.subtree_hash(ay) == sibling);
+
+    // Incremental maintenance matches a full recomputation
+    uint64_t incremental = a.root_hash();
+    a.enable_merkle_hashing();
+    CHECK(a.root_hash() == incremental);
+    a.disable_merkle_hashing();
+    CHECK_THROWS_AS(a.subtree_hash(ay), std::logic_error);
+    CHECK_THROWS_AS(b.subtree_equal(b.root, a, a.root), std::logic_error);
+
+    // The same values in another shape hash differently
+    Tree<int, 2> chain;
+    Tree<int, 2> fork;
+    Node<int>* c1 = new Node<int>(1);
+    Node<int>* c2 = new Node<int>(2);
+    Node<int>* f1 = new Node<int>(1);
+    chain.add_root(c1);
+    chain.add_sub_node(c1, c2);
+    chain.add_sub_node(c2, new Node<int>(3));
+    fork.add_root(f1);
+    fork.add_sub_node(f1, new Node<int>(2));
+    fork.add_sub_node(f1, new Node<int>(3));
+    chain.enable_merkle_hashing();
+    fork.enable_merkle_hashing();
+    CHECK(chain.root_hash() != fork.root_hash());
+
+    Tree<Complex> complexTree;
+    CHECK_THROWS_AS(complexTree.root_hash(), std::logic_error);
+    complexTree.enable_merkle_hashing();
+    CHECK(complexTree.root_hash() == 0);
+}
+
+/**
+ * @brief A value type with no std::hash, operator< or operator==.
+ */
+struct Opaque
+{
+    int id;
+};
+
+TEST_CASE("Trees of values without hashing or ordering work without the optional features") {
+    Tree<Opaque, 3> tree;
+    Node<Opaque>* root = new Node<Opaque>(Opaque{1});
+    tree.add_root(root);
+    tree.add_sub_node(root, new Node<Opaque>(Opaque{2}));
+    tree.add_sub_node(root, new Node<Opaque>(Opaque{3}));
+    tree.enable_parent_links();
+    tree.add_sub_node(root->get_children()[0], new Node<Opaque>(Opaque{4}));
+    tree.set_value(root->get_children()[1], Opaque{5});
+    tree.remove_sub_node(root, 0);
+
+    int sum = 0;
+    for (auto node = tree.begin_dfs_scan(); node != tree.end_dfs_scan(); ++node)
+    {
+        sum += node->get_value().id;
+    }
+    CHECK(sum == 6);
+    CHECK(tree.get_parent(root->get_children()[0]) == root);
+
+    tree.build_from_parents({Opaque{7}, Opaque{8}}, {Tree<Opaque, 3>::NO_PARENT, 0});
+    CHECK(tree.get_parent(tree.root->get_children()[0]) == tree.root);
+
+    // The optional features keep their state in the tree, so a node is only its value and its children
+    struct Bare
+    {
+        int value;
+        vector<Node<int>*> children;
+    };
+    CHECK(sizeof(Node<int>) == sizeof(Bare));
+}
+
+//--------------------------------------//
+// Value updates, removals and diffing //
+//--------------------------------------//
+
+TEST_CASE("set_value and remove_sub_node keep indexes and summaries in sync") {
+    Tree<int, 3> tree;
+    Node<int>* n1 = new Node<int>(10);
+    Node<int>* n2 = new Node<int>(20);
+    Node<int>* n3 = new Node<int>(30);
+    Node<int>* n4 = new Node<int>(40);
+    tree.add_root(n1);
+    tree.add_sub_node(n1, n2);
+    tree.add_sub_node(n1, n3);
+    tree.add_sub_node(n3, n4);
+    tree.enable_value_index();
+    tree.enable_sorted_index();
+    tree.enable_zone_maps();
+    tree.enable_bloom_filters();
+    tree.enable_merkle_hashing();
+
+    unsigned long version = tree.get_version();
+    tree.set_value(n4, 5);
+    CHECK(tree.get_version() > version);
+    CHECK(tree.find(40) == nullptr);
+    CHECK(tree.find(5) == n4);
+
+    // Value changes are sorted back in at the next query, however many there were
+    tree.set_value(n2, 50);
+    tree.set_value(n2, 25);
+    vector<int> ordered;
+    for (Node<int>* node : tree.find_range(0, 100)) ordered.push_back(node->get_value());
+    CHECK(ordered == vector<int>{5, 10, 25, 30});
+    tree.set_value(n2, 20);
+    CHECK(tree.subtree_range(n1) == std::make_pair(5, 30));
+    CHECK_FALSE(tree.subtree_may_contain(n3, 40));
+    uint64_t incremental = tree.root_hash();
+    tree.enable_merkle_hashing();
+    CHECK(tree.root_hash() == incremental);
+
+    // Removing a subtree shrinks the summaries of its ancestors, and drops its pending value changes
+    tree.set_value(n4, 5);
+    tree.remove_sub_node(n1, 1);
+    CHECK(n1->get_children().size() == 1);
+    CHECK(tree.find(5) == nullptr);
+    CHECK(tree.find_range(0, 100).size() == 2);
+    CHECK(tree.subtree_range(n1) == std::make_pair(10, 20));
+    incremental = tree.root_hash();
+    tree.enable_merkle_hashing();
+    CHECK(tree.root_hash() == incremental);
+    CHECK_THROWS_AS(tree.remove_sub_node(n1, 1), std::out_of_range);
+
+    tree.clear();
+    CHECK(tree.root == nullptr);
+    CHECK(tree.find(10) == nullptr);
+}
+
+TEST_CASE("diff_trees and apply_patch turn one tree into another") {
+    // from: 1 -> (2 -> (5, 6), 3, 4 -> (7))
+    // to:   1 -> (2 -> (5, 8 -> (11)), 9)
+    Tree<int, 3> from;
+    Node<int>* f1 = new Node<int>(1);
+    Node<int>* f2 = new Node<int>(2);
+    Node<int>* f4 = new Node<int>(4);
+    from.add_root(f1);
+    from.add_sub_node(f1, f2);
+    from.add_sub_node(f1, new Node<int>(3));
+    from.add_sub_node(f1, f4);
+    from.add_sub_node(f2, new Node<int>(5));
+    from.add_sub_node(f2, new Node<int>(6));
+    from.add_sub_node(f4, new Node<int>(7));
+
+    Tree<int, 3> to;
+    Node<int>* t1 = new Node<int>(1);
+    Node<int>* t2 = new Node<int>(2);
+    Node<int>* t8 = new Node<int>(8);
+    to.add_root(t1);
+    to.add_sub_node(t1, t2);
+    to.add_sub_node(t1, new Node<int>(9));
+    to.add_sub_node(t2, new Node<int>(5));
+    to.add_sub_node(t2, t8);
+    to.add_sub_node(t8, new Node<int>(11));
+
+    EditScript<int> script = diff_trees(from, to);
+    CHECK(script.size() == 4);      // change 6 -> 8, insert 11, change 3 -> 9, remove 4 with its child
+    CHECK(script[0].kind == TreeEdit<int>::Kind::Remove);
+    CHECK(script[0].path == vector<size_t>{2});
+
+    // The Merkle-pruned diff produces the same script
+    from.enable_merkle_hashing();
+    to.enable_merkle_hashing();
+    EditScript<int> pruned = diff_trees(from, to);
+    CHECK(pruned.size() == script.size());
+    for (size_t i = 0; i < script.size(); ++i)
+    {
+        CHECK(pruned[i].kind == script[i].kind);
+        CHECK(pruned[i].path == script[i].path);
+        CHECK(pruned[i].values == script[i].values);
+    }
+
+    from.enable_value_index();
+    apply_patch(from, script);
+    CHECK(from.subtree_equal(from.root, to, to.root, true));
+    CHECK(diff_trees(from, to).empty());
+    CHECK(from.find(8) != nullptr);
+    CHECK(from.find(7) == nullptr);
+    uint64_t incremental = from.root_hash();
+    from.enable_merkle_hashing();
+    CHECK(from.root_hash() == incremental);
+
+    // A patch that does not fit the tree is rejected
+    CHECK_THROWS_AS(apply_patch(from, script), std::invalid_argument);
+    EditScript<int> bad{{TreeEdit<int>::Kind::Insert, {0, 5}, {1}, {0}}};
+    CHECK_THROWS_AS(apply_patch(from, bad), std::invalid_argument);
+    bad = {{TreeEdit<int>::Kind::Insert, {2}, {1, 2}, {2, 0}}};
+    CHECK_THROWS_AS(apply_patch(from, bad), std::invalid_argument);
+}
+
+TEST_CASE("diff_trees handles empty trees and root replacement") {
+    Tree<string> empty;
+    Tree<string> other;
+    other.enable_parent_links();
+    CHECK(diff_trees(empty, other).empty());
+
+    Tree<string> tree;
+    Node<string>* root = new Node<string>("root");
+    tree.add_root(root);
+    tree.add_sub_node(root, new Node<string>("left"));
+    tree.add_sub_node(root, new Node<string>("right"));
+
+    EditScript<string> create = diff_trees(empty, tree);
+    REQUIRE(create.size() == 1);
+    CHECK(create[0].kind == TreeEdit<string>::Kind::Insert);
+    CHECK(create[0].values == vector<string>{"root", "left", "right"});
+    CHECK(create[0].childCounts == vector<size_t>{2, 0, 0});
+    apply_patch(other, create);
+    REQUIRE(other.root != nullptr);
+    CHECK(other.root->get_children()[1]->get_value() == "right");
+    CHECK(other.get_parent(other.root->get_children()[1]) == other.root);
+
+    apply_patch(other, diff_trees(other, empty));
+    CHECK(other.root == nullptr);
+}
+
+//-----------------------------------//
+// Hash-consed compact trees (DAGs) //
+//-----------------------------------//
+
+/**
+ * @brief Collects the values visited between two iterators.
+ */
+template <typename Iterator>
+vector<int> collect_values(Iterator first, Iterator last)
+{
+    vector<int> values;
+    for (; first != last; ++first)
+    {
+        values.push_back(first->get_value());
+    }
+    return values;
+}
+
+/**
+ * @brief Attaches a complete binary subtree whose values depend only on the depth, so all subtrees of a level are equal.
+ */
+void add_layered(Tree<int>& tree, Node<int>* parent, int depth)
+{
+    if (depth == 0) return;
+    for (int i = 0; i < 2; ++i)
+    {
+        Node<int>* child = new Node<int>(depth);
+        tree.add_sub_node(parent, child);
+        add_layered(tree, child, depth - 1);
+    }
+}
+
+TEST_CASE("CompactTree shares identical subtrees and keeps every traversal order") {
+    Tree<int> tree;
+    Node<int>* root = new Node<int>(100);
+    tree.add_root(root);
+    add_layered(tree, root, 6);         // 127 nodes, but only one distinct subtree per level
+
+    CompactTree<int> compact(tree);
+    CHECK(compact.size() == 127);
+    CHECK(compact.unique_size() == 7);
+    CHECK(compact.get_root()->get_children()[0] == compact.get_root()->get_children()[1]);
+
+    CHECK(collect_values(compact.begin_pre_order(), compact.end_pre_order()) == collect_values(tree.begin_pre_order(), tree.end_pre_order()));
+    CHECK(collect_values(compact.begin_post_order(), compact.end_post_order()) == collect_values(tree.begin_post_order(), tree.end_post_order()));
+    CHECK(collect_values(compact.begin_in_order(), compact.end_in_order()) == collect_values(tree.begin_in_order(), tree.end_in_order()));
+    CHECK(collect_values(compact.begin_bfs_scan(), compact.end_bfs_scan()) == collect_values(tree.begin_bfs_scan(), tree.end_bfs_scan()));
+    CHECK(collect_values(compact.begin_dfs_scan(), compact.end_dfs_scan()) == collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()));
+    CHECK(collect_values(compact.myHeap(), compact.end_heap()) == collect_values(tree.myHeap(), tree.end_heap()));
+    CHECK(collect_values(compact.begin_bfs_scan(2), compact.end_bfs_scan()).size() == 7);
+
+    // A differing leaf keeps its own copy of every subtree on the path above it
+    Node<int>* leaf = root;
+    while (!leaf->get_children().empty()) leaf = leaf->get_children()[0];
+    tree.add_sub_node(leaf, new Node<int>(0));
+    CompactTree<int> changed(tree);
+    CHECK(changed.size() == 128);
+    CHECK(changed.unique_size() == 14);
+    CHECK(collect_values(changed.begin_post_order(), changed.end_post_order()) == collect_values(tree.begin_post_order(), tree.end_post_order()));
+
+    Tree<int> empty;
+    CompactTree<int> none(empty);
+    CHECK(none.size() == 0);
+    CHECK(none.begin_pre_order() == none.end_pre_order());
+}
+
+TEST_CASE("CompactTree with string values and duplicates of different shapes") {
+    Tree<string, 3> tree;
+    Node<string>* root = new Node<string>("r");
+    Node<string>* a1 = new Node<string>("a");
+    Node<string>* a2 = new Node<string>("a");
+    Node<string>* a3 = new Node<string>("a");
+    tree.add_root(root);
+    tree.add_sub_node(root, a1);
+    tree.add_sub_node(root, a2);
+    tree.add_sub_node(root, a3);
+    tree.add_sub_node(a1, new Node<string>("x"));
+    tree.add_sub_node(a2, new Node<string>("x"));
+    tree.add_sub_node(a3, new Node<string>("y"));
+
+    CompactTree<string, 3> compact(tree);
+    CHECK(compact.size() == 7);
+    CHECK(compact.unique_size() == 5);     // r, a(x), a(y), x, y
+    const vector<Node<string>*>& children = compact.get_root()->get_children();
+    CHECK(children[0] == children[1]);
+    CHECK(children[1] != children[2]);
+
+    vector<string> expected;
+    for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it) expected.push_back(it->get_value());
+    vector<string> actual;
+    for (auto it = compact.begin_dfs_scan(); it != compact.end_dfs_scan(); ++it) actual.push_back(it->get_value());
+    CHECK(actual == expected);
+}
+
+//----------------//
+// Bulk builders //
+//----------------//
+
+TEST_CASE("Bulk build from a level-order array") {
+    Tree<int, 3> tree(vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    REQUIRE(tree.root != nullptr);
+    CHECK(tree.root->get_value() == 0);
+    CHECK(collect_values(tree.begin_bfs_scan(), tree.end_bfs_scan()) == vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    CHECK(collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()) == vector<int>{0, 1, 4, 5, 6, 2, 7, 8, 9, 3, 10});
+    CHECK(tree.root->get_children()[2]->get_children().size() == 1);
+    tree.enable_parent_links();
+    CHECK(tree.get_parent(tree.root->get_children()[1]) == tree.root);
+
+    // Rebuilding replaces the tree and refreshes the enabled indexes and summaries
+    tree.enable_value_index();
+    tree.enable_zone_maps();
+    tree.enable_merkle_hashing();
+    tree.build_from_level_order({5, 6, 7});
+    CHECK(tree.find(10) == nullptr);
+    CHECK(tree.find(7) == tree.root->get_children()[1]);
+    CHECK(tree.subtree_range(tree.root).second == 7);
+    uint64_t built = tree.root_hash();
+    tree.enable_merkle_hashing();
+    CHECK(tree.root_hash() == built);
+
+    // Block nodes can be mixed with separately allocated nodes, updated and removed
+    tree.add_sub_node(tree.root->get_children()[0], new Node<int>(11));
+    tree.set_value(tree.root->get_children()[1], 12);
+    tree.remove_sub_node(tree.root, 0);
+    CHECK(collect_values(tree.begin_pre_order(), tree.end_pre_order()) == vector<int>{5, 12});
+
+    tree.build_from_level_order({});
+    CHECK(tree.root == nullptr);
+}
+
+TEST_CASE("Bulk build from a parent array") {
+    // c -> (a, b, e -> (d)): children keep their input order
+    vector<string> values{"a", "b", "c", "d", "e"};
+    vector<size_t> parents{2, 2, Tree<string, 3>::NO_PARENT, 4, 2};
+    Tree<string, 3> tree(values, parents);
+    REQUIRE(tree.root != nullptr);
+    CHECK(tree.root->get_value() == "c");
+    vector<string> order;
+    for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it) order.push_back(it->get_value());
+    CHECK(order == vector<string>{"c", "a", "b", "e", "d"});
+
+    // A deep chain is built and destroyed without recursion
+    const size_t length = 200000;
+    vector<int> chainValues(length);
+    vector<size_t> chainParents(length);
+    for (size_t i = 0; i < length; ++i)
+    {
+        chainValues[i] = static_cast<int>(i);
+        chainParents[i] = i == 0 ? Tree<int>::NO_PARENT : i - 1;
+    }
+    Tree<int> chain(chainValues, chainParents);
+    CHECK(chain.root->get_children()[0]->get_value() == 1);
+
+    Tree<int> broken;
+    CHECK_THROWS_AS(broken.build_from_parents({1, 2}, {Tree<int>::NO_PARENT}), std::invalid_argument);
+    CHECK_THROWS_AS(broken.build_from_parents({1, 2}, {Tree<int>::NO_PARENT, Tree<int>::NO_PARENT}), std::invalid_argument);
+    CHECK_THROWS_AS(broken.build_from_parents({1, 2}, {Tree<int>::NO_PARENT, 7}), std::invalid_argument);
+    CHECK_THROWS_AS(broken.build_from_parents({1, 2, 3}, {2, 0, 1}), std::invalid_argument);
+    CHECK_THROWS_AS(broken.build_from_parents({1, 2, 3, 4}, {Tree<int>::NO_PARENT, 2, 1, 0}), std::invalid_argument);
+    CHECK_THROWS_AS(broken.build_from_parents({1, 2, 3, 4}, {Tree<int>::NO_PARENT, 0, 0, 0}), std::invalid_argument);
+    CHECK(broken.root == nullptr);
+}
+
+/**
+ * @brief Retrieves the height of a tree (0 for a single node) from the DFS iterator depths.
+ */
+template <typename T, int k>
+size_t tree_height(Tree<T, k>& tree)
+{
+    size_t height = 0;
+    for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it)
+    {
+        height = std::max(height, it.depth());
+    }
+    return height;
+}
+
+TEST_CASE("build_balanced makes height-optimal trees that keep the input order") {
+    for (size_t count = 0; count <= 40; ++count)
+    {
+        vector<int> sorted(count);
+        for (size_t i = 0; i < count; ++i) sorted[i] = static_cast<int>(3 * i);
+
+        Tree<int> binary;
+        binary.build_balanced(sorted);
+        CHECK(collect_values(binary.begin_in_order(), binary.end_in_order()) == sorted);
+        if (count == 0) continue;
+
+        // The smallest height h with 2^(h+1) - 1 >= count
+        size_t optimal = 0;
+        while ((size_t(1) << (optimal + 1)) - 1 < count) ++optimal;
+        CHECK(tree_height(binary) == optimal);
+
+        Tree<int, 3> ternary;
+        ternary.build_balanced(sorted.data(), count, 2);
+        CHECK(collect_values(ternary.begin_bfs_scan(), ternary.end_bfs_scan()).size() == count);
+        size_t ternaryOptimal = 0;
+        for (size_t capacity = 1, level = 1; capacity < count; level *= 3, capacity += level) ++ternaryOptimal;
+        CHECK(tree_height(ternary) == ternaryOptimal);
+    }
+}
+
+TEST_CASE("build_balanced gives the same tree on one thread and on several") {
+    const size_t count = 300000;
+    vector<int> sorted(count);
+    for (size_t i = 0; i < count; ++i) sorted[i] = static_cast<int>(i);
+
+    Tree<int> serial;
+    Tree<int> parallel;
+    parallel.enable_parent_links();
+    serial.build_balanced(sorted, 1);
+    parallel.build_balanced(sorted, 4);
+    serial.enable_merkle_hashing();
+    parallel.enable_merkle_hashing();
+    CHECK(serial.root_hash() == parallel.root_hash());
+    CHECK(collect_values(parallel.begin_in_order(), parallel.end_in_order()) == sorted);
+    CHECK(parallel.get_parent(parallel.root->get_children()[1]) == parallel.root);
+
+    Tree<string, 4> strings;
+    strings.enable_sorted_index();
+    strings.build_balanced({"a", "b", "c", "d", "e", "f"});
+    CHECK(strings.find_range("b", "d").size() == 3);
+}
+
+//-----------------------//
+// Binary serialization //
+//-----------------------//
+
+TEST_CASE("Binary round trip through a FILE* for int, double, string and Complex trees") {
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+
+    Tree<int, 3> ints(vector<int>{-5, 7, 2147483647, -2147483647 - 1, 0, 42});
+    Tree<double> doubles(vector<double>{1.5, -0.0, 1e300, 3.25});
+    Tree<string, 4> strings;
+    Node<string>* root = new Node<string>("root");
+    strings.add_root(root);
+    strings.add_sub_node(root, new Node<string>(""));
+    strings.add_sub_node(root, new Node<string>(string("with\0zero", 9)));
+    strings.add_sub_node(root->get_children()[1], new Node<string>(string(100000, 'x')));
+    Tree<Complex> complexes(vector<Complex>{Complex(1, 2), Complex(-3.5, 0), Complex(0, -1)});
+    Tree<int> empty;
+
+    write_tree(ints, file);
+    write_tree(doubles, file);
+    write_tree(strings, file);
+    write_tree(complexes, file);
+    write_tree(empty, file);
+    std::rewind(file);
+
+    // One reader for the whole file, since a reader may buffer past the end of a tree
+    BinaryReader in(file);
+    Tree<int, 3> ints2;
+    Tree<double> doubles2;
+    Tree<string, 4> strings2;
+    Tree<Complex> complexes2;
+    Tree<int> empty2(vector<int>{1, 2});
+    read_tree(ints2, in);
+    read_tree(doubles2, in);
+    read_tree(strings2, in);
+    read_tree(complexes2, in);
+    read_tree(empty2, in);
+
+    CHECK(collect_values(ints2.begin_bfs_scan(), ints2.end_bfs_scan()) == vector<int>{-5, 7, 2147483647, -2147483647 - 1, 0, 42});
+    CHECK(collect_values(ints2.begin_dfs_scan(), ints2.end_dfs_scan()) == collect_values(ints.begin_dfs_scan(), ints.end_dfs_scan()));
+    vector<double> d;
+    for (auto it = doubles2.begin_pre_order(); it != doubles2.end_pre_order(); ++it) d.push_back(it->get_value());
+    CHECK(d == vector<double>{1.5, -0.0, 3.25, 1e300});
+    strings.enable_merkle_hashing();
+    strings2.enable_merkle_hashing();
+    CHECK(strings.subtree_equal(strings.root, strings2, strings2.root, true));
+    CHECK(strings2.root->get_children()[1]->get_value().size() == 9);
+    CHECK(complexes2.root->get_children()[1]->get_value() == Complex(0, -1));
+    CHECK(empty2.root == nullptr);
+    std::fclose(file);
+}
+
+TEST_CASE("Binary round trip through a file descriptor and rejection of bad input") {
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    int fd = fileno(file);
+
+    vector<int> sorted(5000);
+    for (size_t i = 0; i < sorted.size(); ++i) sorted[i] = static_cast<int>(i);
+    Tree<int> tree;
+    tree.build_balanced(sorted);
+    write_tree(tree, fd);
+    REQUIRE(lseek(fd, 0, SEEK_SET) == 0);
+
+    Tree<int> copy;
+    read_tree(copy, fd);
+    CHECK(collect_values(copy.begin_in_order(), copy.end_in_order()) == sorted);
+
+    // Another value type, a smaller k and a truncated file are all rejected
+    REQUIRE(lseek(fd, 0, SEEK_SET) == 0);
+    Tree<double> wrongType;
+    CHECK_THROWS_AS(read_tree(wrongType, fd), std::runtime_error);
+
+    Tree<string, 3> wide(vector<string>{"a", "b", "c", "d"});
+    std::FILE* other = std::tmpfile();
+    write_tree(wide, other);
+    std::rewind(other);
+    Tree<string, 2> narrow;
+    CHECK_THROWS_AS(read_tree(narrow, other), std::runtime_error);
+
+    // A forged node count of 2^60 fails as truncated input, without allocating for it
+    const unsigned char forged[8] = {0, 0, 0, 0, 0, 0, 0, 0x10};
+    REQUIRE(pwrite(fd, forged, sizeof(forged), 16) == 8);
+    REQUIRE(lseek(fd, 0, SEEK_SET) == 0);
+    CHECK_THROWS_AS(read_tree(copy, fd), std::runtime_error);
+
+    REQUIRE(ftruncate(fd, 100) == 0);
+    REQUIRE(lseek(fd, 0, SEEK_SET) == 0);
+    CHECK_THROWS_AS(read_tree(copy, fd), std::runtime_error);
+    std::fclose(other);
+    std::fclose(file);
+}
+
+/**
+ * @brief Creates an empty temporary file and returns its path.
+ */
+string temporary_path()
+{
+    char path[] = "/tmp/tree_test_XXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    close(fd);
+    return path;
+}
+
+TEST_CASE("Compressed round trips for int, double, string and Complex trees") {
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+
+    vector<int> walk(10000);
+    int value = 1000;
+    for (size_t i = 0; i < walk.size(); ++i)
+    {
+        value += static_cast<int>(i % 7) - 3;
+        walk[i] = value;
+    }
+    walk[17] = 2147483647;
+    walk[18] = -2147483647 - 1;
+    Tree<int, 3> ints(walk);
+    Tree<double> doubles(vector<double>{20.5, 20.5, 20.75, -0.0, 1e300, 20.5, 3.25});
+    Tree<string, 4> strings;
+    Node<string>* root = new Node<string>("red");
+    strings.add_root(root);
+    for (const char* word : {"green", "red", "", "green"})
+    {
+        strings.add_sub_node(root, new Node<string>(word));
+    }
+    strings.add_sub_node(root->get_children()[2], new Node<string>(string("zero\0byte", 9)));
+    Tree<Complex> complexes(vector<Complex>{Complex(1, 2), Complex(-3.5, 0), Complex(0, -1)});
+    Tree<int> empty;
+
+    write_compressed_tree(ints, file, 100);
+    long compressedSize = std::ftell(file);
+    write_compressed_tree(doubles, file, 3);
+    write_compressed_tree(strings, file, 1);
+    write_compressed_tree(complexes, file);
+    write_compressed_tree(empty, file);
+    long plainStart = std::ftell(file);
+    write_tree(ints, file);
+    long plainSize = std::ftell(file) - plainStart;
+    std::rewind(file);
+
+    BinaryReader in(file);
+    Tree<int, 3> ints2;
+    Tree<double> doubles2;
+    Tree<string, 4> strings2;
+    Tree<Complex> complexes2;
+    Tree<int> empty2(vector<int>{1, 2});
+    Tree<int, 3> plain;
+    read_tree(ints2, in);
+    read_tree(doubles2, in);
+    read_tree(strings2, in);
+    read_tree(complexes2, in);
+    read_tree(empty2, in);
+    read_tree(plain, in);
+
+    CHECK(collect_values(ints2.begin_bfs_scan(), ints2.end_bfs_scan()) == walk);
+    CHECK(collect_values(ints2.begin_dfs_scan(), ints2.end_dfs_scan()) == collect_values(ints.begin_dfs_scan(), ints.end_dfs_scan()));
+    CHECK(collect_values(plain.begin_bfs_scan(), plain.end_bfs_scan()) == walk);
+    CHECK(compressedSize * 2 < plainSize);      // Small deltas take one byte instead of four
+    vector<double> d;
+    for (auto it = doubles2.begin_bfs_scan(); it != doubles2.end_bfs_scan(); ++it) d.push_back(it->get_value());
+    CHECK(d == vector<double>{20.5, 20.5, 20.75, -0.0, 1e300, 20.5, 3.25});
+    CHECK(std::signbit(d[3]));
+    strings.enable_merkle_hashing();
+    strings2.enable_merkle_hashing();
+    CHECK(strings2.root_hash() == strings.root_hash());
+    CHECK(complexes2.root->get_children()[0]->get_value() == Complex(-3.5, 0));
+    CHECK(empty2.root == nullptr);
+    std::fclose(file);
+}
+
+TEST_CASE("Compressed files report corrupt blocks") {
+    vector<double> values(1000);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = 0.5 * static_cast<double>(i % 10);
+    Tree<double> tree(values);
+    std::FILE* file = std::tmpfile();
+    CHECK_THROWS_AS(write_compressed_tree(tree, file, 0), std::invalid_argument);
+    write_compressed_tree(tree, file, 256);
+    long size = std::ftell(file);
+
+    // Flip one byte near the end, inside the last value block
+    std::fseek(file, size - 3, SEEK_SET);
+    int byte = std::fgetc(file);
+    std::fseek(file, size - 3, SEEK_SET);
+    std::fputc(byte ^ 0x40, file);
+    std::rewind(file);
+    Tree<double> copy;
+    try
+    {
+        read_tree(copy, file);
+        CHECK(false);
+    }
+    catch (const std::runtime_error& error)
+    {
+        CHECK(string(error.what()) == "read_tree: checksum mismatch in block 3 of the value column.");
+    }
+
+    // A forged block length fails as truncated input
+    std::fseek(file, TreeFileHeader::SIZE + 4, SEEK_SET);
+    const unsigned char forged[4] = {0xff, 0xff, 0xff, 0xff};
+    std::fwrite(forged, 1, sizeof(forged), file);
+    std::rewind(file);
+    CHECK_THROWS_AS(read_tree(copy, file), std::runtime_error);
+
+    // A compressed file never passes for a frozen one
+    std::fclose(file);
+    string path = temporary_path();
+    file = std::fopen(path.c_str(), "wb");
+    write_compressed_tree(tree, file);
+    std::fclose(file);
+    CHECK_THROWS_AS(FrozenTree<double>{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("FrozenTree walks a memory-mapped file in BFS, DFS and pre-order") {
+    Tree<int, 3> tree;
+    Node<int>* root = new Node<int>(1);
+    Node<int>* a = new Node<int>(2);
+    Node<int>* b = new Node<int>(3);
+    tree.add_root(root);
+    tree.add_sub_node(root, a);
+    tree.add_sub_node(root, b);
+    tree.add_sub_node(a, new Node<int>(4));
+    tree.add_sub_node(a, new Node<int>(5));
+    tree.add_sub_node(a, new Node<int>(6));
+    tree.add_sub_node(b, new Node<int>(7));
+    tree.add_sub_node(b->get_children()[0], new Node<int>(-8));
+
+    string path = temporary_path();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(tree, file);
+    std::fclose(file);
+
+    FrozenTree<int> frozen(path);
+    CHECK(frozen.size() == 8);
+    CHECK(frozen.get_root().get_value() == 1);
+    CHECK(frozen.get_root().child_count() == 2);
+    CHECK(frozen.get_root().child(1).child(0).child(0).get_value() == -8);
+    CHECK(collect_values(frozen.begin_bfs_scan(), frozen.end_bfs_scan()) == collect_values(tree.begin_bfs_scan(), tree.end_bfs_scan()));
+    CHECK(collect_values(frozen.begin_dfs_scan(), frozen.end_dfs_scan()) == collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()));
+    CHECK(collect_values(frozen.begin_pre_order(), frozen.end_pre_order()) == collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()));
+    size_t visited = 0;
+    for (const FrozenNode<int>& node : frozen)
+    {
+        visited += node.child_count();
+    }
+    CHECK(visited == 7);
+
+    // A frozen file is still an ordinary serialized tree
+    file = std::fopen(path.c_str(), "rb");
+    Tree<int, 3> copy;
+    read_tree(copy, file);
+    std::fclose(file);
+    CHECK(collect_values(copy.begin_dfs_scan(), copy.end_dfs_scan()) == collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()));
+
+    CHECK_THROWS_AS(FrozenTree<double>{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("FrozenTree with Complex values, empty trees and non-frozen files") {
+    Tree<Complex> tree(vector<Complex>{Complex(1, 1), Complex(2, -2), Complex(3.5, 0)});
+    string path = temporary_path();
+    int fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+    write_frozen_tree(tree, fd);
+    close(fd);
+    {
+        FrozenTree<Complex> frozen(path);
+        CHECK(frozen.get_root().child(1).get_value() == Complex(3.5, 0));
+        vector<Complex> values;
+        for (auto it = frozen.begin_dfs_scan(); it != frozen.end_dfs_scan(); ++it) values.push_back(it->get_value());
+        CHECK(values.size() == 3);
+        CHECK(values[1] == Complex(2, -2));
+    }
+
+    Tree<Complex> empty;
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(empty, file);
+    std::fclose(file);
+    {
+        FrozenTree<Complex> frozen(path);
+        CHECK(frozen.size() == 0);
+        CHECK(frozen.begin() == frozen.end());
+        CHECK_THROWS_AS(frozen.get_root(), std::logic_error);
+    }
+
+    file = std::fopen(path.c_str(), "wb");
+    write_tree(tree, file);
+    std::fclose(file);
+    CHECK_THROWS_AS(FrozenTree<Complex>{path}, std::runtime_error);
+    CHECK_THROWS_AS(FrozenTree<Complex>("/nonexistent/tree.bin"), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+//-----------------------//
+// Persistent trees //
+//-----------------------//
+
+TEST_CASE("PersistentTree keeps its nodes across reopening") {
+    string path = temporary_path();
+    {
+        PersistentTree<int, 3> tree(path);
+        CHECK(tree.size() == 0);
+        CHECK(!tree.get_root());
+        CHECK(tree.begin() == tree.end());
+
+        PersistentNode<int, 3> root = tree.add_root(1);
+        PersistentNode<int, 3> a = tree.add_sub_node(root, 2);
+        tree.add_sub_node(root, 3);
+        tree.add_sub_node(a, 4);
+        tree.add_sub_node(a, 5);
+        tree.add_sub_node(root, 6);
+        CHECK(!tree.add_sub_node(root, 7));
+        tree.set_value(a, 20);
+        tree.checkpoint();
+    }
+
+    PersistentTree<int, 3> tree(path);
+    CHECK(tree.size() == 6);
+    PersistentNode<int, 3> root = tree.get_root();
+    CHECK(root.get_value() == 1);
+    CHECK(root.child_count() == 3);
+    CHECK(root.child(0).get_value() == 20);
+    CHECK(root.child(0).child(1).get_parent() == root.child(0));
+    CHECK(!root.get_parent());
+    CHECK_THROWS_AS(root.child(3), std::out_of_range);
+
+    // Handles to no node and offsets that are not node records never reach the header
+    PersistentNode<int, 3> none;
+    tree.set_value(none, 99);
+    CHECK(!tree.add_sub_node(none, 99));
+    CHECK(none.child_count() == 0);
+    CHECK(!none.get_parent());
+    CHECK_THROWS_AS(none.get_value(), std::out_of_range);
+    CHECK_THROWS_AS(tree.value_at(0), std::out_of_range);
+    CHECK_THROWS_AS(tree.child_count_at(root.offset() + 1), std::out_of_range);
+    CHECK_THROWS_AS(tree.set_value(PersistentNode<int, 3>(&tree, uint64_t(1) << 40), 99), std::out_of_range);
+    CHECK(tree.size() == 6);
+    CHECK(tree.get_root() == root);
+
+    vector<int> bfs;
+    for (const PersistentNode<int, 3>& node : tree) bfs.push_back(node.get_value());
+    CHECK(bfs == vector<int>{1, 20, 3, 6, 4, 5});
+    vector<int> dfs;
+    for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it) dfs.push_back(it->get_value());
+    CHECK(dfs == vector<int>{1, 20, 4, 5, 3, 6});
+
+    using OtherValues = PersistentTree<double, 3>;
+    using OtherArity = PersistentTree<int, 2>;
+    CHECK_THROWS_AS(OtherValues{path}, std::runtime_error);
+    CHECK_THROWS_AS(OtherArity{path}, std::runtime_error);
+
+    // A root offset pointing into the header is rejected on reopening
+    int fd = open(path.c_str(), O_RDWR);
+    REQUIRE(fd >= 0);
+    const unsigned char forged[8] = {8, 0, 0, 0, 0, 0, 0, 0};
+    REQUIRE(pwrite(fd, forged, sizeof(forged), 24) == 8);
+    close(fd);
+    using SameTree = PersistentTree<int, 3>;
+    CHECK_THROWS_AS(SameTree{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("PersistentTree grows its file and keeps handles valid") {
+    string path = temporary_path();
+    {
+        PersistentTree<Complex> tree(path, 4);
+        PersistentNode<Complex> root = tree.add_root(Complex(0, 0));
+        vector<PersistentNode<Complex>> level{root};
+        double next = 1;
+        while (tree.size() < 3000)
+        {
+            vector<PersistentNode<Complex>> children;
+            for (const PersistentNode<Complex>& parent : level)
+            {
+                children.push_back(tree.add_sub_node(parent, Complex(next, -next)));
+                children.push_back(tree.add_sub_node(parent, Complex(next + 1, -next - 1)));
+                next += 2;
+            }
+            level = children;
+        }
+        CHECK(root.get_value() == Complex(0, 0));
+        CHECK(level.back().get_parent().child(1) == level.back());
+        tree.checkpoint();
+    }
+
+    PersistentTree<Complex> tree(path);
+    size_t count = 0;
+    double previous = -1;
+    bool increasing = true;
+    for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it, ++count)
+    {
+        increasing = increasing && it->get_value().getReal() > previous;
+        previous = it->get_value().getReal();
+    }
+    CHECK(count == tree.size());
+    CHECK(increasing);
+    std::remove(path.c_str());
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    std::fputs("definitely not a persistent tree, just some text longer than a header........", file);
+    std::fclose(file);
+    CHECK_THROWS_AS(PersistentTree<Complex>{path}, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+//-----------------------//
+// Paged trees //
+//-----------------------//
+
+TEST_CASE("PagedTree walks all six orders through a small buffer pool") {
+    vector<int> values;
+    for (int i = 0; i < 1000; ++i) values.push_back((i * 7919) % 1009);
+    Tree<int> tree(values);
+    string path = temporary_path();
+    write_paged_tree(tree, path, 256);
+
+    PagedTree<int> paged(path, 4 * 256);
+    CHECK(paged.size() == 1000);
+    CHECK(paged.nodes_per_page() == 8);
+    CHECK(paged.buffer_pool().frame_capacity() == 4);
+    CHECK(paged.get_root().get_value() == values[0]);
+    CHECK(paged.get_root().child(1).get_value() == values[2]);
+
+    CHECK(collect_values(paged.begin_pre_order(), paged.end_pre_order()) == collect_values(tree.begin_pre_order(), tree.end_pre_order()));
+    CHECK(collect_values(paged.begin_post_order(), paged.end_post_order()) == collect_values(tree.begin_post_order(), tree.end_post_order()));
+    CHECK(collect_values(paged.begin_in_order(), paged.end_in_order()) == collect_values(tree.begin_in_order(), tree.end_in_order()));
+    CHECK(collect_values(paged.begin_bfs_scan(), paged.end_bfs_scan()) == collect_values(tree.begin_bfs_scan(), tree.end_bfs_scan()));
+    CHECK(collect_values(paged.begin_dfs_scan(), paged.end_dfs_scan()) == collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()));
+    CHECK(collect_values(paged.myHeap(), paged.end_heap()) == collect_values(tree.myHeap(), tree.end_heap()));
+
+    CHECK(paged.buffer_pool().resident_pages() <= 4);
+    CHECK(paged.stats().misses > 125);
+    CHECK(paged.stats().evictions == paged.stats().misses - 4);
+
+    // Pre-order ids make a pre-order walk read every page exactly once
+    paged.buffer_pool().reset_stats();
+    collect_values(paged.begin_dfs_scan(), paged.end_dfs_scan());
+    CHECK(paged.stats().misses <= 125);
+    CHECK_THROWS_AS(paged.child_at(0, 2), std::out_of_range);
+    CHECK_THROWS_AS(paged.value_at(1000), std::out_of_range);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("PagedTree writes changed pages back and rejects other files") {
+    Tree<double, 3> tree(vector<double>{1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5});
+    string path = temporary_path();
+    write_paged_tree(tree, path, 128);
+    {
+        PagedTree<double, 3> paged(path, 128);
+        CHECK(paged.nodes_per_page() == 3);
+        CHECK_THROWS_AS(collect_values(paged.begin_in_order(), paged.end_in_order()), std::invalid_argument);
+        PagedNode<double, 3> node = paged.get_root().child(0).child(1);
+        CHECK(node.get_value() == 6.5);
+        paged.set_value(node, -6.5);
+        paged.set_value(paged.get_root(), -1.5);        // Evicts the page of the first change, which is written back
+        CHECK(paged.stats().writebacks == 1);
+        CHECK(node.get_value() == -6.5);
+    }
+    {
+        PagedTree<double, 3> paged(path, 1 << 20);
+        vector<double> dfs;
+        for (auto it = paged.begin_dfs_scan(); it != paged.end_dfs_scan(); ++it) dfs.push_back(it->get_value());
+        CHECK(dfs == vector<double>{-1.5, 2.5, 5.5, -6.5, 7.5, 3.5, 4.5});
+    }
+
+    using OtherValues = PagedTree<int, 3>;
+    using OtherArity = PagedTree<double, 2>;
+    CHECK_THROWS_AS(OtherValues(path, 4096), std::runtime_error);
+    CHECK_THROWS_AS(OtherArity(path, 4096), std::runtime_error);
+    CHECK_THROWS_AS(write_paged_tree(tree, path, 32), std::invalid_argument);
+
+    // Forged page sizes and node counts are rejected before any page is allocated or indexed
+    Tree<int, 8> wide(vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9});
+    auto forge = [&](uint64_t pageSize, uint64_t count, uint64_t perPage) {
+        write_paged_tree(wide, path, 4096);
+        int fd = open(path.c_str(), O_RDWR);
+        REQUIRE(fd >= 0);
+        unsigned char fields[24];
+        for (size_t i = 0; i < 8; ++i)
+        {
+            fields[i] = static_cast<unsigned char>(pageSize >> (8 * i));
+            fields[8 + i] = static_cast<unsigned char>(count >> (8 * i));
+            fields[16 + i] = static_cast<unsigned char>(perPage >> (8 * i));
+        }
+        REQUIRE(pwrite(fd, fields, sizeof(fields), 20) == 24);
+        close(fd);
+    };
+    using WideTree = PagedTree<int, 8>;
+    forge(64, 9, 0);
+    CHECK_THROWS_AS(WideTree(path, 4096), std::runtime_error);
+    forge(uint64_t(1) << 60, 9, (uint64_t(1) << 60) / 80);
+    CHECK_THROWS_AS(WideTree(path, 4096), std::runtime_error);
+    forge(4096, 1000, 4096 / 80);
+    CHECK_THROWS_AS(WideTree(path, 4096), std::runtime_error);
+    forge(4096, 9, 4096 / 80);
+    CHECK(WideTree(path, 4096).size() == 9);
+
+    Tree<double, 3> empty;
+    write_paged_tree(empty, path);
+    PagedTree<double, 3> paged(path, 4096);
+    CHECK(paged.size() == 0);
+    CHECK(paged.begin() == paged.end());
+    CHECK(paged.myHeap() == paged.end_heap());
+    CHECK_THROWS_AS(paged.get_root(), std::logic_error);
+    std::remove(path.c_str());
+}
+
+//-----------------------//
+// Lazy loading //
+//-----------------------//
+
+TEST_CASE("LazyTree materialises children on first access") {
+    vector<int> values;
+    for (int i = 0; i < 40; ++i) values.push_back(i * i - 100);
+    Tree<int, 3> tree(values);
+    string path = temporary_path();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(tree, file);
+    std::fclose(file);
+
+    LazyTree<int, 3> lazy(path);
+    CHECK(lazy.size() == 40);
+    CHECK(lazy.loaded_size() == 1);
+    LazyNode<int>* root = lazy.get_root();
+    CHECK(root->get_value() == -100);
+    CHECK(!root->children_loaded());
+
+    CHECK(root->get_children().size() == 3);
+    CHECK(root->children_loaded());
+    CHECK(lazy.loaded_size() == 4);
+    LazyNode<int>* middle = root->get_children()[1];
+    CHECK(middle->get_value() == values[2]);
+    CHECK(middle->get_parent() == root);
+    CHECK(middle->get_children()[2]->get_value() == values[9]);
+    CHECK(lazy.loaded_size() == 7);
+
+    // Walking the whole tree loads every node once, in any order
+    CHECK(collect_values(lazy.begin_dfs_scan(), lazy.end_dfs_scan()) == collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()));
+    CHECK(lazy.loaded_size() == 40);
+    CHECK(collect_values(lazy.begin_bfs_scan(), lazy.end_bfs_scan()) == collect_values(tree.begin_bfs_scan(), tree.end_bfs_scan()));
+    CHECK(collect_values(lazy.myHeap(), lazy.end_heap()) == collect_values(tree.myHeap(), tree.end_heap()));
+    CHECK(lazy.loaded_size() == 40);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("LazyTree binary walks load only the nodes they reach") {
+    vector<int> values;
+    for (int i = 0; i < 63; ++i) values.push_back(i);
+    Tree<int> tree(values);
+    string path = temporary_path();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(tree, file);
+    std::fclose(file);
+    {
+        // Opening an in-order walk descends the left spine only
+        LazyTree<int> lazy(path);
+        auto it = lazy.begin_in_order();
+        CHECK(it->get_value() == tree.begin_in_order()->get_value());
+        CHECK(lazy.loaded_size() < 16);
+        CHECK(collect_values(it, lazy.end_in_order()) == collect_values(tree.begin_in_order(), tree.end_in_order()));
+        CHECK(lazy.loaded_size() == 63);
+    }
+
+    // A node with three children is rejected when the walk reaches it, without loading the rest of the tree
+    Tree<int, 3> wide(values);
+    file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(wide, file);
+    std::fclose(file);
+    LazyTree<int, 3> lazy(path);
+    CHECK_THROWS_AS(lazy.begin_in_order(), std::invalid_argument);
+    CHECK_THROWS_AS(lazy.begin_post_order(), std::invalid_argument);
+    CHECK(lazy.loaded_size() < 16);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("LazyTree rejects files it cannot load lazily") {
+    Tree<double> tree(vector<double>{1, 2, 3, 4});
+    string path = temporary_path();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    write_tree(tree, file);
+    std::fclose(file);
+    CHECK_THROWS_AS(LazyTree<double>{path}, std::runtime_error);
+
+    file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(tree, file);
+    std::fclose(file);
+    CHECK_THROWS_AS(LazyTree<int>{path}, std::runtime_error);
+    {
+        LazyTree<double> lazy(path);
+        CHECK(collect_values(lazy.begin_post_order(), lazy.end_post_order()) == collect_values(tree.begin_post_order(), tree.end_post_order()));
+        CHECK(collect_values(lazy.begin_in_order(), lazy.end_in_order()) == collect_values(tree.begin_in_order(), tree.end_in_order()));
+    }
+
+    Tree<double, 3> wide(vector<double>{1, 2, 3, 4});
+    file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(wide, file);
+    std::fclose(file);
+    CHECK_THROWS_AS(LazyTree<double>{path}, std::runtime_error);
+
+    Tree<double> empty;
+    file = std::fopen(path.c_str(), "wb");
+    write_frozen_tree(empty, file);
+    std::fclose(file);
+    LazyTree<double> lazy(path);
+    CHECK(lazy.get_root() == nullptr);
+    CHECK(lazy.begin() == lazy.end());
+    std::remove(path.c_str());
+}
+
+//-----------------------//
+// Text parsing //
+//-----------------------//
+
+TEST_CASE("parse_json_tree builds trees from nested JSON") {
+    Tree<int, 3> tree;
+    tree.enable_parent_links();
+    parse_json_tree(tree, string(R"({"value": 1, "name": {"skip": [1, "]", {}]}, "children": [
+        {"value": 2, "children": [{"value": -4}, {"value": 5, "children": []}]},
+        {"value": 3, "extra": null}
+    ]})"));
+    CHECK(collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()) == vector<int>{1, 2, -4, 5, 3});
+    CHECK(tree.get_parent(tree.root->get_children()[0]->get_children()[1]) == tree.root->get_children()[0]);
+
+    Tree<string> strings;
+    parse_json_tree(strings, string(R"({"value": "a\"b", "children": [{"value": "é\n"}, {"value": "😀"}]})"));
+    CHECK(strings.root->get_value() == "a\"b");
+    CHECK(strings.root->get_children()[0]->get_value() == "\xc3\xa9\n");
+    CHECK(strings.root->get_children()[1]->get_value() == "\xf0\x9f\x98\x80");
+
+    Tree<double> doubles;
+    std::FILE* file = std::tmpfile();
+    std::fputs("{\"value\": 2.5e3, \"children\": [{\"value\": -0.125}]}", file);
+    std::rewind(file);
+    parse_json_tree(doubles, file);
+    std::fclose(file);
+    CHECK(collect_values(doubles.begin_bfs_scan(), doubles.end_bfs_scan()) == vector<int>{2500, 0});
+    CHECK(doubles.root->get_children()[0]->get_value() == -0.125);
+
+    parse_json_tree(doubles, string(" null "));
+    CHECK(doubles.root == nullptr);
+}
+
+TEST_CASE("parse_json_tree enforces k and rejects malformed input with the line") {
+    Tree<int> tree;
+    tree.enable_zone_maps();
+    parse_json_tree(tree, string(R"({"value": 1, "children": [{"value": 7}, {"value": -3}]})"));
+    CHECK(tree.subtree_range(tree.root) == std::make_pair(-3, 7));
+
+    try
+    {
+        parse_json_tree(tree, string("{\"value\": 1, \"children\": [\n{\"value\": 2},\n{\"value\": 3},\n{\"value\": 4}]}"));
+        CHECK(false);
+    }
+    catch (const std::runtime_error& error)
+    {
+        CHECK(string(error.what()) == "parse error at line 4: a node has more than k children.");
+    }
+    CHECK(tree.root == nullptr);
+
+    CHECK_THROWS_AS(parse_json_tree(tree, string(R"({"children": [], "value": 1})")), std::runtime_error);
+    CHECK_THROWS_AS(parse_json_tree(tree, string(R"({"value": 1.5})")), std::runtime_error);
+    CHECK_THROWS_AS(parse_json_tree(tree, string(R"({"value": 1, "children": [{"value": 2},]})")), std::runtime_error);
+    CHECK_THROWS_AS(parse_json_tree(tree, string(R"({"value": 1} {"value": 2})")), std::runtime_error);
+    CHECK_THROWS_AS(parse_json_tree(tree, string(R"({"value": 1, "children": [{"value": 2})")), std::runtime_error);
+    CHECK_THROWS_AS(parse_json_tree(tree, string(R"({"other": 1})")), std::runtime_error);
+}
+
+TEST_CASE("parse_indented_tree follows the indentation") {
+    Tree<int, 3> tree;
+    parse_indented_tree(tree, string("1\n  2\n    4\n    5\n\n  3\n      6\n  7   \n"));
+    CHECK(collect_values(tree.begin_dfs_scan(), tree.end_dfs_scan()) == vector<int>{1, 2, 4, 5, 3, 6, 7});
+    CHECK(tree.root->get_children()[1]->get_children()[0]->get_value() == 6);
+
+    Tree<string> strings;
+    parse_indented_tree(strings, string("root node\n\tleft child\n\t\tgrandchild\n\tright child\r\n"));
+    CHECK(strings.root->get_value() == "root node");
+    CHECK(strings.root->get_children()[1]->get_value() == "right child");
+    CHECK(strings.root->get_children()[0]->get_children()[0]->get_value() == "grandchild");
+
+    try
+    {
+        parse_indented_tree(tree, string("1\n    2\n  3\n"));
+        CHECK(false);
+    }
+    catch (const std::runtime_error& error)
+    {
+        CHECK(string(error.what()) == "parse error at line 3: indentation matches no open level.");
+    }
+    CHECK_THROWS_AS(parse_indented_tree(tree, string("1\n 2\n 3\n 4\n 5\n")), std::runtime_error);
+    CHECK_THROWS_AS(parse_indented_tree(tree, string("1\n2\n")), std::runtime_error);
+    CHECK_THROWS_AS(parse_indented_tree(tree, string("  1\n")), std::runtime_error);
+    CHECK_THROWS_AS(parse_indented_tree(tree, string("1\n x\n")), std::runtime_error);
+    CHECK(tree.root == nullptr);
+    parse_indented_tree(tree, string("\n\n"));
+    CHECK(tree.root == nullptr);
+}
+
+//-----------------------//
+// Succinct trees //
+//-----------------------//
+
+TEST_CASE("SuccinctTree navigates like the pointer tree") {
+    // A ternary tree of long chains and bushy parts, so that searches cross many 512-bit blocks
+    size_t count = 3000;
+    vector<int> values(count);
+    vector<size_t> parents(count, Tree<int, 3>::NO_PARENT);
+    vector<size_t> childCounts(count, 0);
+    uint64_t seed = 12345;
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = static_cast<int>(i) * 7 - 500;
+        if (i == 0) continue;
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t parent = (seed >> 60) < 10 ? i - 1 : static_cast<size_t>((seed >> 20) % i);
+        while (childCounts[parent] == 3) parent = (parent + 1) % i;
+        parents[i] = parent;
+        ++childCounts[parent];
+    }
+    Tree<int, 3> tree;
+    tree.build_from_parents(values, parents);
+    SuccinctTree<int, 3> succinct(tree);
+    REQUIRE(succinct.size() == count);
+
+    // Walk both trees in pre-order side by side
+    vector<pair<Node<int>*, size_t>> stack{{tree.root, 0}};
+    vector<size_t> sizes;
+    size_t index = 0;
+    auto it = succinct.begin_pre_order();
+    while (!stack.empty())
+    {
+        auto [node, depth] = stack.back();
+        stack.pop_back();
+        REQUIRE(it != succinct.end_pre_order());
+        SuccinctNode<int, 3> handle = *it;
+        CHECK(handle.index() == index);
+        CHECK(succinct.node_at(index) == handle);
+        CHECK(handle.get_value() == node->get_value());
+        CHECK(handle.depth() == depth);
+        CHECK(handle.child_count() == node->get_children().size());
+        for (size_t c = 0; c < node->get_children().size(); ++c)
+        {
+            CHECK(handle.child(c).get_value() == node->get_children()[c]->get_value());
+            CHECK(handle.child(c).get_parent() == handle);
+        }
+        CHECK_THROWS_AS(handle.child(node->get_children().size()), std::out_of_range);
+
+        size_t subtree = 0;
+        vector<Node<int>*> pending{node};
+        while (!pending.empty())
+        {
+            Node<int>* next = pending.back();
+            pending.pop_back();
+            ++subtree;
+            for (Node<int>* child : next->get_children()) pending.push_back(child);
+        }
+        CHECK(handle.subtree_size() == subtree);
+
+        for (size_t c = node->get_children().size(); c > 0; --c) stack.push_back({node->get_children()[c - 1], depth + 1});
+        ++it;
+        ++index;
+    }
+    CHECK(it == succinct.end_pre_order());
+    CHECK(!succinct.get_root().get_parent());
+    CHECK(succinct.get_root().subtree_size() == count);
+    CHECK_THROWS_AS(succinct.node_at(count), std::out_of_range);
+    CHECK(succinct.topology_bytes() * 8 < count * 4);
+}
+
+TEST_CASE("SuccinctTree iterators follow the Tree orders") {
+    vector<int> values;
+    for (int i = 0; i < 700; ++i) values.push_back(i);
+    Tree<int> tree(values);
+    SuccinctTree<int> succinct(tree);
+
+    vector<int> expected, actual;
+    for (auto it = tree.begin_post_order(); it != tree.end_post_order(); ++it) expected.push_back(it->get_value());
+    for (auto it = succinct.begin_post_order(); it != succinct.end_post_order(); ++it) actual.push_back(it->get_value());
+    CHECK(actual == expected);
+
+    expected.clear();
+    actual.clear();
+    for (auto it = tree.begin_bfs_scan(); it != tree.end_bfs_scan(); ++it) expected.push_back(it->get_value());
+    for (const SuccinctNode<int>& node : succinct) actual.push_back(node.get_value());
+    CHECK(actual == expected);
+
+    expected.clear();
+    actual.clear();
+    for (auto it = tree.begin_dfs_scan(); it != tree.end_dfs_scan(); ++it) expected.push_back(it->get_value());
+    for (auto it = succinct.begin_dfs_scan(); it != succinct.end_dfs_scan(); ++it) actual.push_back(it->get_value());
+    CHECK(actual == expected);
+
+    Tree<int> empty;
+    SuccinctTree<int> none(empty);
+    CHECK(none.size() == 0);
+    CHECK(none.begin() == none.end());
+    CHECK(none.begin_post_order() == none.end_post_order());
+    CHECK_THROWS_AS(none.get_root(), std::logic_error);
+}
+
+//-----------------------//
+// Mutation journal //
+//-----------------------//
+
+TEST_CASE("TreeJournal replays committed mutations and drops a torn tail") {
+    string path = temporary_path();
+    Tree<int, 3> expected;
+    {
+        Tree<int, 3> tree;
+        TreeJournal<int, 3> journal(tree, path, 4);
+        CHECK(tree.root == nullptr);
+        journal.add_root(new Node<int>(1));
+        for (int i = 2; i <= 7; ++i) journal.add_sub_node(tree.root->get_children().empty() || i % 3 == 0 ? tree.root : tree.root->get_children()[0], new Node<int>(i));
+        Node<int>* ignored = new Node<int>(8);
+        journal.add_sub_node(tree.root->get_children()[0], ignored);     // The first child is full, nothing is logged
+        delete ignored;
+        journal.set_value(tree.root->get_children()[0], 20);
+        journal.remove_sub_node(tree.root, 1);
+        CHECK(journal.stats().records == 9);
+        CHECK(journal.stats().commits == 2);
+        CHECK(journal.pending_records() == 1);
+
+        Node<int>* extra = new Node<int>(30);
+        extra->add_child(new Node<int>(31));
+        journal.add_sub_node(tree.root->get_children()[0]->get_children()[0], extra);
+        CHECK(journal.pending_records() == 2);
+        journal.commit();
+        CHECK(journal.stats().commits == 3);
+
+        Tree<int, 3> stranger({5, 6});
+        CHECK_THROWS_AS(journal.set_value(stranger.root, 1), std::invalid_argument);
+        apply_patch(expected, diff_trees(expected, tree));
+    }
+
+    // A crash in the middle of a write leaves a partial record behind
+    std::FILE* file = std::fopen((path + ".journal").c_str(), "ab");
+    const unsigned char partial[] = {40, 0, 0, 0, 1, 2};
+    std::fwrite(partial, 1, sizeof(partial), file);
+    std::fclose(file);
+
+    Tree<int, 3> recovered;
+    {
+        TreeJournal<int, 3> journal(recovered, path);
+        CHECK(journal.stats().replayed == 10);
+        CHECK(diff_trees(expected, recovered).empty());
+        journal.set_value(recovered.root, 100);
+    }
+    Tree<int, 3> again;
+    TreeJournal<int, 3> journal(again, path);
+    CHECK(journal.stats().replayed == 11);
+    CHECK(again.root->get_value() == 100);
+    CHECK_THROWS_AS((TreeJournal<int, 3>(again, path, 0)), std::invalid_argument);
+    std::remove((path + ".journal").c_str());
+    std::remove(path.c_str());
+}
+
+TEST_CASE("TreeJournal rolls a failed commit back, so a retry writes the group once") {
+    string path = temporary_path();
+    {
+        Tree<int, 3> tree;
+        TreeJournal<int, 3> journal(tree, path, 100);
+        journal.add_root(new Node<int>(1));
+        journal.commit();
+        uint64_t committed = journal.journal_size();
+        for (int i = 0; i < 60; ++i) journal.set_value(tree.root, i);
+
+        // A file size limit just past the committed end makes the group write stop part way
+        struct rlimit limit;
+        REQUIRE(getrlimit(RLIMIT_FSIZE, &limit) == 0);
+        struct rlimit tight = limit;
+        tight.rlim_cur = static_cast<rlim_t>(committed + 16);
+        auto previous = std::signal(SIGXFSZ, SIG_IGN);
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &tight) == 0);
+        CHECK_THROWS_AS(journal.commit(), std::runtime_error);
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+        std::signal(SIGXFSZ, previous);
+
+        CHECK(journal.journal_size() == committed);
+        CHECK(journal.pending_records() == 60);
+        journal.commit();
+        CHECK(journal.pending_records() == 0);
+    }
+
+    Tree<int, 3> recovered;
+    TreeJournal<int, 3> journal(recovered, path);
+    CHECK(journal.stats().replayed == 61);
+    CHECK(recovered.root->get_value() == 59);
+    std::remove((path + ".journal").c_str());
+    std::remove(path.c_str());
+}
+
+TEST_CASE("TreeJournal mutates the tree before a failing commit, and compact() keeps its threshold") {
+    string path = temporary_path();
+    struct rlimit limit;
+    REQUIRE(getrlimit(RLIMIT_FSIZE, &limit) == 0);
+    auto failWrites = [&](uint64_t size) {
+        struct rlimit tight = limit;
+        tight.rlim_cur = static_cast<rlim_t>(size);
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &tight) == 0);
+    };
+    auto previous = std::signal(SIGXFSZ, SIG_IGN);
+    {
+        // Every record commits on its own, so set_value itself sees the failure
+        Tree<int, 3> tree;
+        TreeJournal<int, 3> journal(tree, path, 1);
+        journal.add_root(new Node<int>(1));
+        failWrites(journal.journal_size());
+        CHECK_THROWS_AS(journal.set_value(tree.root, 2), std::runtime_error);
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+        CHECK(tree.root->get_value() == 2);
+        CHECK(journal.pending_records() == 1);
+        journal.commit();
+    }
+    {
+        Tree<int, 3> recovered;
+        TreeJournal<int, 3> journal(recovered, path, 100, 200);
+        CHECK(journal.stats().replayed == 2);
+        CHECK(recovered.root->get_value() == 2);
+
+        // A compaction whose commit fails still compacts at the next commit past the threshold
+        for (int i = 0; i < 30; ++i) journal.set_value(recovered.root, i);
+        failWrites(journal.journal_size());
+        CHECK_THROWS_AS(journal.compact(), std::runtime_error);
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+        journal.commit();
+        CHECK(journal.stats().compactions == 1);
+        CHECK(journal.journal_size() <= 200);
+    }
+    std::signal(SIGXFSZ, previous);
+
+    Tree<int, 3> recovered;
+    TreeJournal<int, 3> journal(recovered, path);
+    CHECK(recovered.root->get_value() == 29);
+    std::remove((path + ".snapshot").c_str());
+    std::remove((path + ".journal").c_str());
+    std::remove(path.c_str());
+}
+
+TEST_CASE("TreeJournal compacts into snapshots and ignores stale journals") {
+    string path = temporary_path();
+    vector<unsigned char> oldJournal;
+    {
+        Tree<string> tree;
+        TreeJournal<string> journal(tree, path, 1, 200);
+        journal.add_root(new Node<string>("root"));
+        journal.add_sub_node(tree.root, new Node<string>("left"));
+        journal.add_sub_node(tree.root, new Node<string>("right"));
+        CHECK(journal.get_generation() == 0);
+
+        std::FILE* file = std::fopen((path + ".journal").c_str(), "rb");
+        int c;
+        while ((c = std::fgetc(file)) != EOF) oldJournal.push_back(static_cast<unsigned char>(c));
+        std::fclose(file);
+
+        for (size_t i = 0; i < 20; ++i) journal.set_value(tree.root->get_children()[i % 2], "value " + std::to_string(i));
+        CHECK(journal.stats().compactions > 0);
+        CHECK(journal.journal_size() <= 200);
+        journal.compact();
+        CHECK(journal.get_generation() == journal.stats().compactions);
+    }
+
+    // Put back a journal from before the compactions, as a crash between the two renames would leave
+    std::FILE* file = std::fopen((path + ".journal").c_str(), "wb");
+    std::fwrite(oldJournal.data(), 1, oldJournal.size(), file);
+    std::fclose(file);
+
+    Tree<string> recovered;
+    TreeJournal<string> journal(recovered, path);
+    CHECK(journal.stats().replayed == 0);
+    REQUIRE(recovered.root != nullptr);
+    CHECK(recovered.root->get_value() == "root");
+    CHECK(recovered.root->get_children()[0]->get_value() == "value 18");
+    CHECK(recovered.root->get_children()[1]->get_value() == "value 19");
+
+    Tree<int> other;
+    CHECK_THROWS_AS((TreeJournal<int>(other, path)), std::runtime_error);
+    std::remove((path + ".snapshot").c_str());
+    std::remove((path + ".journal").c_str());
+    std::remove(path.c_str());
+}
+
+//-----------------------//
+// Sharded loading //
+//-----------------------//
+
+TEST_CASE("Sharded files round trip through read_tree and read_sharded_tree") {
+    uint64_t seed = 50;
+    auto rng = [&]() { return seed = seed * 6364136223846793005ULL + 1442695040888963407ULL, seed >> 33; };
+    size_t count = 5000;
+    vector<int> values(count);
+    vector<size_t> parents(count, Tree<int, 3>::NO_PARENT);
+    vector<size_t> childCounts(count, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = static_cast<int>(rng() % 1000) - 500;
+        if (i == 0) continue;
+        size_t parent = rng() % 4 == 0 ? i - 1 : static_cast<size_t>(rng() % i);
+        while (childCounts[parent] == 3) parent = (parent + 1) % i;
+        parents[i] = parent;
+        ++childCounts[parent];
+    }
+    Tree<int, 3> tree(values, parents);
+
+    string path = temporary_path();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    write_sharded_tree(tree, file, 100);
+    std::fclose(file);
+
+    // Every shard but the root one holds at least 100 and at most about 3 * 100 nodes
+    unsigned char prefix[32];
+    file = std::fopen(path.c_str(), "rb");
+    REQUIRE(std::fread(prefix, 1, sizeof(prefix), file) == sizeof(prefix));
+    std::fclose(file);
+    uint64_t shards = load_uint(prefix + 24, 8);
+    CHECK(shards >= count / 300);
+    CHECK(shards <= count / 100 + 1);
+
+    for (size_t threads : {size_t(1), size_t(4)})
+    {
+        Tree<int, 3> loaded({1, 2, 3});
+        read_sharded_tree(loaded, path, threads);
+        CHECK(diff_trees(tree, loaded).empty());
+    }
+    Tree<int, 3> sequential;
+    file = std::fopen(path.c_str(), "rb");
+    read_tree(sequential, file);
+    std::fclose(file);
+    CHECK(diff_trees(tree, sequential).empty());
+
+    // Other formats go through read_tree; an empty tree makes a file without shards
+    Tree<string> words(vector<string>{"a", "b", "c", "d"});
+    file = std::fopen(path.c_str(), "wb");
+    write_sharded_tree(words, file, 1);
+    std::fclose(file);
+    Tree<string> wordsBack;
+    read_sharded_tree(wordsBack, path);
+    CHECK(diff_trees(words, wordsBack).empty());
+
+    file = std::fopen(path.c_str(), "wb");
+    write_tree(words, file);
+    std::fclose(file);
+    Tree<string> plainBack;
+    read_sharded_tree(plainBack, path, 2);
+    CHECK(diff_trees(words, plainBack).empty());
+
+    Tree<string> empty;
+    file = std::fopen(path.c_str(), "wb");
+    CHECK_THROWS_AS(write_sharded_tree(words, file, 0), std::invalid_argument);
+    write_sharded_tree(empty, file);
+    std::fclose(file);
+    read_sharded_tree(plainBack, path);
+    CHECK(plainBack.root == nullptr);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("read_sharded_tree rejects corrupt shards and keeps the tree") {
+    vector<double> values;
+    for (int i = 0; i < 200; ++i) values.push_back(i * 0.5);
+    Tree<double> tree(values);
+    string path = temporary_path();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    write_sharded_tree(tree, file, 16);
+    long size = std::ftell(file);
+    std::fclose(file);
+
+    // Flip a byte near the end, inside the last shard payload
+    file = std::fopen(path.c_str(), "r+b");
+    std::fseek(file, size - 3, SEEK_SET);
+    int byte = std::fgetc(file);
+    std::fseek(file, size - 3, SEEK_SET);
+    std::fputc(byte ^ 0x40, file);
+    std::fclose(file);
+
+    Tree<double> kept({7.5});
+    CHECK_THROWS_AS(read_sharded_tree(kept, path, 3), std::runtime_error);
+    CHECK(kept.root->get_value() == 7.5);
+    file = std::fopen(path.c_str(), "rb");
+    CHECK_THROWS_AS(read_tree(kept, file), std::runtime_error);
+    std::fclose(file);
+    CHECK(kept.root->get_value() == 7.5);
+    Tree<int> wrongType;
+    CHECK_THROWS_AS(read_sharded_tree(wrongType, path), std::runtime_error);
+
+    // A last shard claiming nearly 4 GiB is rejected against the file size, before any worker allocates it
+    file = std::fopen(path.c_str(), "r+b");
+    unsigned char count[8];
+    std::fseek(file, TreeFileHeader::SIZE, SEEK_SET);
+    REQUIRE(std::fread(count, 1, 8, file) == 8);
+    uint64_t shardCount = 0;
+    for (int i = 7; i >= 0; --i) shardCount = shardCount << 8 | count[i];
+    REQUIRE(shardCount > 1);
+    const unsigned char huge[4] = {0xF0, 0xFF, 0xFF, 0xFF};
+    std::fseek(file, static_cast<long>(TreeFileHeader::SIZE + 8 + (shardCount - 1) * ShardEntry::SIZE + 8), SEEK_SET);
+    std::fwrite(huge, 1, 4, file);
+    std::fclose(file);
+    string message = "read_tree: shard " + std::to_string(shardCount - 1) + " ends past the end of the file.";
+    CHECK_THROWS_WITH_AS(read_sharded_tree(kept, path, 3), message.c_str(), std::runtime_error);
+    CHECK(kept.root->get_value() == 7.5);
+    file = std::fopen(path.c_str(), "rb");
+    CHECK_THROWS_AS(read_tree(kept, file), std::runtime_error);
+    std::fclose(file);
+    CHECK(kept.root->get_value() == 7.5);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,676 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef TEXTPARSER_HPP
+#define TEXTPARSER_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <charconv>
+#include <stdexcept>
+#include <type_traits>
+
+namespace ori {
+
+/**
+ * @class TextInput
+ * @brief Buffered character source over a FILE* or an in-memory string, tracking the line number for error messages.
+ */
+class TextInput {
+
+    private:
+
+        std::FILE* file = nullptr;      // The stream, or nullptr for in-memory text
+        std::vector<char> buffer;       // Chunk of the stream being parsed
+        const char* position;           // Next character
+        const char* last;               // End of the available characters
+        size_t lineNumber = 1;          // Line of the next character
+
+
+        /**
+         * @brief Reads the next chunk of the stream.
+         * @return False at the end of the input.
+         */
+        bool refill()
+        {
+            if (!this->file) return false;
+            size_t n = std::fread(this->buffer.data(), 1, this->buffer.size(), this->file);
+            if (n == 0 && std::ferror(this->file)) throw std::runtime_error("TextInput: read failed.");
+            this->position = this->buffer.data();
+            this->last = this->position + n;
+            return n > 0;
+        }
+
+    public:
+
+        /**
+         * @brief Constructs a source reading a stream in chunks.
+         * @param stream The stream, left open.
+         * @param bufferSize Bytes per chunk.
+         */
+        explicit TextInput(std::FILE* stream, size_t bufferSize = 1 << 20) : file(stream), buffer(bufferSize)
+        {
+            this->position = this->last = this->buffer.data();
+        }
+
+
+        /**
+         * @brief Constructs a source over text in memory, which must outlive the source.
+         */
+        explicit TextInput(const std::string& text) : position(text.data()), last(text.data() + text.size()) {}
+
+
+        /**
+         * @brief Retrieves the next character without consuming it, or EOF at the end of the input.
+         */
+        int peek()
+        {
+            if (this->position == this->last && !this->refill()) return EOF;
+            return static_cast<unsigned char>(*this->position);
+        }
+
+
+        /**
+         * @brief Consumes and retrieves the next character, or EOF at the end of the input.
+         */
+        int get()
+        {
+            int c = this->peek();
+            if (c == EOF) return EOF;
+            ++this->position;
+            if (c == '\n') ++this->lineNumber;
+            return c;
+        }
+
+
+        /**
+         * @brief Consumes the character just returned by peek(), which must not be EOF or a line break.
+         */
+        void skip()
+        {
+            ++this->position;
+        }
+
+
+        /**
+         * @brief Consumes spaces, tabs and line breaks.
+         */
+        void skip_space()
+        {
+            while (this->position != this->last || this->refill())
+            {
+                for (; this->position != this->last; ++this->position)
+                {
+                    char c = *this->position;
+                    if (c == '\n') ++this->lineNumber;
+                    else if (c != ' ' && c != '\t' && c != '\r') return;
+                }
+            }
+        }
+
+
+        /**
+         * @brief Moves characters to `out` up to (not including) a stop character, a line break or the end of the input.
+         * Scanning the buffer directly keeps the per-character cost of long strings and lines low.
+         * @param out Receives the characters.
+         * @param stop, otherStop The characters that end the run besides the line break.
+         */
+        void append_until(std::string& out, char stop, char otherStop)
+        {
+            while (this->position != this->last || this->refill())
+            {
+                const char* start = this->position;
+                while (this->position != this->last && *this->position != '\n' && *this->position != stop && *this->position != otherStop)
+                {
+                    ++this->position;
+                }
+                out.append(start, this->position);
+                if (this->position != this->last) return;
+            }
+        }
+
+
+        /**
+         * @brief Retrieves the line of the next character.
+         */
+        size_t line() const
+        {
+            return this->lineNumber;
+        }
+
+
+        /**
+         * @brief Throws a parse error that names the current line.
+         * @throws std::runtime_error always.
+         */
+        [[noreturn]] void fail(const std::string& what) const
+        {
+            throw std::runtime_error("parse error at line " + std::to_string(this->lineNumber) + ": " + what + ".");
+        }
+    };
+
+
+    /**
+     * @brief Converts the text of one value (a JSON number or an indented-text line) to T.
+     * Numbers use std::from_chars, so the whole token must be a valid int or double; strings are taken as they are.
+     * @throws std::runtime_error (through `in`) if the token is not a valid value.
+     */
+    template <typename T>
+    T parse_text_value(const char* first, const char* last, const TextInput& in)
+    {
+        if constexpr (std::is_same_v<T, std::string>)
+        {
+            return std::string(first, last);
+        }
+        else
+        {
+            static_assert(std::is_arithmetic_v<T>, "Text trees hold numbers or strings.");
+            T value{};
+            auto [end, error] = std::from_chars(first, last, value);
+            if (error != std::errc() || end != last || first == last)
+            {
+                in.fail("invalid value '" + std::string(first, last) + "'");
+            }
+            return value;
+        }
+    }
+
+
+/**
+ * @class TreeBuildHandler
+ * @brief SAX handler that builds a Tree from begin_node / end_node events, enforcing the k fanout limit as nodes arrive.
+ *
+ * Nodes are linked to their parents directly as they are parsed, and the finished tree is handed to
+ * Tree::add_root when the root closes. The tree's indexes and summaries are therefore built once, in
+ * bulk, rather than updated for every node, and nothing but the path of open nodes is kept on the side.
+ */
+template <typename T, int k>
+class TreeBuildHandler {
+
+    private:
+
+        Tree<T, k>& tree;               // The tree being built
+        Node<T>* root = nullptr;        // The root being built, until it is handed to the tree
+        std::vector<Node<T>*> path;     // The open nodes, from the root
+
+    public:
+
+        /**
+         * @brief Constructs a handler that builds into a tree, which is cleared first.
+         */
+        explicit TreeBuildHandler(Tree<T, k>& target) : tree(target)
+        {
+            this->tree.clear();
+        }
+
+
+        TreeBuildHandler(const TreeBuildHandler&) = delete;
+        TreeBuildHandler& operator=(const TreeBuildHandler&) = delete;
+
+
+        /**
+         * @brief Destructor that frees the nodes of a tree whose root was never closed (parsing failed).
+         */
+        ~TreeBuildHandler()
+        {
+            std::vector<Node<T>*> pending;
+            if (this->root) pending.push_back(this->root);
+            while (!pending.empty())
+            {
+                Node<T>* current = pending.back();
+                pending.pop_back();
+                pending.insert(pending.end(), current->get_children().begin(), current->get_children().end());
+                delete current;
+            }
+        }
+
+
+        /**
+         * @brief Opens a node: the root if no node is open, otherwise the next child of the innermost open node.
+         * @return False if that node already has k children (the node is not added).
+         */
+        bool begin_node(const T& value)
+        {
+            if (!this->path.empty() && this->path.back()->get_children().size() >= static_cast<size_t>(k))
+            {
+                return false;
+            }
+            Node<T>* node = new Node<T>(value);
+            if (this->path.empty())
+            {
+                this->root = node;
+            }
+            else
+            {
+                this->path.back()->add_child(node);
+            }
+            this->path.push_back(node);
+            return true;
+        }
+
+
+        /**
+         * @brief Closes the innermost open node; closing the root hands the finished tree to Tree::add_root.
+         */
+        void end_node()
+        {
+            this->path.pop_back();
+            if (this->path.empty())
+            {
+                Node<T>* done = this->root;
+                this->root = nullptr;
+                this->tree.add_root(done);
+            }
+        }
+    };
+
+
+    /**
+     * @brief Streams a JSON tree to a SAX handler.
+     *
+     * A node is an object {"value": V, "children": [node, ...]}; "children" is optional and must
+     * follow "value", so every node is reported as soon as its value is read. Other members are
+     * skipped. The document is a single node or null (an empty tree). V is a JSON number for
+     * arithmetic T and a JSON string for std::string. The parser is iterative and keeps only the
+     * stack of open nodes, so its memory follows the depth of the tree, not the size of the input.
+     *
+     * @param in The input.
+     * @param handler Receives begin_node(value), which returns false to reject the node, and end_node().
+     * @throws std::runtime_error on malformed input or a rejected node, naming the line.
+     */
+    template <typename T, typename Handler>
+    void parse_json(TextInput& in, Handler& handler)
+    {
+        auto expect = [&](char wanted) {
+            in.skip_space();
+            if (in.peek() != wanted) in.fail(std::string("expected '") + wanted + "'");
+            in.skip();
+        };
+
+        auto readString = [&](std::string& out) {
+            expect('"');
+            out.clear();
+            while (true)
+            {
+                in.append_until(out, '"', '\\');
+                int c = in.get();
+                if (c == EOF) in.fail("unterminated string");
+                if (c == '"') return;
+                if (c != '\\')
+                {
+                    out.push_back(static_cast<char>(c));      // A raw line break
+                    continue;
+                }
+                c = in.get();
+                switch (c)
+                {
+                    case '"': case '\\': case '/': out.push_back(static_cast<char>(c)); break;
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'n': out.push_back('\n'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u':
+                    {
+                        auto hex4 = [&]() {
+                            uint32_t code = 0;
+                            for (int i = 0; i < 4; ++i)
+                            {
+                                int h = in.get();
+                                uint32_t digit;
+                                if (h >= '0' && h <= '9') digit = static_cast<uint32_t>(h - '0');
+                                else if (h >= 'a' && h <= 'f') digit = static_cast<uint32_t>(h - 'a' + 10);
+                                else if (h >= 'A' && h <= 'F') digit = static_cast<uint32_t>(h - 'A' + 10);
+                                else in.fail("invalid \\u escape");
+                                code = code * 16 + digit;
+                            }
+                            return code;
+                        };
+                        uint32_t code = hex4();
+                        if (code >= 0xD800 && code < 0xDC00)
+                        {
+                            if (in.get() != '\\' || in.get() != 'u') in.fail("unpaired surrogate");
+                            uint32_t low = hex4();
+                            if (low < 0xDC00 || low >= 0xE000) in.fail("unpaired surrogate");
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        // UTF-8 encoding of the code point
+                        if (code < 0x80)
+                        {
+                            out.push_back(static_cast<char>(code));
+                        }
+                        else if (code < 0x800)
+                        {
+                            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        }
+                        else if (code < 0x10000)
+                        {
+                            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        }
+                        else
+                        {
+                            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                        }
+                        break;
+                    }
+                    default: in.fail("invalid escape");
+                }
+            }
+        };
+
+        // A scalar token: a number or one of the literals true, false, null
+        char token[64];
+        auto readToken = [&]() {
+            in.skip_space();
+            size_t length = 0;
+            while (true)
+            {
+                int c = in.peek();
+                bool part = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E';
+                if (!part) break;
+                if (length == sizeof(token)) in.fail("token too long");
+                token[length++] = static_cast<char>(c);
+                in.skip();
+            }
+            if (length == 0) in.fail("expected a value");
+            return length;
+        };
+
+        // Skips a member value of any type; only brackets outside strings change the depth
+        std::string scratch;
+        auto skipValue = [&]() {
+            size_t depth = 0;
+            do
+            {
+                in.skip_space();
+                int c = in.peek();
+                if (c == '"')
+                {
+                    readString(scratch);
+                }
+                else if (c == '{' || c == '[')
+                {
+                    in.get();
+                    ++depth;
+                }
+                else if (c == '}' || c == ']')
+                {
+                    if (depth == 0) in.fail("unexpected bracket");
+                    in.get();
+                    --depth;
+                }
+                else if (c == ',' || c == ':')
+                {
+                    if (depth == 0) in.fail("expected a value");
+                    in.get();
+                }
+                else
+                {
+                    readToken();
+                }
+            }
+            while (depth > 0);
+        };
+
+        struct Frame
+        {
+            bool valueSeen = false;     // begin_node was reported
+            bool inChildren = false;    // Inside the "children" array
+            bool childrenSeen = false;  // The "children" member was read
+            size_t members = 0;         // Members read so far
+            size_t children = 0;        // Children closed so far in the array
+        };
+        std::vector<Frame> frames;
+
+        in.skip_space();
+        if (in.peek() == 'n')
+        {
+            size_t length = readToken();
+            if (std::string(token, length) != "null") in.fail("expected a node or null");
+        }
+        else
+        {
+            expect('{');
+            frames.emplace_back();
+        }
+
+        std::string key;
+        while (!frames.empty())
+        {
+            Frame& frame = frames.back();
+            in.skip_space();
+            if (frame.inChildren)
+            {
+                if (in.peek() == ']')
+                {
+                    in.get();
+                    frame.inChildren = false;
+                    continue;
+                }
+                if (frame.children > 0) expect(',');
+                expect('{');
+                frames.emplace_back();
+                continue;
+            }
+
+            if (in.peek() == '}')
+            {
+                in.get();
+                if (!frame.valueSeen) in.fail("node without \"value\"");
+                handler.end_node();
+                frames.pop_back();
+                if (!frames.empty()) ++frames.back().children;
+                continue;
+            }
+            if (frame.members > 0) expect(',');
+            readString(key);
+            expect(':');
+            ++frame.members;
+
+            if (key == "value")
+            {
+                if (frame.valueSeen) in.fail("duplicate \"value\"");
+                in.skip_space();
+                T value;
+                if constexpr (std::is_same_v<T, std::string>)
+                {
+                    readString(value);
+                }
+                else
+                {
+                    size_t length = readToken();
+                    value = parse_text_value<T>(token, token + length, in);
+                }
+                if (!handler.begin_node(value)) in.fail("a node has more than k children");
+                frame.valueSeen = true;
+            }
+            else if (key == "children")
+            {
+                if (!frame.valueSeen) in.fail("\"children\" before \"value\"");
+                if (frame.childrenSeen) in.fail("duplicate \"children\"");
+                expect('[');
+                frame.inChildren = true;
+                frame.childrenSeen = true;
+            }
+            else
+            {
+                skipValue();
+            }
+        }
+
+        in.skip_space();
+        if (in.peek() != EOF) in.fail("trailing characters after the tree");
+    }
+
+
+    /**
+     * @brief Streams an indented-text tree to a SAX handler.
+     *
+     * Every non-blank line holds one value; its indentation (spaces or tabs, counted as characters)
+     * places it: deeper than the previous line makes it a child, equal makes it a sibling, and
+     * shallower closes nodes until a line of the same indentation is found. The first line is the
+     * root and must not be indented. Values are the rest of the line without trailing spaces, parsed
+     * as for JSON numbers or taken as they are for std::string.
+     *
+     * @param in The input.
+     * @param handler Receives begin_node(value), which returns false to reject the node, and end_node().
+     * @throws std::runtime_error on inconsistent indentation, several roots, an invalid value or a rejected node, naming the line.
+     */
+    template <typename T, typename Handler>
+    void parse_indented(TextInput& in, Handler& handler)
+    {
+        std::vector<size_t> indents;    // Indentation of the open nodes, from the root
+        bool rootSeen = false;
+        std::string line;
+
+        while (in.peek() != EOF)
+        {
+            size_t indent = 0;
+            while (in.peek() == ' ' || in.peek() == '\t')
+            {
+                in.get();
+                ++indent;
+            }
+            line.clear();
+            in.append_until(line, '\n', '\n');
+            size_t end = line.find_last_not_of(" \t\r");
+            if (end == std::string::npos)
+            {
+                in.get();       // Blank line
+                continue;
+            }
+
+            bool closed = false;
+            while (!indents.empty() && indents.back() > indent)
+            {
+                handler.end_node();
+                indents.pop_back();
+                closed = true;
+            }
+            if (!indents.empty() && indents.back() == indent)
+            {
+                handler.end_node();
+                indents.pop_back();
+            }
+            else if (closed)
+            {
+                in.fail("indentation matches no open level");
+            }
+            if (indents.empty())
+            {
+                if (rootSeen) in.fail("more than one root");
+                if (indent != 0) in.fail("the root must not be indented");
+                rootSeen = true;
+            }
+
+            T value = parse_text_value<T>(line.data(), line.data() + end + 1, in);
+            if (!handler.begin_node(value)) in.fail("a node has more than k children");
+            indents.push_back(indent);
+            in.get();
+        }
+
+        for (size_t i = indents.size(); i > 0; --i)
+        {
+            handler.end_node();
+        }
+    }
+
+
+    /**
+     * @brief Builds a tree from JSON (see parse_json), streaming the input.
+     * @param tree The destination; it is cleared first, and cleared again if parsing fails.
+     * @param in The input.
+     * @throws std::runtime_error on malformed input or a node with more than k children.
+     */
+    template <typename T, int k>
+    void parse_json_tree(Tree<T, k>& tree, TextInput& in)
+    {
+        TreeBuildHandler<T, k> handler(tree);
+        try
+        {
+            parse_json<T>(in, handler);
+        }
+        catch (...)
+        {
+            tree.clear();
+            throw;
+        }
+    }
+
+
+    /**
+     * @brief Builds a tree from a JSON stream (see parse_json_tree above).
+     */
+    template <typename T, int k>
+    void parse_json_tree(Tree<T, k>& tree, std::FILE* file)
+    {
+        TextInput in(file);
+        parse_json_tree(tree, in);
+    }
+
+
+    /**
+     * @brief Builds a tree from JSON text in memory (see parse_json_tree above).
+     */
+    template <typename T, int k>
+    void parse_json_tree(Tree<T, k>& tree, const std::string& text)
+    {
+        TextInput in(text);
+        parse_json_tree(tree, in);
+    }
+
+
+    /**
+     * @brief Builds a tree from indented text (see parse_indented), streaming the input.
+     * @param tree The destination; it is cleared first, and cleared again if parsing fails.
+     * @param in The input.
+     * @throws std::runtime_error on malformed input or a node with more than k children.
+     */
+    template <typename T, int k>
+    void parse_indented_tree(Tree<T, k>& tree, TextInput& in)
+    {
+        TreeBuildHandler<T, k> handler(tree);
+        try
+        {
+            parse_indented<T>(in, handler);
+        }
+        catch (...)
+        {
+            tree.clear();
+            throw;
+        }
+    }
+
+
+    /**
+     * @brief Builds a tree from an indented-text stream (see parse_indented_tree above).
+     */
+    template <typename T, int k>
+    void parse_indented_tree(Tree<T, k>& tree, std::FILE* file)
+    {
+        TextInput in(file);
+        parse_indented_tree(tree, in);
+    }
+
+
+    /**
+     * @brief Builds a tree from indented text in memory (see parse_indented_tree above).
+     */
+    template <typename T, int k>
+    void parse_indented_tree(Tree<T, k>& tree, const std::string& text)
+    {
+        TextInput in(text);
+        parse_indented_tree(tree, in);
+    }
+}
+
+#endif
@@ -7,8 +7,20 @@
 #include <iomanip>
 #include <sstream>
 #include <cmath>
+#include <memory>
+#include <algorithm>
+#include <queue>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <unordered_map>
+#include <future>
+#include <thread>
+#include <exception>
 #include <SFML/Graphics.hpp>
 #include "node.hpp"
+#include "hashing.hpp"
 #include "complex.hpp"
 #include "pre_order_iterator.hpp"
 #include "post_order_iterator.hpp"
@@ -16,6 +28,8 @@
 #include "bfs_iterator.hpp"
 #include "dfs_iterator.hpp"
 #include "heap_iterator.hpp"
+#include "value_index.hpp"
+#include "sorted_index.hpp"
 
 namespace ori {
 
@@ -33,74 +47,1486 @@ class Tree {
 
         Node<T>* root = nullptr;         // Pointer to the root node of the tree
 
+        static constexpr size_t NO_PARENT = static_cast<size_t>(-1);     // Parent index of the root in build_from_parents
+
+    private:
+
+        unsigned long version = 0;       // Mutation counter, bumped on every structural change of the tree
+        std::unique_ptr<ValueIndex<T>> valueIndex;      // Optional value-to-node index, maintained on insertion
+        std::unique_ptr<SortedIndex<T>> sortedIndex;    // Optional ordered index over the values, maintained on insertion
+        std::unique_ptr<std::unordered_map<const Node<T>*, Node<T>*>> parents;       // Parent of every non-root node, kept while needed (see syncParentLinks)
+        bool parentLinks = false;                                                    // Whether the parent links were enabled explicitly
+        std::unique_ptr<std::unordered_map<const Node<T>*, std::pair<T, T>>> zones;  // [min, max] range of every subtree, kept while the zone maps are enabled
+        std::unique_ptr<std::unordered_map<const Node<T>*, std::vector<uint64_t>>> blooms;   // Bloom filter of every subtree, kept while the filters are enabled
+        size_t bloomWords = 0;                          // Size of the per-subtree Bloom filters in 64-bit words
+        size_t bloomHashes = 0;                         // Number of bit positions set per value
+        std::unique_ptr<std::unordered_map<const Node<T>*, uint64_t>> hashes;      // Merkle hash of every subtree, kept while Merkle hashing is enabled
+        std::vector<std::pair<Node<T>*, size_t>> blocks;    // Node arrays allocated by the bulk builders, with their lengths, sorted by address
+
+
+        /**
+         * @brief Collects the nodes of a subtree in pre-order.
+         * Walking the result backwards visits every child before its parent, which the bottom-up passes rely on.
+         * @param node The root of the subtree.
+         * @return The nodes of the subtree.
+         */
+        std::vector<Node<T>*> subtreeNodes(Node<T>* node) const
+        {
+            std::vector<Node<T>*> order;
+            for (auto it = DFSIterator<T>(node); it != DFSIterator<T>(nullptr); ++it)
+            {
+                order.push_back(&*it);
+            }
+            return order;
+        }
+
+
+        /**
+         * @brief Retrieves the parent of a node from the parent links.
+         * @return The parent, or nullptr for the root.
+         */
+        Node<T>* parentOf(const Node<T>* node) const
+        {
+            auto found = this->parents->find(node);
+            return found == this->parents->end() ? nullptr : found->second;
+        }
+
+
+        /**
+         * @brief Records the parent links of a subtree, if they are kept.
+         * @param parent The node the subtree hangs from, or nullptr when the subtree is the whole tree.
+         * @param node The root of the subtree.
+         */
+        void linkSubtree(Node<T>* parent, Node<T>* node)
+        {
+            if (!this->parents || !node) return;
+
+            std::vector<Node<T>*> order = this->subtreeNodes(node);
+            this->parents->reserve(this->parents->size() + order.size());
+            if (parent) (*this->parents)[node] = parent;
+            for (Node<T>* current : order)
+            {
+                for (Node<T>* child : current->get_children())
+                {
+                    (*this->parents)[child] = current;
+                }
+            }
+        }
+
+
+        /**
+         * @brief Creates or drops the parent links so that they exist exactly while something needs them:
+         * enable_parent_links(), or a per-subtree summary that is propagated towards the root.
+         */
+        void syncParentLinks()
+        {
+            bool needed = this->parentLinks || this->zones || this->blooms || this->hashes;
+            if (needed && !this->parents)
+            {
+                this->parents = std::make_unique<std::unordered_map<const Node<T>*, Node<T>*>>();
+                this->linkSubtree(nullptr, this->root);
+            }
+            else if (!needed)
+            {
+                this->parents.reset();
+            }
+        }
+
+
+        /**
+         * @brief Drops the removed nodes from the parent links and the per-subtree summaries.
+         * @param removed The nodes of a detached subtree.
+         */
+        void forgetNodes(const std::vector<Node<T>*>& removed)
+        {
+            for (const Node<T>* node : removed)
+            {
+                if (this->parents) this->parents->erase(node);
+                if (this->zones) this->zones->erase(node);
+                if (this->blooms) this->blooms->erase(node);
+                if (this->hashes) this->hashes->erase(node);
+            }
+        }
+
+
+        /**
+         * @brief Computes the zone maps of a whole subtree bottom-up.
+         * The zone map code is compiled only for value types with operator<; other types cannot enable it.
+         * @param node The root of the subtree.
+         */
+        void computeZones(Node<T>* node)
+        {
+            if constexpr (is_ordered_v<T>)
+            {
+                // Walk the subtree backwards so children are done before their parent
+                std::vector<Node<T>*> order = this->subtreeNodes(node);
+                this->zones->reserve(this->zones->size() + order.size());
+                for (auto it = order.rbegin(); it != order.rend(); ++it)
+                {
+                    this->updateZone(*it);
+                }
+            }
+        }
+
+
+        /**
+         * @brief Recomputes the zone map of one node from its value and its children's zone maps.
+         */
+        void updateZone(Node<T>* node)
+        {
+            if constexpr (is_ordered_v<T>)
+            {
+                const T* min = &node->get_value();
+                const T* max = min;
+                for (Node<T>* child : node->get_children())
+                {
+                    const std::pair<T, T>& zone = this->zones->at(child);
+                    if (zone.first < *min) min = &zone.first;
+                    if (*max < zone.second) max = &zone.second;
+                }
+                this->zones->insert_or_assign(node, std::pair<T, T>(*min, *max));
+            }
+        }
+
+
+        /**
+         * @brief Widens the zone maps from a node up to the root after a subtree with the given range was attached.
+         * Stops as soon as an ancestor's range already covers the new one.
+         * @param node The node where the subtree was attached.
+         * @param range The smallest and largest value of the attached subtree.
+         */
+        void widenZones(Node<T>* node, const std::pair<T, T>& range)
+        {
+            if constexpr (is_ordered_v<T>)
+            {
+                for (; node; node = this->parentOf(node))
+                {
+                    std::pair<T, T>& zone = this->zones->at(node);
+                    bool lower = range.first < zone.first;
+                    bool higher = zone.second < range.second;
+                    if (!lower && !higher) break;
+                    if (lower) zone.first = range.first;
+                    if (higher) zone.second = range.second;
+                }
+            }
+        }
+
+
+        /**
+         * @brief Calls `visit` with each Bloom filter bit position of a value (double hashing over one mixed hash).
+         * The Bloom filter code is compiled only for hashable value types; other types cannot enable it.
+         */
+        template <typename Visit>
+        void bloomPositions(const T& value, Visit visit) const
+        {
+            if constexpr (is_hashable_v<T>)
+            {
+                uint64_t h = mix_hash(static_cast<uint64_t>(std::hash<T>()(value)));
+                uint64_t step = (h >> 32) | 1;
+                uint64_t bits = 64 * static_cast<uint64_t>(this->bloomWords);
+                for (size_t i = 0; i < this->bloomHashes; ++i, h += step)
+                {
+                    visit(static_cast<size_t>(h % bits));
+                }
+            }
+        }
+
+
+        /**
+         * @brief Checks whether a node's Bloom filter may contain a value.
+         */
+        bool bloomMayContain(const Node<T>* node, const T& value) const
+        {
+            bool possible = true;
+            const std::vector<uint64_t>& words = this->blooms->at(node);
+            this->bloomPositions(value, [&](size_t bit) { possible = possible && (words[bit / 64] >> (bit % 64) & 1); });
+            return possible;
+        }
+
+
+        /**
+         * @brief Builds the Bloom filters of a whole subtree bottom-up.
+         * @param node The root of the subtree.
+         */
+        void computeBlooms(Node<T>* node)
+        {
+            std::vector<Node<T>*> order = this->subtreeNodes(node);
+            this->blooms->reserve(this->blooms->size() + order.size());
+            for (auto it = order.rbegin(); it != order.rend(); ++it)
+            {
+                this->updateBloom(*it);
+            }
+        }
+
+
+        /**
+         * @brief Rebuilds the Bloom filter of one node from its value and its children's filters.
+         */
+        void updateBloom(Node<T>* node)
+        {
+            std::vector<uint64_t>& words = (*this->blooms)[node];
+            words.assign(this->bloomWords, 0);
+            this->bloomPositions(node->get_value(), [&](size_t bit) { words[bit / 64] |= uint64_t(1) << (bit % 64); });
+            for (Node<T>* child : node->get_children())
+            {
+                const std::vector<uint64_t>& childWords = this->blooms->at(child);
+                for (size_t w = 0; w < this->bloomWords; ++w)
+                {
+                    words[w] |= childWords[w];
+                }
+            }
+        }
+
+
+        /**
+         * @brief Merges a Bloom filter into a node and its ancestors, stopping once an ancestor already holds all its bits.
+         * @param node The node where the subtree was attached.
+         * @param words The Bloom filter of the attached subtree.
+         */
+        void mergeBlooms(Node<T>* node, const std::vector<uint64_t>& words)
+        {
+            for (; node; node = this->parentOf(node))
+            {
+                bool changed = false;
+                std::vector<uint64_t>& target = this->blooms->at(node);
+                for (size_t w = 0; w < this->bloomWords; ++w)
+                {
+                    changed = changed || (words[w] & ~target[w]) != 0;
+                    target[w] |= words[w];
+                }
+                if (!changed) break;
+            }
+        }
+
+
+        /**
+         * @brief Computes the Merkle hash of a node from its value and the hashes of its children, in order.
+         * The Merkle code is compiled only for hashable value types; other types cannot enable it.
+         */
+        uint64_t merkleOf(const Node<T>* node) const
+        {
+            uint64_t h = 0;
+            if constexpr (is_hashable_v<T>)
+            {
+                h = hash_combine(mix_hash(static_cast<uint64_t>(std::hash<T>()(node->get_value()))), node->get_children().size());
+                for (const Node<T>* child : node->get_children())
+                {
+                    h = hash_combine(h, this->hashes->at(child));
+                }
+            }
+            return h;
+        }
+
+
+        /**
+         * @brief Computes the Merkle hashes of a whole subtree bottom-up.
+         * @param node The root of the subtree.
+         */
+        void computeMerkle(Node<T>* node)
+        {
+            std::vector<Node<T>*> order = this->subtreeNodes(node);
+            this->hashes->reserve(this->hashes->size() + order.size());
+            for (auto it = order.rbegin(); it != order.rend(); ++it)
+            {
+                (*this->hashes)[*it] = this->merkleOf(*it);
+            }
+        }
+
+
+        /**
+         * @brief Recomputes the Merkle hashes on the path from a node up to the root.
+         * @param node The lowest node whose subtree changed.
+         */
+        void refreshMerklePath(Node<T>* node)
+        {
+            for (; node; node = this->parentOf(node))
+            {
+                this->hashes->at(node) = this->merkleOf(node);
+            }
+        }
+
+
+        /**
+         * @brief Recomputes every enabled per-subtree summary (zone map, Bloom filter, Merkle hash) from a node up to the root.
+         * Used after a value change or a removal, where the summaries may shrink and cannot simply be widened.
+         * @param node The lowest node whose subtree changed.
+         */
+        void refreshPath(Node<T>* node)
+        {
+            if (!this->zones && !this->blooms && !this->hashes) return;
+
+            for (; node; node = this->parentOf(node))
+            {
+                if (this->zones) this->updateZone(node);
+                if (this->blooms) this->updateBloom(node);
+                if (this->hashes) this->hashes->at(node) = this->merkleOf(node);
+            }
+        }
+
+
+        /**
+         * @brief Compares two subtrees node by node (values and shape).
+         */
+        static bool sameStructure(const Node<T>* a, const Node<T>* b)
+        {
+            std::vector<std::pair<const Node<T>*, const Node<T>*>> pending{{a, b}};
+            while (!pending.empty())
+            {
+                auto [x, y] = pending.back();
+                pending.pop_back();
+                if (x->get_children().size() != y->get_children().size() || !(x->get_value() == y->get_value()))
+                {
+                    return false;
+                }
+                for (size_t i = 0; i < x->get_children().size(); ++i)
+                {
+                    pending.push_back({x->get_children()[i], y->get_children()[i]});
+                }
+            }
+            return true;
+        }
+
+
+        /**
+         * @brief Breadth-first search for a value from a node, skipping subtrees whose Bloom filter rules the value out.
+         * @param start The root of the searched subtree.
+         * @param value The value to look for.
+         * @param firstOnly Whether to stop at the first match.
+         * @return The matching nodes in BFS order.
+         */
+        std::vector<Node<T>*> searchPruned(Node<T>* start, const T& value, bool firstOnly) const
+        {
+            std::vector<Node<T>*> matches;
+            std::queue<Node<T>*> pending;
+            if (start) pending.push(start);
+            while (!pending.empty())
+            {
+                Node<T>* node = pending.front();
+                pending.pop();
+                if (!this->bloomMayContain(node, value)) continue;
+
+                if (node->get_value() == value)
+                {
+                    matches.push_back(node);
+                    if (firstOnly) break;
+                }
+                for (Node<T>* child : node->get_children())
+                {
+                    pending.push(child);
+                }
+            }
+            return matches;
+        }
+
+
+        /**
+         * @brief Returns the first bulk-allocated block that starts after the given address.
+         */
+        typename std::vector<std::pair<Node<T>*, size_t>>::const_iterator blockAfter(const Node<T>* node) const
+        {
+            return std::upper_bound(this->blocks.begin(), this->blocks.end(), node,
+                                    [](const Node<T>* target, const std::pair<Node<T>*, size_t>& block) {
+                                        return std::less<const Node<T>*>()(target, block.first);
+                                    });
+        }
+
+
+        /**
+         * @brief Checks whether a node lives in one of the bulk-allocated blocks.
+         * The blocks are disjoint and sorted by address, so only the last one starting at or before the node can hold it.
+         */
+        bool inBlock(const Node<T>* node) const
+        {
+            auto next = this->blockAfter(node);
+            if (next == this->blocks.begin()) return false;
+            const auto& [first, count] = *(next - 1);
+            return std::less<const Node<T>*>()(node, first + count);
+        }
+
+
+        /**
+         * @brief Frees a single node, unless it belongs to a bulk-allocated block.
+         */
+        void freeNode(Node<T>* node)
+        {
+            if (!this->inBlock(node)) delete node;
+        }
+
+
+        /**
+         * @brief Destroys the nodes of every bulk-allocated block and returns the memory.
+         * Must run after destroyTree, which frees the separately allocated nodes that may hang below block nodes.
+         */
+        void releaseBlocks()
+        {
+            std::allocator<Node<T>> allocator;
+            for (auto& [first, count] : this->blocks)
+            {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    first[i].~Node<T>();
+                }
+                allocator.deallocate(first, count);
+            }
+            this->blocks.clear();
+        }
+
+
+        /**
+         * @brief Runs work(0) .. work(tasks - 1), each on its own thread except work(0), which runs on the calling one.
+         * The work must not throw.
+         */
+        template <typename Work>
+        static void runTasks(size_t tasks, Work work)
+        {
+            std::vector<std::future<void>> running;
+            for (size_t t = 1; t < tasks; ++t)
+            {
+                running.push_back(std::async(std::launch::async, work, t));
+            }
+            work(0);
+            for (std::future<void>& task : running)
+            {
+                task.get();
+            }
+        }
+
+
+        /**
+         * @brief Replaces the whole tree with the nodes of a freshly allocated block, one node per value.
+         * The nodes are constructed in place in a single allocation, split into chunks over up to `threads`
+         * threads; the caller links them and calls adoptBlock.
+         * @param values The node values, in block order.
+         * @param count The number of values.
+         * @param threads The maximum number of threads constructing the nodes.
+         * @return The first node of the block.
+         */
+        Node<T>* allocateBlock(const T* values, size_t count, size_t threads = 1)
+        {
+            this->clear();
+
+            std::allocator<Node<T>> allocator;
+            Node<T>* first = allocator.allocate(count);
+
+            // Each chunk cleans up after itself if a constructor throws, and reports the exception
+            size_t chunks = std::max<size_t>(1, std::min(threads, count / 65536));
+            std::vector<std::exception_ptr> errors(chunks);
+            runTasks(chunks, [&](size_t c) {
+                size_t lo = count * c / chunks;
+                size_t i = lo;
+                try
+                {
+                    for (size_t hi = count * (c + 1) / chunks; i < hi; ++i)
+                    {
+                        new (first + i) Node<T>(values[i]);
+                    }
+                }
+                catch (...)
+                {
+                    while (i > lo) first[--i].~Node<T>();
+                    errors[c] = std::current_exception();
+                }
+            });
+
+            for (size_t c = 0; c < chunks; ++c)
+            {
+                if (!errors[c]) continue;
+                for (size_t other = 0; other < chunks; ++other)
+                {
+                    if (errors[other]) continue;
+                    for (size_t i = count * other / chunks; i < count * (other + 1) / chunks; ++i) first[i].~Node<T>();
+                }
+                allocator.deallocate(first, count);
+                std::rethrow_exception(errors[c]);
+            }
+            this->blocks.insert(this->blockAfter(first), {first, count});
+            return first;
+        }
+
+
+        /**
+         * @brief Links the block nodes of a sorted range into a height-optimal subtree and returns its root.
+         *
+         * The range minus its root is split into k contiguous parts whose sizes differ by at most one, and
+         * each non-empty part becomes a child subtree. The root sits after the first k/2 parts, so for k = 2
+         * an in-order walk reproduces the range. Parts are handed to other threads while `parallelLevels` > 0.
+         * @param nodes The block, where node i holds input value i.
+         * @param first The first position of the range.
+         * @param last One past the last position of the range (the range is not empty).
+         * @param parallelLevels How many more levels of the recursion may spawn threads.
+         * @return The root of the subtree.
+         */
+        static Node<T>* linkBalanced(Node<T>* nodes, size_t first, size_t last, size_t parallelLevels)
+        {
+            const size_t K = static_cast<size_t>(k);
+            size_t rest = last - first - 1;
+            std::vector<std::pair<size_t, size_t>> parts;
+            size_t position = first;
+            for (size_t i = 0; i < K; ++i)
+            {
+                if (i == K / 2) ++position;      // Skip the root
+                size_t size = rest / K + (i < rest % K ? 1 : 0);
+                if (size > 0) parts.push_back({position, position + size});
+                position += size;
+            }
+            size_t rootPosition = first + (rest / K) * (K / 2) + std::min(rest % K, K / 2);
+            Node<T>* node = &nodes[rootPosition];
+
+            std::vector<Node<T>*> children(parts.size());
+            if (parallelLevels > 0 && rest >= 65536)
+            {
+                runTasks(parts.size(), [&](size_t t) {
+                    children[t] = linkBalanced(nodes, parts[t].first, parts[t].second, parallelLevels - 1);
+                });
+            }
+            else
+            {
+                for (size_t t = 0; t < parts.size(); ++t)
+                {
+                    children[t] = linkBalanced(nodes, parts[t].first, parts[t].second, 0);
+                }
+            }
+
+            node->get_children().reserve(children.size());
+            for (Node<T>* child : children)
+            {
+                node->add_child(child);
+            }
+            return node;
+        }
+
+
+        /**
+         * @brief Makes a linked block the new tree and rebuilds the enabled indexes and per-subtree summaries in one pass each.
+         * @param node The root of the block.
+         */
+        void adoptBlock(Node<T>* node)
+        {
+            this->root = node;
+            ++this->version;
+            this->indexSubtree(node);
+            this->linkSubtree(nullptr, node);
+            if (this->zones) this->computeZones(node);
+            if (this->blooms) this->computeBlooms(node);
+            if (this->hashes) this->computeMerkle(node);
+        }
+
+
+        /**
+         * @brief Adds a node and all its descendants to the enabled secondary indexes.
+         * @param node The root of the subtree to index.
+         */
+        void indexSubtree(Node<T>* node)
+        {
+            if (!this->valueIndex && !this->sortedIndex) return;
+
+            for (auto it = DFSIterator<T>(node); it != DFSIterator<T>(nullptr); ++it)
+            {
+                this->indexValue(&*it);
+                if (this->sortedIndex) this->sortedIndex->insert(&*it);
+            }
+        }
+
+
+        /**
+         * @brief Adds a node to the value-to-node hash index, if enabled.
+         * The index code is compiled only for hashable value types; other types cannot enable it.
+         */
+        void indexValue(Node<T>* node)
+        {
+            if constexpr (is_hashable_v<T>)
+            {
+                if (this->valueIndex) this->valueIndex->insert(node);
+            }
+        }
+
+
+        /**
+         * @brief Removes a node from the value-to-node hash index, if enabled.
+         */
+        void unindexValue(const Node<T>* node)
+        {
+            if constexpr (is_hashable_v<T>)
+            {
+                if (this->valueIndex) this->valueIndex->erase(node);
+            }
+        }
+
+    public:
+
+        /**
+         * @brief Constructor that initializes an empty tree.
+         */
+        Tree() {}
+
+
+        /**
+         * @brief Constructor that builds a complete k-ary tree from a level-order array (see build_from_level_order).
+         * @param levelOrder The node values in level order.
+         */
+        explicit Tree(const std::vector<T>& levelOrder)
+        {
+            this->build_from_level_order(levelOrder);
+        }
+
+
+        /**
+         * @brief Constructor that builds a tree from a parent array (see build_from_parents).
+         * @param values The node values.
+         * @param parents The parent index of every node, Tree::NO_PARENT for the root.
+         */
+        Tree(const std::vector<T>& values, const std::vector<size_t>& parents)
+        {
+            this->build_from_parents(values, parents);
+        }
+
+
+        /**
+         * @brief Destructor that cleans up by destroying the tree.
+         */
+        ~Tree() 
+        {
+            destroyTree(root);
+            releaseBlocks();
+        }
+
+        
+        /**
+         * @brief Adds a root node to the tree.
+         * @param node A pointer to the node that will become the new root.
+         * 
+         * If there is already a root, it gets deleted and replaced by the new node.
+         */
+        void add_root(Node<T>* node) 
+        {
+            // Clean up existing root if it exists
+            if (root) 
+            {  
+                this->freeNode(root);
+            }
+            root = node;  // Directly use the passed node as the root
+            ++this->version;
+
+            // The whole tree changed, so the parent links, summaries and secondary indexes start over from the new root
+            if (this->parents) this->parents->clear();
+            this->linkSubtree(nullptr, node);
+            if (this->zones)
+            {
+                this->zones->clear();
+                this->computeZones(node);
+            }
+            if (this->blooms)
+            {
+                this->blooms->clear();
+                this->computeBlooms(node);
+            }
+            if (this->hashes)
+            {
+                this->hashes->clear();
+                this->computeMerkle(node);
+            }
+            if (this->valueIndex) this->valueIndex->clear();
+            if (this->sortedIndex) this->sortedIndex->clear();
+            this->indexSubtree(node);
+        }
+
+
+        /**
+         * @brief Adds a child node to a specified parent node.
+         * @param parent Pointer to the parent node.
+         * @param child Pointer to the child node to be added.
+         *
+         * The function adds the child node to the parent's list of children if the maximum number hasn't been reached.
+         * A null child is ignored.
+         */
+        void add_sub_node(Node<T>* parent, Node<T>* child) 
+        {
+            if (parent && child && parent->get_children().size() < k) 
+            {
+                    parent->add_child(child);
+                    ++this->version;
+
+                    this->indexSubtree(child);
+                    this->linkSubtree(parent, child);
+                    if (this->zones)
+                    {
+                        this->computeZones(child);
+                        this->widenZones(parent, this->zones->at(child));
+                    }
+                    if (this->blooms)
+                    {
+                        this->computeBlooms(child);
+                        this->mergeBlooms(parent, this->blooms->at(child));
+                    }
+                    if (this->hashes)
+                    {
+                        this->computeMerkle(child);
+                        this->refreshMerklePath(parent);
+                    }
+            }
+        }
+
+
+        /**
+         * @brief Replaces the value of a node and keeps the indexes and per-subtree summaries in sync.
+         * @param node The node to update, which must belong to this tree.
+         * @param value The new value.
+         */
+        void set_value(Node<T>* node, const T& value)
+        {
+            if (!node) return;
+
+            // The hash index locates entries by value, so they must be removed before the value changes
+            this->unindexValue(node);
+            node->set_value(value);
+            this->indexValue(node);
+            if (this->sortedIndex) this->sortedIndex->update(node);
+
+            ++this->version;
+            this->refreshPath(node);
+        }
+
+
+        /**
+         * @brief Removes a child of a node together with its whole subtree, freeing the removed nodes.
+         * @param parent Pointer to the parent node.
+         * @param index The position of the child among the parent's children.
+         * @throws std::out_of_range if the parent has no child at that position.
+         */
+        void remove_sub_node(Node<T>* parent, size_t index)
+        {
+            if (!parent || index >= parent->get_children().size())
+            {
+                throw std::out_of_range("remove_sub_node: the parent has no child at this position.");
+            }
+
+            std::vector<Node<T>*>& children = parent->get_children();
+            Node<T>* child = children[index];
+            children.erase(children.begin() + static_cast<std::ptrdiff_t>(index));
+            ++this->version;
+
+            if (this->valueIndex || this->sortedIndex || this->parents)
+            {
+                std::vector<Node<T>*> removed = this->subtreeNodes(child);
+                for (Node<T>* node : removed) this->unindexValue(node);
+                if (this->sortedIndex) this->sortedIndex->erase_all(removed);
+                this->forgetNodes(removed);
+            }
+            this->destroyTree(child);
+            this->refreshPath(parent);
+        }
+
+
+        /**
+         * @brief Removes and frees every node of the tree, leaving it empty.
+         */
+        void clear()
+        {
+            this->destroyTree(this->root);
+            this->releaseBlocks();
+            this->root = nullptr;
+            ++this->version;
+            if (this->valueIndex) this->valueIndex->clear();
+            if (this->sortedIndex) this->sortedIndex->clear();
+            if (this->parents) this->parents->clear();
+            if (this->zones) this->zones->clear();
+            if (this->blooms) this->blooms->clear();
+            if (this->hashes) this->hashes->clear();
+        }
+
+
+        /**
+         * @brief Replaces the tree with a complete k-ary tree read from a level-order array, in O(n).
+         * The children of values[i] are values[k*i + 1] to values[k*i + k]. All nodes are allocated in one block.
+         * @param values The node values in level order (an empty array leaves the tree empty).
+         */
+        void build_from_level_order(const std::vector<T>& values)
+        {
+            Node<T>* nodes = this->allocateBlock(values.data(), values.size());
+            if (values.empty()) return;
+
+            size_t count = values.size();
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t first = static_cast<size_t>(k) * i + 1;
+                if (first >= count) break;
+                size_t last = std::min(first + static_cast<size_t>(k), count);
+                nodes[i].get_children().reserve(last - first);
+                for (size_t c = first; c < last; ++c)
+                {
+                    nodes[i].add_child(&nodes[c]);
+                }
+            }
+            this->adoptBlock(nodes);
+        }
+
+
+        /**
+         * @brief Replaces the tree with the tree described by a parent array, in O(n).
+         * The children of every node are grouped with a counting sort by parent index and keep their input
+         * order. All nodes are allocated in one block.
+         * @param values The node values.
+         * @param parents parents[i] is the index of the parent of node i, or Tree::NO_PARENT for the root.
+         * @throws std::invalid_argument if the arrays differ in length, there is not exactly one root, a parent
+         *         index is out of range, a node would get more than k children, or some node is not reachable from the root.
+         */
+        void build_from_parents(const std::vector<T>& values, const std::vector<size_t>& parents)
+        {
+            size_t count = values.size();
+            if (parents.size() != count)
+            {
+                throw std::invalid_argument("build_from_parents: values and parents differ in length.");
+            }
+
+            // Counting sort by parent: offsets[p] .. offsets[p + 1] will hold the children of p
+            std::vector<size_t> offsets(count + 1, 0);
+            size_t rootIndex = NO_PARENT;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (parents[i] == NO_PARENT)
+                {
+                    if (rootIndex != NO_PARENT) throw std::invalid_argument("build_from_parents: more than one root.");
+                    rootIndex = i;
+                }
+                else if (parents[i] >= count)
+                {
+                    throw std::invalid_argument("build_from_parents: parent index out of range.");
+                }
+                else if (++offsets[parents[i] + 1] > static_cast<size_t>(k))
+                {
+                    throw std::invalid_argument("build_from_parents: a node has more than k children.");
+                }
+            }
+            if (count > 0 && rootIndex == NO_PARENT)
+            {
+                throw std::invalid_argument("build_from_parents: no root.");
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                offsets[i + 1] += offsets[i];
+            }
+            std::vector<size_t> order(count > 0 ? count - 1 : 0);
+            std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (i != rootIndex) order[fill[parents[i]]++] = i;
+            }
+
+            // With one root and n - 1 parent links, the array is a tree exactly when every node is reachable from the root
+            size_t reached = 0;
+            std::vector<size_t> pending;
+            if (count > 0) pending.push_back(rootIndex);
+            while (!pending.empty() && reached <= count)
+            {
+                size_t node = pending.back();
+                pending.pop_back();
+                ++reached;
+                pending.insert(pending.end(), order.begin() + static_cast<std::ptrdiff_t>(offsets[node]), order.begin() + static_cast<std::ptrdiff_t>(offsets[node + 1]));
+            }
+            if (reached != count)
+            {
+                throw std::invalid_argument("build_from_parents: the parent links contain a cycle.");
+            }
+
+            Node<T>* nodes = this->allocateBlock(values.data(), values.size());
+            if (count == 0) return;
+            for (size_t p = 0; p < count; ++p)
+            {
+                nodes[p].get_children().reserve(offsets[p + 1] - offsets[p]);
+                for (size_t j = offsets[p]; j < offsets[p + 1]; ++j)
+                {
+                    nodes[p].add_child(&nodes[order[j]]);
+                }
+            }
+            this->adoptBlock(&nodes[rootIndex]);
+        }
+
+
+        /**
+         * @brief Replaces the tree with a height-optimal tree holding the values of a sorted array, in O(n).
+         *
+         * Every subtree covers a contiguous range of the input: its root is the value after the first k/2 of
+         * k near-equal parts of the rest of the range, and the parts become its children. For k = 2 an
+         * in-order walk therefore reproduces the input. The input order is kept as given and is not checked.
+         * Node construction and linking are spread over up to `threads` threads; all nodes are allocated in one block.
+         * @param values Pointer to the first value.
+         * @param count The number of values.
+         * @param threads The maximum number of threads (0 uses the number of hardware threads).
+         */
+        void build_balanced(const T* values, size_t count, size_t threads = 0)
+        {
+            if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+            Node<T>* nodes = this->allocateBlock(values, count, threads);
+            if (count == 0) return;
+
+            // Spawn threads for the top levels only, until there are about as many subtrees as threads
+            size_t parallelLevels = 0;
+            for (size_t reach = 1; reach < threads; reach *= static_cast<size_t>(k))
+            {
+                ++parallelLevels;
+            }
+            this->adoptBlock(linkBalanced(nodes, 0, count, parallelLevels));
+        }
+
+
+        /**
+         * @brief Replaces the tree with a height-optimal tree holding the values of a sorted vector (see above).
+         * @param values The values, in the order the tree should reproduce.
+         * @param threads The maximum number of threads (0 uses the number of hardware threads).
+         */
+        void build_balanced(const std::vector<T>& values, size_t threads = 0)
+        {
+            this->build_balanced(values.data(), values.size(), threads);
+        }
+
+
         /**
-         * @brief Constructor that initializes an empty tree.
+         * @brief Enables the value-to-node hash index.
+         * The index is built from the current tree and then kept up to date by add_root and add_sub_node.
+         * Requires std::hash for T; trees of other value types simply do without the index.
          */
-        Tree() {}
+        void enable_value_index()
+        {
+            static_assert(is_hashable_v<T>, "The value index needs std::hash for the value type.");
+            this->valueIndex = std::make_unique<ValueIndex<T>>();
+            for (auto it = this->begin_dfs_scan(); it != this->end_dfs_scan(); ++it)
+            {
+                this->valueIndex->insert(&*it);
+            }
+        }
 
 
         /**
-         * @brief Destructor that cleans up by destroying the tree.
+         * @brief Disables the value-to-node hash index and frees it.
          */
-        ~Tree() 
+        void disable_value_index()
         {
-            destroyTree(root);
+            this->valueIndex.reset();
         }
 
-        
+
         /**
-         * @brief Adds a root node to the tree.
-         * @param node A pointer to the node that will become the new root.
-         * 
-         * If there is already a root, it gets deleted and replaced by the new node.
+         * @brief Checks whether the value-to-node hash index is enabled.
          */
-        void add_root(Node<T>* node) 
+        bool has_value_index() const
         {
-            // Clean up existing root if it exists
-            if (root) 
-            {  
-                delete root;
+            return this->valueIndex != nullptr;
+        }
+
+
+        /**
+         * @brief Enables the ordered value index.
+         * The index is built from the current tree and then kept up to date by add_root and add_sub_node.
+         * It sorts with operator<, which must be a strict weak ordering, so it is not available for Complex.
+         */
+        void enable_sorted_index()
+        {
+            static_assert(is_strictly_ordered_v<T>, "The sorted index needs an operator< that is a strict weak ordering.");
+            this->sortedIndex = std::make_unique<SortedIndex<T>>();
+            for (auto it = this->begin_dfs_scan(); it != this->end_dfs_scan(); ++it)
+            {
+                this->sortedIndex->insert(&*it);
             }
-            root = node;  // Directly use the passed node as the root
         }
 
 
         /**
-         * @brief Adds a child node to a specified parent node.
-         * @param parent Pointer to the parent node.
-         * @param child Pointer to the child node to be added.
-         *
-         * The function adds the child node to the parent's list of children if the maximum number hasn't been reached.
+         * @brief Disables the ordered value index and frees it.
          */
-        void add_sub_node(Node<T>* parent, Node<T>* child) 
+        void disable_sorted_index()
+        {
+            this->sortedIndex.reset();
+        }
+
+
+        /**
+         * @brief Checks whether the ordered value index is enabled.
+         */
+        bool has_sorted_index() const
+        {
+            return this->sortedIndex != nullptr;
+        }
+
+
+        /**
+         * @brief Enables the per-subtree zone maps: the tree caches the smallest and largest value of every subtree.
+         * The ranges are computed bottom-up now and maintained by add_root and add_sub_node afterwards,
+         * so searches can skip subtrees whose range cannot match. They live in a table owned by the
+         * tree, so nodes pay nothing for them while they are disabled. Requires operator< for T.
+         */
+        void enable_zone_maps()
+        {
+            static_assert(is_ordered_v<T>, "Zone maps need operator< for the value type.");
+            this->zones = std::make_unique<std::unordered_map<const Node<T>*, std::pair<T, T>>>();
+            this->syncParentLinks();
+            this->computeZones(this->root);
+        }
+
+
+        /**
+         * @brief Disables the zone maps and frees the cached ranges.
+         */
+        void disable_zone_maps()
+        {
+            this->zones.reset();
+            this->syncParentLinks();
+        }
+
+
+        /**
+         * @brief Checks whether the zone maps are enabled.
+         */
+        bool has_zone_maps() const
+        {
+            return this->zones != nullptr;
+        }
+
+
+        /**
+         * @brief Retrieves the cached value range of a subtree.
+         * @param node A node of the tree.
+         * @return The smallest and the largest value in the subtree of the node.
+         * @throws std::logic_error if the zone maps are disabled.
+         * @throws std::out_of_range if the node is not in the tree.
+         */
+        const std::pair<T, T>& subtree_range(const Node<T>* node) const
+        {
+            if (!this->zones)
+            {
+                throw std::logic_error("Zone maps are not enabled for this tree.");
+            }
+            return this->zones->at(node);
+        }
+
+
+        /**
+         * @brief Enables the parent links: the tree records the parent of every node, so get_parent() answers in O(1).
+         * The links live in a table owned by the tree and are maintained by every mutation. They are
+         * also kept while zone maps, Bloom filters or Merkle hashes are enabled, which propagate
+         * changes towards the root.
+         */
+        void enable_parent_links()
+        {
+            this->parentLinks = true;
+            this->syncParentLinks();
+        }
+
+
+        /**
+         * @brief Disables the parent links, freeing them unless a per-subtree summary still needs them.
+         */
+        void disable_parent_links()
+        {
+            this->parentLinks = false;
+            this->syncParentLinks();
+        }
+
+
+        /**
+         * @brief Checks whether the parent links are available (see enable_parent_links).
+         */
+        bool has_parent_links() const
+        {
+            return this->parents != nullptr;
+        }
+
+
+        /**
+         * @brief Retrieves the parent of a node.
+         * @param node A node of the tree.
+         * @return The parent, or nullptr for the root (and for nodes that are not in the tree).
+         * @throws std::logic_error if the parent links are not available.
+         */
+        Node<T>* get_parent(const Node<T>* node) const
+        {
+            if (!this->parents)
+            {
+                throw std::logic_error("Parent links are not enabled for this tree.");
+            }
+            return this->parentOf(node);
+        }
+
+
+        /**
+         * @brief Enables the per-subtree Bloom filters: the tree holds a filter of the values in every subtree.
+         * The filters are built bottom-up now and maintained by add_root and add_sub_node afterwards,
+         * so containment queries and searches skip subtrees that definitely lack a value. They live
+         * in a table owned by the tree, so nodes pay nothing for them while they are disabled.
+         * Requires std::hash for T.
+         * @param bits Filter size in bits per node (rounded up to a multiple of 64).
+         * @param hashes Number of bit positions set per value.
+         */
+        void enable_bloom_filters(size_t bits = 256, size_t hashes = 3)
+        {
+            static_assert(is_hashable_v<T>, "Bloom filters need std::hash for the value type.");
+            if (bits == 0 || hashes == 0)
+            {
+                throw std::invalid_argument("Bloom filters need at least one bit and one hash function.");
+            }
+            this->bloomWords = (bits + 63) / 64;
+            this->bloomHashes = hashes;
+            this->blooms = std::make_unique<std::unordered_map<const Node<T>*, std::vector<uint64_t>>>();
+            this->syncParentLinks();
+            this->computeBlooms(this->root);
+        }
+
+
+        /**
+         * @brief Disables the Bloom filters and frees them.
+         */
+        void disable_bloom_filters()
+        {
+            this->blooms.reset();
+            this->syncParentLinks();
+        }
+
+
+        /**
+         * @brief Checks whether the Bloom filters are enabled.
+         */
+        bool has_bloom_filters() const
+        {
+            return this->blooms != nullptr;
+        }
+
+
+        /**
+         * @brief Checks in O(1) whether the subtree of a node may contain a value.
+         * @param node The root of the subtree.
+         * @param value The value to test.
+         * @return False if the value is definitely absent; true if it may be present (always true when the filters are disabled).
+         */
+        bool subtree_may_contain(const Node<T>* node, const T& value) const
+        {
+            return !this->blooms || this->bloomMayContain(node, value);
+        }
+
+
+        /**
+         * @brief Checks whether the subtree of a node contains a value.
+         * When the Bloom filters are enabled, subtrees that definitely lack the value are skipped.
+         * @param node The root of the subtree.
+         * @param value The value to look for.
+         * @return True if a node of the subtree holds the value.
+         */
+        bool subtree_contains(Node<T>* node, const T& value) const
+        {
+            if (this->blooms)
+            {
+                return !this->searchPruned(node, value, true).empty();
+            }
+            for (auto it = DFSIterator<T>(node); it != DFSIterator<T>(nullptr); ++it)
+            {
+                if (it->get_value() == value) return true;
+            }
+            return false;
+        }
+
+
+        /**
+         * @brief Enables Merkle hashing: the tree holds, for every node, a hash of its value, its shape and its children's hashes.
+         * The hashes are computed bottom-up now; afterwards add_sub_node recomputes only the attached subtree
+         * and the path from it to the root. They live in a table owned by the tree, so nodes pay nothing
+         * for them while hashing is disabled. Requires std::hash for T.
+         */
+        void enable_merkle_hashing()
+        {
+            static_assert(is_hashable_v<T>, "Merkle hashing needs std::hash for the value type.");
+            this->hashes = std::make_unique<std::unordered_map<const Node<T>*, uint64_t>>();
+            this->syncParentLinks();
+            this->computeMerkle(this->root);
+        }
+
+
+        /**
+         * @brief Disables Merkle hashing and frees the hashes.
+         */
+        void disable_merkle_hashing()
+        {
+            this->hashes.reset();
+            this->syncParentLinks();
+        }
+
+
+        /**
+         * @brief Checks whether Merkle hashing is enabled.
+         */
+        bool has_merkle_hashing() const
+        {
+            return this->hashes != nullptr;
+        }
+
+
+        /**
+         * @brief Retrieves the Merkle hash of a subtree.
+         * @param node A node of the tree.
+         * @return The hash of the values and the shape of the subtree of the node.
+         * @throws std::logic_error if Merkle hashing is disabled.
+         * @throws std::out_of_range if the node is not in the tree.
+         */
+        uint64_t subtree_hash(const Node<T>* node) const
+        {
+            if (!this->hashes)
+            {
+                throw std::logic_error("Merkle hashing is not enabled for this tree.");
+            }
+            return this->hashes->at(node);
+        }
+
+
+        /**
+         * @brief Retrieves the Merkle hash of the whole tree.
+         * Two trees with Merkle hashing enabled hold the same values in the same shape exactly when
+         * their root hashes match (up to 64-bit hash collisions), so snapshots are compared in O(1).
+         * @return The hash of the root, or 0 for an empty tree.
+         * @throws std::logic_error if Merkle hashing is disabled.
+         */
+        uint64_t root_hash() const
+        {
+            if (!this->hashes)
+            {
+                throw std::logic_error("Merkle hashing is not enabled for this tree.");
+            }
+            return this->root ? this->hashes->at(this->root) : 0;
+        }
+
+
+        /**
+         * @brief Checks whether two subtrees of this tree hold the same values in the same shape.
+         * @param a The root of the first subtree.
+         * @param b The root of the second subtree.
+         * @param verify When false the answer is the O(1) hash comparison; when true, matching hashes
+         *               are confirmed by a node-by-node comparison, ruling out collisions.
+         * @return True if the subtrees are equal.
+         * @throws std::logic_error if Merkle hashing is disabled.
+         */
+        bool subtree_equal(const Node<T>* a, const Node<T>* b, bool verify = false) const
+        {
+            return this->subtree_equal(a, *this, b, verify);
+        }
+
+
+        /**
+         * @brief Checks whether a subtree of this tree and a subtree of another tree hold the same values in the same shape.
+         * @param a The root of the subtree in this tree.
+         * @param other The tree holding the second subtree.
+         * @param b The root of the subtree in the other tree.
+         * @param verify When true, matching hashes are confirmed by a node-by-node comparison.
+         * @return True if the subtrees are equal.
+         * @throws std::logic_error if either tree does not maintain Merkle hashes.
+         */
+        bool subtree_equal(const Node<T>* a, const Tree<T, k>& other, const Node<T>* b, bool verify = false) const
+        {
+            if (!this->hashes || !other.hashes)
+            {
+                throw std::logic_error("Merkle hashing is not enabled for this tree.");
+            }
+            if (a == b) return true;
+            if (!a || !b || this->hashes->at(a) != other.hashes->at(b)) return false;
+            return !verify || sameStructure(a, b);
+        }
+
+
+        /**
+         * @brief Finds all nodes matching a predicate, skipping subtrees that cannot contain a match.
+         * @param matches Predicate on a value.
+         * @param mayContain Predicate on a subtree range (min, max); returns false when no value in that range can match.
+         *                   It is only consulted when the zone maps are enabled.
+         * @return The matching nodes in pre-order.
+         */
+        template <typename Predicate, typename RangeTest>
+        std::vector<Node<T>*> find_all_if(Predicate matches, RangeTest mayContain)
+        {
+            std::vector<Node<T>*> found;
+            std::vector<Node<T>*> pending;
+            if (this->root) pending.push_back(this->root);
+
+            while (!pending.empty())
+            {
+                Node<T>* node = pending.back();
+                pending.pop_back();
+
+                if (this->zones)
+                {
+                    const std::pair<T, T>& zone = this->zones->at(node);
+                    if (!mayContain(zone.first, zone.second)) continue;    // Nothing in this subtree can match
+                }
+                if (matches(node->get_value()))
+                {
+                    found.push_back(node);
+                }
+                const auto& children = node->get_children();
+                for (auto it = children.rbegin(); it != children.rend(); ++it)
+                {
+                    pending.push_back(*it);
+                }
+            }
+            return found;
+        }
+
+
+        /**
+         * @brief Finds all nodes matching a predicate (full scan, no pruning).
+         * @param matches Predicate on a value.
+         * @return The matching nodes in pre-order.
+         */
+        template <typename Predicate>
+        std::vector<Node<T>*> find_all_if(Predicate matches)
+        {
+            return this->find_all_if(matches, [](const T&, const T&) { return true; });
+        }
+
+
+        /**
+         * @brief Finds all nodes whose value is greater than x, pruning with the zone maps when enabled.
+         * @param x The threshold.
+         * @return The matching nodes in pre-order.
+         */
+        std::vector<Node<T>*> find_greater(const T& x)
+        {
+            return this->find_all_if([&x](const T& value) { return x < value; },
+                                     [&x](const T&, const T& max) { return x < max; });
+        }
+
+
+        /**
+         * @brief Finds all nodes whose value is less than x, pruning with the zone maps when enabled.
+         * @param x The threshold.
+         * @return The matching nodes in pre-order.
+         */
+        std::vector<Node<T>*> find_less(const T& x)
+        {
+            return this->find_all_if([&x](const T& value) { return value < x; },
+                                     [&x](const T& min, const T&) { return min < x; });
+        }
+
+
+        /**
+         * @brief Finds all nodes whose value lies in [lo, hi], in value order.
+         * O(log n + m) when the ordered index is enabled. Otherwise the tree is scanned (skipping subtrees
+         * outside [lo, hi] when the zone maps are enabled) and the matches are sorted.
+         * @param lo The lower bound (inclusive).
+         * @param hi The upper bound (inclusive).
+         * @return The matching nodes in value order.
+         */
+        std::vector<Node<T>*> find_range(const T& lo, const T& hi)
+        {
+            if (this->sortedIndex)
+            {
+                return this->sortedIndex->range(lo, hi);
+            }
+            std::vector<Node<T>*> matches = this->find_all_if(
+                [&lo, &hi](const T& value) { return !(value < lo) && !(hi < value); },
+                [&lo, &hi](const T& min, const T& max) { return !(max < lo) && !(hi < min); });
+            std::stable_sort(matches.begin(), matches.end(), [](const Node<T>* a, const Node<T>* b) { return a->get_value() < b->get_value(); });
+            return matches;
+        }
+
+
+        /**
+         * @brief Finds a node holding the given value.
+         * Expected O(1) when the value index is enabled, otherwise a BFS scan of the tree
+         * (skipping subtrees ruled out by the Bloom filters when they are enabled).
+         * @param value The value to look up.
+         * @return A node holding the value, or nullptr if there is none.
+         */
+        Node<T>* find(const T& value)
+        {
+            if constexpr (is_hashable_v<T>)
+            {
+                if (this->valueIndex) return this->valueIndex->find(value);
+            }
+            if (this->blooms)
+            {
+                std::vector<Node<T>*> match = this->searchPruned(this->root, value, true);
+                return match.empty() ? nullptr : match[0];
+            }
+            for (auto node = this->begin_bfs_scan(); node != this->end_bfs_scan(); ++node)
+            {
+                if (node->get_value() == value)
+                {
+                    return &*node;
+                }
+            }
+            return nullptr;
+        }
+
+
+        /**
+         * @brief Finds all nodes holding the given value.
+         * Uses the value index when enabled (in no particular order), otherwise a BFS scan (in BFS order),
+         * pruned by the Bloom filters when they are enabled.
+         * @param value The value to look up.
+         * @return The matching nodes.
+         */
+        std::vector<Node<T>*> find_all(const T& value)
         {
-            if (parent && parent->get_children().size() < k) 
+            if constexpr (is_hashable_v<T>)
+            {
+                if (this->valueIndex) return this->valueIndex->find_all(value);
+            }
+            if (this->blooms)
+            {
+                return this->searchPruned(this->root, value, false);
+            }
+            std::vector<Node<T>*> matches;
+            for (auto node = this->begin_bfs_scan(); node != this->end_bfs_scan(); ++node)
             {
-                    parent->get_children().push_back(child);
+                if (node->get_value() == value)
+                {
+                    matches.push_back(&*node);
+                }
             }
+            return matches;
+        }
+
+
+        /**
+         * @brief Retrieves the mutation version of the tree.
+         * @return A counter that changes whenever the tree structure is modified.
+         *
+         * Structures built from the tree (such as TreeIndex) record this value, so a stale
+         * snapshot can be detected by a single comparison instead of re-walking the tree.
+         */
+        unsigned long get_version() const
+        {
+            return this->version;
         }
 
         
         // Iterator access functions
+        // The overloads taking maxDepth stop descending below that depth, counted from the start node (depth 0).
+        // The *_from variants traverse only the subtree of a start node, which must belong to this tree,
+        // so subtree-local work costs O(subtree).
         PreOrderIterator<T> begin_pre_order() { return PreOrderIterator<T>(root); }
+        PreOrderIterator<T> begin_pre_order(size_t maxDepth) { return PreOrderIterator<T>(root, maxDepth); }
+        PreOrderIterator<T> begin_pre_order_from(Node<T>* start, size_t maxDepth = UNLIMITED_DEPTH) { return PreOrderIterator<T>(start, maxDepth); }
         PreOrderIterator<T> end_pre_order() { return PreOrderIterator<T>(nullptr); }
 
         PostOrderIterator<T> begin_post_order() { return PostOrderIterator<T>(root); }
+        PostOrderIterator<T> begin_post_order_from(Node<T>* start) { return PostOrderIterator<T>(start); }
         PostOrderIterator<T> end_post_order() { return PostOrderIterator<T>(nullptr); }
 
         InOrderIterator<T> begin_in_order() { return InOrderIterator<T>(root); }
+        InOrderIterator<T> begin_in_order_from(Node<T>* start) { return InOrderIterator<T>(start); }
         InOrderIterator<T> end_in_order() { return InOrderIterator<T>(nullptr); }
 
         BFSIterator<T> begin_bfs_scan() { return BFSIterator<T>(root); }
+        BFSIterator<T> begin_bfs_scan(size_t maxDepth) { return BFSIterator<T>(root, maxDepth); }
+        BFSIterator<T> begin_bfs_scan_from(Node<T>* start, size_t maxDepth = UNLIMITED_DEPTH) { return BFSIterator<T>(start, maxDepth); }
         BFSIterator<T> end_bfs_scan() { return BFSIterator<T>(nullptr); }
 
         BFSIterator<T> begin() {  return begin_bfs_scan(); }
         BFSIterator<T> end() {  return end_bfs_scan(); }
 
         DFSIterator<T> begin_dfs_scan() { return DFSIterator<T>(root); }
+        DFSIterator<T> begin_dfs_scan(size_t maxDepth) { return DFSIterator<T>(root, maxDepth); }
+        DFSIterator<T> begin_dfs_scan_from(Node<T>* start, size_t maxDepth = UNLIMITED_DEPTH) { return DFSIterator<T>(start, maxDepth); }
         DFSIterator<T> end_dfs_scan() { return DFSIterator<T>(nullptr); }
 
         HeapIterator<T> myHeap() { return HeapIterator<T>(root); }
+        HeapIterator<T> begin_heap_from(Node<T>* start) { return HeapIterator<T>(start); }
         HeapIterator<T> end_heap() { return HeapIterator<T>(nullptr); }
 
 
@@ -248,20 +1674,22 @@ class Tree {
     private:
 
         /**
-         * @brief Recursively destroys the tree, freeing all nodes.
-         * @param node The current node to destroy.
+         * @brief Destroys a subtree, freeing all its nodes.
+         * Nodes living in a bulk-allocated block are only unlinked here; they are destroyed when their block is released.
+         * The walk uses an explicit stack, so arbitrarily deep trees (such as long chains from build_from_parents) are safe.
+         * @param node The root of the subtree to destroy.
          */
         void destroyTree(Node<T>* node) 
         {
-            if (node) 
+            std::vector<Node<T>*> pending;
+            if (node) pending.push_back(node);
+            while (!pending.empty())
             {
-                // std::cout << "Destroying node with value: " << root->get_value() << std::endl; // For debugging
-                for (Node<T>* child : node->get_children()) 
-                {
-                    destroyTree(child);     // Recursively destroy child nodes
-                }
-                delete node;        // Delete the current node
-                node = nullptr;     // Clear the pointer after deletion
+                Node<T>* current = pending.back();
+                pending.pop_back();
+                // std::cout << "Destroying node with value: " << current->get_value() << std::endl; // For debugging
+                pending.insert(pending.end(), current->get_children().begin(), current->get_children().end());
+                this->freeNode(current);
             }
         }
 
@@ -0,0 +1,294 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef TREEINDEX_HPP
+#define TREEINDEX_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include <vector>
+#include <unordered_map>
+#include <stack>
+#include <utility>
+#include <tuple>
+#include <stdexcept>
+
+namespace ori {
+
+/**
+ * @class TreeIndex
+ * @brief Euler-tour index of a tree, built in a single depth-first pass.
+ *
+ * Every node gets an entry timestamp (its position in the flat tour array) and an exit timestamp
+ * (the position of the last node of its subtree). Because the tour lists nodes in pre-order,
+ * the subtree of a node occupies the contiguous range [entry, exit] of the tour, which makes
+ * ancestor tests O(1) and turns subtree-restricted scans into array slices.
+ *
+ * The index is a snapshot: it records the tree's version and can tell when the tree was
+ * modified after the index was built.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ */
+template <typename T>
+class TreeIndex {
+
+    public:
+
+        using const_iterator = typename std::vector<Node<T>*>::const_iterator;
+
+        static constexpr size_t npos = static_cast<size_t>(-1);     // Marks "no position", e.g. the parent of the root
+
+    private:
+
+        std::vector<Node<T>*> tour;                             // Flat Euler-tour array (nodes in pre-order)
+        std::vector<size_t> exitTime;                           // Exit timestamp for each tour position
+        std::vector<size_t> parentPosition;                     // Tour position of the parent of each tour position
+        std::vector<size_t> depths;                             // Depth of each tour position (the root has depth 0)
+        std::unordered_map<const Node<T>*, size_t> entryTime;   // Entry timestamp (tour position) of each node
+        const void* source;                                     // The tree the index was built from
+        unsigned long version;                                  // Tree version at the time of building
+
+
+        /**
+         * @brief Walks the tree from the given root and fills the tour and the timestamps.
+         * The walk is iterative, so very deep trees do not overflow the call stack.
+         * @param root The root node of the tree.
+         */
+        void build(Node<T>* root)
+        {
+            if (!root) return;
+
+            // Each stack entry holds a node, the tour position of its parent and a flag telling whether its subtree was already expanded
+            std::stack<std::tuple<Node<T>*, size_t, bool>> pending;
+            pending.push({root, npos, false});
+
+            while (!pending.empty())
+            {
+                auto [node, parent, expanded] = pending.top();
+                pending.pop();
+
+                // Second visit: the whole subtree has been written, so the last position is the exit time
+                if (expanded)
+                {
+                    this->exitTime[this->entryTime[node]] = this->tour.size() - 1;
+                    continue;
+                }
+
+                size_t position = this->tour.size();
+                this->entryTime[node] = position;
+                this->tour.push_back(node);
+                this->exitTime.push_back(0);
+                this->parentPosition.push_back(parent);
+                this->depths.push_back(parent == npos ? 0 : this->depths[parent] + 1);
+                pending.push({node, parent, true});
+
+                // Push the children in reverse order to visit the leftmost child first
+                const auto& children = node->get_children();
+                for (auto it = children.rbegin(); it != children.rend(); ++it)
+                {
+                    if (*it)
+                    {
+                        pending.push({*it, position, false});
+                    }
+                }
+            }
+        }
+
+    public:
+
+        /**
+         * @brief Builds the index from a tree.
+         * @param tree The tree to index.
+         */
+        template <int k>
+        TreeIndex(const Tree<T, k>& tree) : source(&tree), version(tree.get_version())
+        {
+            this->build(tree.root);
+        }
+
+
+        /**
+         * @brief Retrieves the number of indexed nodes.
+         * @return The number of nodes in the tour.
+         */
+        size_t size() const
+        {
+            return this->tour.size();
+        }
+
+
+        /**
+         * @brief Checks whether a node belongs to the indexed tree.
+         * @param node The node to look up.
+         * @return True if the node was indexed, false otherwise.
+         */
+        bool contains(const Node<T>* node) const
+        {
+            return this->entryTime.find(node) != this->entryTime.end();
+        }
+
+
+        /**
+         * @brief Retrieves the entry timestamp (tour position) of a node.
+         * @param node The node to look up.
+         * @return The position of the node in the tour.
+         * @throws std::invalid_argument if the node is not part of the index.
+         */
+        size_t entry(const Node<T>* node) const
+        {
+            auto it = this->entryTime.find(node);
+            if (it == this->entryTime.end())
+            {
+                throw std::invalid_argument("TreeIndex: node is not part of the indexed tree.");
+            }
+            return it->second;
+        }
+
+
+        /**
+         * @brief Retrieves the exit timestamp of a node, i.e. the tour position of the last node in its subtree.
+         * @param node The node to look up.
+         * @return The exit timestamp of the node.
+         */
+        size_t exit(const Node<T>* node) const
+        {
+            return this->exitTime[this->entry(node)];
+        }
+
+
+        /**
+         * @brief Retrieves the node stored at a tour position.
+         * @param position Position in the tour.
+         * @return Pointer to the node at that position.
+         */
+        Node<T>* at(size_t position) const
+        {
+            return this->tour[position];
+        }
+
+
+        /**
+         * @brief Retrieves the exit timestamp stored for a tour position.
+         * @param position Position in the tour.
+         * @return The tour position of the last node in the subtree rooted at `position`.
+         */
+        size_t exit_at(size_t position) const
+        {
+            return this->exitTime[position];
+        }
+
+
+        /**
+         * @brief Retrieves the tour position of the parent of a tour position.
+         * @param position Position in the tour.
+         * @return The parent's position, or npos for the root.
+         */
+        size_t parent_at(size_t position) const
+        {
+            return this->parentPosition[position];
+        }
+
+
+        /**
+         * @brief Retrieves the depth of a tour position.
+         * @param position Position in the tour.
+         * @return The number of edges between the root and the node at `position`.
+         */
+        size_t depth_at(size_t position) const
+        {
+            return this->depths[position];
+        }
+
+
+        /**
+         * @brief Checks in O(1) whether the node at one tour position is an ancestor of the node at another.
+         * @param ancestor Tour position of the candidate ancestor.
+         * @param descendant Tour position of the candidate descendant.
+         * @return True if the subtree of `ancestor` contains `descendant`.
+         */
+        bool is_ancestor_at(size_t ancestor, size_t descendant) const
+        {
+            return ancestor <= descendant && descendant <= this->exitTime[ancestor];
+        }
+
+
+        /**
+         * @brief Checks in O(1) whether one node is an ancestor of another.
+         * A node is considered an ancestor of itself.
+         * @param ancestor The candidate ancestor.
+         * @param descendant The candidate descendant.
+         * @return True if the subtree of `ancestor` contains `descendant`.
+         */
+        bool is_ancestor(const Node<T>* ancestor, const Node<T>* descendant) const
+        {
+            return this->is_ancestor_at(this->entry(ancestor), this->entry(descendant));
+        }
+
+
+        /**
+         * @brief Retrieves the contiguous tour range covered by the subtree of a node.
+         * @param node The root of the subtree.
+         * @return A pair [first, last) of tour positions.
+         */
+        std::pair<size_t, size_t> subtree_range(const Node<T>* node) const
+        {
+            size_t first = this->entry(node);
+            return {first, this->exitTime[first] + 1};
+        }
+
+
+        /**
+         * @brief Retrieves the number of nodes in the subtree of a node (including itself).
+         * @param node The root of the subtree.
+         * @return The subtree size.
+         */
+        size_t subtree_size(const Node<T>* node) const
+        {
+            size_t first = this->entry(node);
+            return this->exitTime[first] + 1 - first;
+        }
+
+
+        /**
+         * @brief Iterators over the slice of the tour that holds the subtree of a node, in pre-order.
+         * @param node The root of the subtree.
+         */
+        const_iterator subtree_begin(const Node<T>* node) const
+        {
+            return this->tour.begin() + static_cast<std::ptrdiff_t>(this->entry(node));
+        }
+
+        const_iterator subtree_end(const Node<T>* node) const
+        {
+            return this->tour.begin() + static_cast<std::ptrdiff_t>(this->exit(node) + 1);
+        }
+
+
+        // Iterators over the whole tour
+        const_iterator begin() const { return this->tour.begin(); }
+        const_iterator end() const { return this->tour.end(); }
+
+
+        /**
+         * @brief Retrieves the tree version recorded when the index was built.
+         * @return The recorded version.
+         */
+        unsigned long get_version() const
+        {
+            return this->version;
+        }
+
+
+        /**
+         * @brief Checks whether the index no longer reflects the given tree.
+         * @param tree The tree to compare against.
+         * @return True if the index was built from another tree or the tree was modified since.
+         */
+        template <int k>
+        bool is_stale(const Tree<T, k>& tree) const
+        {
+            return this->source != &tree || this->version != tree.get_version();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,638 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef TREEJOURNAL_HPP
+#define TREEJOURNAL_HPP
+
+#include "node.hpp"
+#include "tree.hpp"
+#include "diff.hpp"
+#include "serialization.hpp"
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ori {
+
+    /**
+     * @struct JournalStats
+     * @brief I/O counters of a TreeJournal, for tuning the group size and the compaction threshold.
+     */
+    struct JournalStats
+    {
+        size_t records = 0;         // Mutations logged
+        size_t recordBytes = 0;     // Bytes of logged records, framing included
+        size_t commits = 0;         // Group commits: one write and one fdatasync each
+        size_t compactions = 0;     // Snapshots written
+        size_t replayed = 0;        // Records applied when the journal was opened
+    };
+
+
+/**
+ * @class TreeJournal
+ * @brief Write-ahead log of the mutations of a Tree, with group commit, replay on open and compaction into snapshots.
+ *
+ * The journal keeps two files next to each other: `<path>.snapshot`, a full copy of the tree in the
+ * binary format (see write_tree), and `<path>.journal`, an append-only list of the mutations made
+ * since that snapshot. Mutations go through the journal, which applies them to the tree and logs
+ * them as TreeEdit records (the edits of diff_trees, addressed by child positions from the root).
+ * Records are framed like the blocks of compressed files: payload length, CRC-32, payload.
+ *
+ * Logged records are buffered and become durable at the next commit, which hands the whole group
+ * to the file with one write and one fdatasync. A commit happens every `groupSize` records, on
+ * commit() and in the destructor, so persistence costs one sync per group and bytes proportional
+ * to the changes. When the journal grows past `compactBytes` the tree is written as a new snapshot
+ * and the journal starts over. A commit that fails truncates the file back to its last committed
+ * end and keeps the group pending, so it can be retried without duplicating records. Mutators change
+ * the tree before they commit, so when a mutator throws from its commit the change is made and pending.
+ *
+ * Opening loads the snapshot (an empty tree if there is none) and replays the journal. A record
+ * cut short or failing its checksum marks the end of the durable part, left by a crash during a
+ * write, and the file is truncated there. Both files carry a generation number that a compaction
+ * increments; a journal older than the snapshot was already folded into it and is discarded, so a
+ * crash at any point of a compaction is recovered correctly.
+ *
+ * Records address nodes by their path from the root, so the journal enables the parent links of
+ * the tree (see Tree::enable_parent_links), which must stay enabled while it is in use. Mutations
+ * made on the tree directly bypass the journal and break replay; a TreeJournal must not be used
+ * from several threads at once.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes (int, double, std::string or Complex).
+ * @tparam k Maximum number of children each node can have.
+ */
+template <typename T, int k = 2>
+class TreeJournal {
+
+    private:
+
+        static constexpr char SNAPSHOT_MAGIC[5] = "ORTS";   // Snapshot files: magic, generation (8), then the tree
+        static constexpr char JOURNAL_MAGIC[5] = "ORTJ";    // Journal files: magic, version (2), value tag (1), 0 (1), generation (8)
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t JOURNAL_HEADER = 16;
+
+        Tree<T, k>& tree;                       // The journaled tree
+        std::string snapshotPath;               // Path of the snapshot file
+        std::string journalPath;                // Path of the journal file
+        int fd = -1;                            // The journal, open for appending
+        uint64_t generation = 0;                // Generation of the current snapshot and journal
+        uint64_t journalSize = 0;               // Bytes in the journal file
+        size_t groupSize;                       // Records per group commit
+        uint64_t compactBytes;                  // Journal size that triggers a compaction
+        std::vector<unsigned char> pending;     // Records not yet handed to the file
+        size_t pendingRecords = 0;              // Number of records in `pending`
+        bool broken = false;                    // A failed commit could not be rolled back, so no more commits are made
+        JournalStats counters;                  // I/O counters
+
+
+        /**
+         * @brief Writes a whole buffer to a descriptor.
+         * @throws std::runtime_error if the write fails.
+         */
+        static void writeAll(int descriptor, const unsigned char* data, size_t size, const std::string& path)
+        {
+            while (size > 0)
+            {
+                ssize_t n = ::write(descriptor, data, size);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) throw std::runtime_error("TreeJournal: cannot write " + path + ".");
+                data += n;
+                size -= static_cast<size_t>(n);
+            }
+        }
+
+
+        /**
+         * @brief Makes a rename or a file creation in the directory of a path durable.
+         */
+        static void syncDirectory(const std::string& path)
+        {
+            size_t slash = path.find_last_of('/');
+            std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+            int dir = ::open(directory.c_str(), O_RDONLY);
+            if (dir < 0) throw std::runtime_error("TreeJournal: cannot open the directory " + directory + ".");
+            int result = ::fsync(dir);
+            ::close(dir);
+            if (result != 0) throw std::runtime_error("TreeJournal: cannot sync the directory " + directory + ".");
+        }
+
+
+        /**
+         * @brief Reads a whole file.
+         * @return False if the file does not exist.
+         * @throws std::runtime_error if it exists but cannot be read.
+         */
+        static bool readFile(const std::string& path, std::vector<unsigned char>& bytes)
+        {
+            int file = ::open(path.c_str(), O_RDONLY);
+            if (file < 0)
+            {
+                if (errno == ENOENT) return false;
+                throw std::runtime_error("TreeJournal: cannot open " + path + ".");
+            }
+            bytes.clear();
+            unsigned char chunk[1 << 16];
+            for (;;)
+            {
+                ssize_t n = ::read(file, chunk, sizeof(chunk));
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0)
+                {
+                    ::close(file);
+                    throw std::runtime_error("TreeJournal: cannot read " + path + ".");
+                }
+                if (n == 0) break;
+                bytes.insert(bytes.end(), chunk, chunk + n);
+            }
+            ::close(file);
+            return true;
+        }
+
+
+        /**
+         * @brief Creates a fresh journal holding only its header, atomically replacing any previous one.
+         */
+        void startJournal()
+        {
+            unsigned char header[JOURNAL_HEADER] = {};
+            std::copy(JOURNAL_MAGIC, JOURNAL_MAGIC + 4, header);
+            store_uint(header + 4, VERSION, 2);
+            header[6] = ValueCodec<T>::tag;
+            store_uint(header + 8, this->generation, 8);
+
+            std::string temporary = this->journalPath + ".tmp";
+            int file = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (file < 0) throw std::runtime_error("TreeJournal: cannot create " + temporary + ".");
+            try
+            {
+                writeAll(file, header, sizeof(header), temporary);
+                if (::fsync(file) != 0) throw std::runtime_error("TreeJournal: cannot sync " + temporary + ".");
+            }
+            catch (...)
+            {
+                ::close(file);
+                throw;
+            }
+            ::close(file);
+            if (::rename(temporary.c_str(), this->journalPath.c_str()) != 0)
+            {
+                throw std::runtime_error("TreeJournal: cannot replace " + this->journalPath + ".");
+            }
+            syncDirectory(this->journalPath);
+            this->openJournal(JOURNAL_HEADER);
+        }
+
+
+        /**
+         * @brief Opens the journal for appending after its first `size` bytes, dropping anything beyond them.
+         */
+        void openJournal(uint64_t size)
+        {
+            if (this->fd >= 0) ::close(this->fd);
+            this->fd = ::open(this->journalPath.c_str(), O_WRONLY);
+            if (this->fd < 0) throw std::runtime_error("TreeJournal: cannot open " + this->journalPath + ".");
+            if (::ftruncate(this->fd, static_cast<off_t>(size)) != 0 || ::lseek(this->fd, static_cast<off_t>(size), SEEK_SET) < 0)
+            {
+                throw std::runtime_error("TreeJournal: cannot truncate " + this->journalPath + ".");
+            }
+            this->journalSize = size;
+        }
+
+
+        /**
+         * @brief Loads the snapshot into the tree, or empties the tree when there is none.
+         */
+        void loadSnapshot()
+        {
+            int file = ::open(this->snapshotPath.c_str(), O_RDONLY);
+            if (file < 0)
+            {
+                if (errno != ENOENT) throw std::runtime_error("TreeJournal: cannot open " + this->snapshotPath + ".");
+                this->tree.clear();
+                this->generation = 0;
+                return;
+            }
+            try
+            {
+                BinaryReader in(file);
+                char magic[4];
+                in.read(magic, 4);
+                if (!std::equal(magic, magic + 4, SNAPSHOT_MAGIC))
+                {
+                    throw std::runtime_error("TreeJournal: " + this->snapshotPath + " is not a tree snapshot.");
+                }
+                this->generation = in.get_uint(8);
+                read_tree(this->tree, in);
+            }
+            catch (...)
+            {
+                ::close(file);
+                throw;
+            }
+            ::close(file);
+        }
+
+
+        /**
+         * @brief Applies the durable records of the journal and truncates a torn tail.
+         */
+        void replayJournal()
+        {
+            std::vector<unsigned char> bytes;
+            if (!readFile(this->journalPath, bytes))
+            {
+                this->startJournal();
+                return;
+            }
+            if (bytes.size() < JOURNAL_HEADER || !std::equal(bytes.begin(), bytes.begin() + 4, JOURNAL_MAGIC)
+                || load_uint(bytes.data() + 4, 2) != VERSION || bytes[6] != ValueCodec<T>::tag)
+            {
+                throw std::runtime_error("TreeJournal: " + this->journalPath + " is not a journal of this value type.");
+            }
+            uint64_t journalGeneration = load_uint(bytes.data() + 8, 8);
+            if (journalGeneration > this->generation)
+            {
+                throw std::runtime_error("TreeJournal: " + this->journalPath + " is newer than its snapshot.");
+            }
+            if (journalGeneration < this->generation)
+            {
+                this->startJournal();       // Left by a compaction interrupted after the snapshot was replaced
+                return;
+            }
+
+            size_t offset = JOURNAL_HEADER;
+            while (bytes.size() - offset >= 8)
+            {
+                size_t size = static_cast<size_t>(load_uint(bytes.data() + offset, 4));
+                uint32_t checksum = static_cast<uint32_t>(load_uint(bytes.data() + offset + 4, 4));
+                if (size > bytes.size() - offset - 8) break;
+                const unsigned char* payload = bytes.data() + offset + 8;
+                if (crc32(payload, size) != checksum) break;
+
+                EditScript<T> script{decodeEdit(payload, payload + size)};
+                try
+                {
+                    apply_patch(this->tree, script);
+                }
+                catch (const std::invalid_argument&)
+                {
+                    throw std::runtime_error("TreeJournal: record " + std::to_string(this->counters.replayed) + " of "
+                                             + this->journalPath + " does not fit the tree.");
+                }
+                ++this->counters.replayed;
+                offset += 8 + size;
+            }
+            this->openJournal(offset);
+        }
+
+
+        /**
+         * @brief Encodes an edit: kind (1 byte), path length and positions, value count, child counts and the values (see ValueCompressor).
+         */
+        static void encodeEdit(const TreeEdit<T>& edit, std::vector<unsigned char>& out)
+        {
+            out.push_back(static_cast<unsigned char>(edit.kind));
+            put_varint(out, edit.path.size());
+            for (size_t position : edit.path) put_varint(out, position);
+            put_varint(out, edit.values.size());
+            for (size_t count : edit.childCounts) put_varint(out, count);
+            ValueCompressor<T>::encode(edit.values, out);
+        }
+
+
+        /**
+         * @brief Decodes an edit written by encodeEdit.
+         * @throws std::runtime_error if the payload is malformed.
+         */
+        static TreeEdit<T> decodeEdit(const unsigned char* cursor, const unsigned char* end)
+        {
+            if (cursor == end || *cursor > static_cast<unsigned char>(TreeEdit<T>::Kind::Remove))
+            {
+                throw std::runtime_error("TreeJournal: malformed record.");
+            }
+            TreeEdit<T> edit{static_cast<typename TreeEdit<T>::Kind>(*cursor++), {}, {}, {}};
+            uint64_t depth = get_varint(cursor, end);
+            if (depth > static_cast<uint64_t>(end - cursor)) throw std::runtime_error("TreeJournal: malformed record.");
+            for (uint64_t i = 0; i < depth; ++i) edit.path.push_back(static_cast<size_t>(get_varint(cursor, end)));
+            uint64_t values = get_varint(cursor, end);
+            if (values > static_cast<uint64_t>(end - cursor)) throw std::runtime_error("TreeJournal: malformed record.");
+            if (edit.kind == TreeEdit<T>::Kind::Insert)
+            {
+                for (uint64_t i = 0; i < values; ++i) edit.childCounts.push_back(static_cast<size_t>(get_varint(cursor, end)));
+            }
+            ValueCompressor<T>::decode(cursor, end, static_cast<size_t>(values), edit.values);
+            return edit;
+        }
+
+
+        /**
+         * @brief Retrieves the child positions leading from the root to a node of the tree.
+         * @throws std::invalid_argument if the node is not in the tree.
+         */
+        std::vector<size_t> pathOf(const Node<T>* node) const
+        {
+            std::vector<size_t> path;
+            while (node && node != this->tree.root)
+            {
+                const Node<T>* parent = this->tree.get_parent(node);
+                if (!parent) break;
+                const std::vector<Node<T>*>& siblings = parent->get_children();
+                path.push_back(static_cast<size_t>(std::find(siblings.begin(), siblings.end(), node) - siblings.begin()));
+                node = parent;
+            }
+            if (!node || node != this->tree.root) throw std::invalid_argument("TreeJournal: the node is not in the journaled tree.");
+            std::reverse(path.begin(), path.end());
+            return path;
+        }
+
+
+        /**
+         * @brief Buffers one record; the mutators call commitIfFull() once the tree reflects it.
+         */
+        void log(const TreeEdit<T>& edit)
+        {
+            size_t start = this->pending.size();
+            this->pending.resize(start + 8);
+            encodeEdit(edit, this->pending);
+            size_t size = this->pending.size() - start - 8;
+            store_uint(this->pending.data() + start, size, 4);
+            store_uint(this->pending.data() + start + 4, crc32(this->pending.data() + start + 8, size), 4);
+
+            ++this->counters.records;
+            this->counters.recordBytes += size + 8;
+            ++this->pendingRecords;
+        }
+
+
+        /**
+         * @brief Commits the group when it is full. Called after the mutation, so a failed commit
+         * leaves the tree and the pending records in agreement.
+         */
+        void commitIfFull()
+        {
+            if (this->pendingRecords >= this->groupSize) this->commit();
+        }
+
+
+        /**
+         * @brief Hands the pending group to the file with one write and one fdatasync, without compacting.
+         * On failure the file is truncated back to its committed end and the group stays pending.
+         * @throws std::runtime_error if writing or syncing fails, or an earlier rollback failed.
+         */
+        void commitGroup()
+        {
+            if (this->broken)
+            {
+                throw std::runtime_error("TreeJournal: " + this->journalPath + " could not be rolled back after a failed commit.");
+            }
+            if (this->pendingRecords == 0) return;
+            try
+            {
+                writeAll(this->fd, this->pending.data(), this->pending.size(), this->journalPath);
+                if (::fdatasync(this->fd) != 0) throw std::runtime_error("TreeJournal: cannot sync " + this->journalPath + ".");
+            }
+            catch (...)
+            {
+                // Part of the group may be in the file: drop it, so a retry writes the group exactly once
+                if (::ftruncate(this->fd, static_cast<off_t>(this->journalSize)) != 0
+                    || ::lseek(this->fd, static_cast<off_t>(this->journalSize), SEEK_SET) < 0)
+                {
+                    this->broken = true;
+                }
+                throw;
+            }
+            this->journalSize += this->pending.size();
+            this->pending.clear();
+            this->pendingRecords = 0;
+            ++this->counters.commits;
+        }
+
+    public:
+
+        /**
+         * @brief Opens (or creates) the journal of a tree and recovers the tree from it.
+         * The tree is replaced by the snapshot with the journal replayed on top, or emptied when neither file exists.
+         * @param journaled The tree to recover and to mutate through the journal; it must outlive the journal.
+         * @param path Common path of the two files, without the ".snapshot" and ".journal" suffixes.
+         * @param groupRecords Records per group commit (1 makes every mutation durable on its own).
+         * @param compactThreshold Journal size in bytes beyond which a commit also writes a new snapshot.
+         * @throws std::invalid_argument if groupRecords is 0.
+         * @throws std::runtime_error if the files cannot be read or written, or do not hold this kind of tree.
+         */
+        TreeJournal(Tree<T, k>& journaled, const std::string& path, size_t groupRecords = 64, uint64_t compactThreshold = 64 << 20)
+            : tree(journaled), snapshotPath(path + ".snapshot"), journalPath(path + ".journal"),
+              groupSize(groupRecords), compactBytes(compactThreshold)
+        {
+            if (groupRecords == 0) throw std::invalid_argument("TreeJournal: the group size must be at least 1.");
+            this->tree.enable_parent_links();
+            this->loadSnapshot();
+            this->replayJournal();
+        }
+
+
+        TreeJournal(const TreeJournal&) = delete;
+        TreeJournal& operator=(const TreeJournal&) = delete;
+
+
+        /**
+         * @brief Destructor that commits the pending records and closes the journal. Errors are ignored here; call commit() to see them.
+         */
+        ~TreeJournal()
+        {
+            try
+            {
+                this->commit();
+            }
+            catch (const std::runtime_error&)
+            {
+            }
+            if (this->fd >= 0) ::close(this->fd);
+        }
+
+
+        /**
+         * @brief Replaces the root (and the whole tree) with a node and its subtree, like Tree::add_root.
+         * @param node The new root, or nullptr to empty the tree.
+         */
+        void add_root(Node<T>* node)
+        {
+            bool replaced = this->tree.root != nullptr;
+            std::vector<TreeEdit<T>> edits;
+            if (node) edits.push_back(insert_edit<T>({}, node));
+            this->tree.add_root(node);
+            if (replaced) this->log({TreeEdit<T>::Kind::Remove, {}, {}, {}});
+            for (const TreeEdit<T>& edit : edits) this->log(edit);
+            this->commitIfFull();
+        }
+
+
+        /**
+         * @brief Adds a node (with its subtree) as the last child of a parent, like Tree::add_sub_node.
+         * Nothing is logged when the parent is full, since the tree ignores the insertion then.
+         * @param parent A node of the tree.
+         * @param child The node to add.
+         * @throws std::invalid_argument if the parent is not in the tree.
+         */
+        void add_sub_node(Node<T>* parent, Node<T>* child)
+        {
+            if (!parent || !child || parent->get_children().size() >= static_cast<size_t>(k)) return;
+            std::vector<size_t> path = this->pathOf(parent);
+            path.push_back(parent->get_children().size());
+            TreeEdit<T> edit = insert_edit<T>(path, child);
+            this->tree.add_sub_node(parent, child);
+            this->log(edit);
+            this->commitIfFull();
+        }
+
+
+        /**
+         * @brief Replaces the value of a node, like Tree::set_value.
+         * @throws std::invalid_argument if the node is not in the tree.
+         */
+        void set_value(Node<T>* node, const T& value)
+        {
+            if (!node) return;
+            std::vector<size_t> path = this->pathOf(node);
+            this->tree.set_value(node, value);
+            this->log({TreeEdit<T>::Kind::Change, std::move(path), {value}, {}});
+            this->commitIfFull();
+        }
+
+
+        /**
+         * @brief Removes a child of a node together with its subtree, like Tree::remove_sub_node.
+         * @throws std::out_of_range if the parent has no child at that position.
+         * @throws std::invalid_argument if the parent is not in the tree.
+         */
+        void remove_sub_node(Node<T>* parent, size_t index)
+        {
+            if (!parent || index >= parent->get_children().size())
+            {
+                throw std::out_of_range("remove_sub_node: the parent has no child at this position.");
+            }
+            std::vector<size_t> path = this->pathOf(parent);
+            path.push_back(index);
+            this->tree.remove_sub_node(parent, index);
+            this->log({TreeEdit<T>::Kind::Remove, std::move(path), {}, {}});
+            this->commitIfFull();
+        }
+
+
+        /**
+         * @brief Empties the tree, like Tree::clear.
+         */
+        void clear()
+        {
+            if (!this->tree.root) return;
+            this->tree.clear();
+            this->log({TreeEdit<T>::Kind::Remove, {}, {}, {}});
+            this->commitIfFull();
+        }
+
+
+        /**
+         * @brief Makes every logged mutation durable: one write and one fdatasync for the whole group.
+         * Compacts afterwards when the journal has grown past the threshold.
+         * On failure the file is truncated back to its committed end and the group stays pending, so
+         * commit() may be retried; if even the truncation fails, every later commit throws.
+         * @throws std::runtime_error if writing or syncing fails.
+         */
+        void commit()
+        {
+            this->commitGroup();
+            if (this->journalSize > this->compactBytes) this->compact();
+        }
+
+
+        /**
+         * @brief Writes the whole tree as a new snapshot and starts an empty journal.
+         * The snapshot is written to a temporary file, synced and renamed over the old one; only then
+         * is the journal replaced, and the generation numbers tell a stale journal apart after a crash.
+         * @throws std::runtime_error if writing fails; the previous snapshot and journal stay valid.
+         */
+        void compact()
+        {
+            this->commitGroup();
+
+            std::string temporary = this->snapshotPath + ".tmp";
+            int file = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (file < 0) throw std::runtime_error("TreeJournal: cannot create " + temporary + ".");
+            try
+            {
+                BinaryWriter out(file);
+                out.write(SNAPSHOT_MAGIC, 4);
+                out.put_uint(this->generation + 1, 8);
+                write_tree(this->tree, out);
+                if (::fsync(file) != 0) throw std::runtime_error("TreeJournal: cannot sync " + temporary + ".");
+            }
+            catch (...)
+            {
+                ::close(file);
+                throw;
+            }
+            ::close(file);
+            if (::rename(temporary.c_str(), this->snapshotPath.c_str()) != 0)
+            {
+                throw std::runtime_error("TreeJournal: cannot replace " + this->snapshotPath + ".");
+            }
+            syncDirectory(this->snapshotPath);
+
+            ++this->generation;
+            ++this->counters.compactions;
+            this->startJournal();
+        }
+
+
+        /**
+         * @brief Retrieves the journaled tree.
+         */
+        const Tree<T, k>& get_tree() const
+        {
+            return this->tree;
+        }
+
+
+        /**
+         * @brief Retrieves the generation of the current snapshot (0 before the first compaction).
+         */
+        uint64_t get_generation() const
+        {
+            return this->generation;
+        }
+
+
+        /**
+         * @brief Retrieves the size of the journal file in bytes, records not yet committed excluded.
+         */
+        uint64_t journal_size() const
+        {
+            return this->journalSize;
+        }
+
+
+        /**
+         * @brief Retrieves the number of logged records not yet committed.
+         */
+        size_t pending_records() const
+        {
+            return this->pendingRecords;
+        }
+
+
+        /**
+         * @brief Retrieves the I/O counters.
+         */
+        const JournalStats& stats() const
+        {
+            return this->counters;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,203 @@
+// Email: origoldbsc@gmail.com
+
+#ifndef VALUEINDEX_HPP
+#define VALUEINDEX_HPP
+
+#include "node.hpp"
+#include "hashing.hpp"
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+namespace ori {
+
+/**
+ * @class ValueIndex
+ * @brief Open-addressing hash index from node values to nodes, with expected O(1) lookups.
+ *
+ * Every node is stored in its own slot, so duplicate values are supported: all nodes holding a
+ * value are found along the same linear probe sequence. Erased slots become tombstones, and the
+ * table is rebuilt when live entries plus tombstones exceed half of the capacity.
+ *
+ * @tparam T The data type of the elements stored in the tree nodes.
+ * @tparam Hash Stateless hash functor for T (std::hash<T> by default). It is only constructed when
+ *         values are hashed, so the index can be declared for any T.
+ */
+template <typename T, typename Hash = std::hash<T>>
+class ValueIndex {
+
+    private:
+
+        /**
+         * @struct Slot
+         * @brief One entry of the table: the cached hash of the value and the node holding it.
+         * An empty slot has no node and is not a tombstone.
+         */
+        struct Slot
+        {
+            size_t hash = 0;
+            Node<T>* node = nullptr;
+            bool tombstone = false;
+        };
+
+        std::vector<Slot> slots;    // The table, its size is always a power of two
+        size_t live = 0;            // Number of stored nodes
+        size_t used = 0;            // Number of non-empty slots (live nodes and tombstones)
+
+
+        /**
+         * @brief Hashes a value and scrambles the bits, since std::hash is the identity for integers
+         * and consecutive keys would otherwise form long probe runs.
+         */
+        size_t hashOf(const T& value) const
+        {
+            return static_cast<size_t>(mix_hash(static_cast<uint64_t>(Hash()(value))));
+        }
+
+
+        /**
+         * @brief Rebuilds the table with the given capacity, dropping the tombstones.
+         * @param capacity The new capacity, a power of two.
+         */
+        void rehash(size_t capacity)
+        {
+            std::vector<Slot> old;
+            old.swap(this->slots);
+            this->slots.assign(capacity, Slot());
+            this->used = this->live;
+
+            size_t mask = capacity - 1;
+            for (const Slot& slot : old)
+            {
+                if (slot.node)
+                {
+                    size_t i = slot.hash & mask;
+                    while (this->slots[i].node)
+                    {
+                        i = (i + 1) & mask;
+                    }
+                    this->slots[i] = slot;
+                }
+            }
+        }
+
+    public:
+
+        /**
+         * @brief Constructs an empty index.
+         */
+        ValueIndex() : slots(16) {}
+
+
+        /**
+         * @brief Retrieves the number of indexed nodes.
+         */
+        size_t size() const
+        {
+            return this->live;
+        }
+
+
+        /**
+         * @brief Removes all entries.
+         */
+        void clear()
+        {
+            this->slots.assign(16, Slot());
+            this->live = 0;
+            this->used = 0;
+        }
+
+
+        /**
+         * @brief Adds a node to the index under its current value.
+         * @param node The node to add.
+         */
+        void insert(Node<T>* node)
+        {
+            // Keep the load (including tombstones) at most one half
+            if (2 * (this->used + 1) > this->slots.size())
+            {
+                this->rehash(2 * (this->live + 1) > this->slots.size() / 2 ? 2 * this->slots.size() : this->slots.size());
+            }
+
+            size_t h = this->hashOf(node->get_value());
+            size_t mask = this->slots.size() - 1;
+            size_t i = h & mask;
+            while (this->slots[i].node || this->slots[i].tombstone)
+            {
+                i = (i + 1) & mask;
+            }
+            this->slots[i] = Slot{h, node, false};
+            ++this->live;
+            ++this->used;
+        }
+
+
+        /**
+         * @brief Removes a node from the index. The node's value must not have changed since it was inserted.
+         * @param node The node to remove.
+         * @return True if the node was found and removed.
+         */
+        bool erase(const Node<T>* node)
+        {
+            size_t mask = this->slots.size() - 1;
+            for (size_t i = this->hashOf(node->get_value()) & mask; this->slots[i].node || this->slots[i].tombstone; i = (i + 1) & mask)
+            {
+                if (this->slots[i].node == node)
+                {
+                    this->slots[i].node = nullptr;
+                    this->slots[i].tombstone = true;
+                    --this->live;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+
+        /**
+         * @brief Finds one node holding a value.
+         * @param value The value to look up.
+         * @return A node holding the value, or nullptr if there is none.
+         */
+        Node<T>* find(const T& value) const
+        {
+            size_t h = this->hashOf(value);
+            size_t mask = this->slots.size() - 1;
+            for (size_t i = h & mask; this->slots[i].node || this->slots[i].tombstone; i = (i + 1) & mask)
+            {
+                const Slot& slot = this->slots[i];
+                if (slot.node && slot.hash == h && slot.node->get_value() == value)
+                {
+                    return slot.node;
+                }
+            }
+            return nullptr;
+        }
+
+
+        /**
+         * @brief Finds all nodes holding a value.
+         * @param value The value to look up.
+         * @return The matching nodes, in no particular order.
+         */
+        std::vector<Node<T>*> find_all(const T& value) const
+        {
+            std::vector<Node<T>*> matches;
+            size_t h = this->hashOf(value);
+            size_t mask = this->slots.size() - 1;
+            for (size_t i = h & mask; this->slots[i].node || this->slots[i].tombstone; i = (i + 1) & mask)
+            {
+                const Slot& slot = this->slots[i];
+                if (slot.node && slot.hash == h && slot.node->get_value() == value)
+                {
+                    matches.push_back(slot.node);
+                }
+            }
+            return matches;
+        }
+    };
+}
+
+#endif